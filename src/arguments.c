@@ -1,7 +1,9 @@
 #include "arguments.h"
 #include "bot.h"
+#include "endgame.h"
 #include "utils.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -14,6 +16,12 @@ void init_arguments(Arguments* self) {
   self->board_gen_width = 0;
   self->board_gen_height = 0;
   self->board_gen_type = GENERATE_ARG_NONE;
+  self->book_file = NULL;
+  self->book_board_files = NULL;
+  self->book_board_files_count = 0;
+  self->book_players = 0;
+  self->seed = 0;
+  self->has_seed = false;
   init_bot_parameters(&self->bot);
 }
 
@@ -22,10 +30,15 @@ void print_usage(const char* prog_name) {
   fprintf(stderr, "%s help\n", prog_name);
   fprintf(stderr, "%s version\n", prog_name);
 #ifdef AUTONOMOUS_MODE
-  fprintf(stderr, "%s phase=placement penguins=N inputboard.txt outpuboard.txt\n", prog_name);
-  fprintf(stderr, "%s phase=movement board.txt board.txt\n", prog_name);
-  fprintf(stderr, "%s generate <island|random> <WIDTH> <HEIGHT> board.txt\n", prog_name);
+  fprintf(
+    stderr,
+    "%s phase=placement penguins=N [book=FILE] [seed=N] inputboard.txt outpuboard.txt\n",
+    prog_name
+  );
+  fprintf(stderr, "%s phase=movement [seed=N] board.txt board.txt\n", prog_name);
+  fprintf(stderr, "%s generate <island|random> <WIDTH> <HEIGHT> [seed=N] board.txt\n", prog_name);
   fprintf(stderr, "%s view board.txt\n", prog_name);
+  fprintf(stderr, "%s book players=N penguins=N book.bin board.txt...\n", prog_name);
   fprintf(stderr, "%s name\n", prog_name);
 #endif
 #ifdef INTERACTIVE_MODE
@@ -33,6 +46,130 @@ void print_usage(const char* prog_name) {
 #endif
 }
 
+/// @brief Parses a single @c bot-* option into @c bot, shared by the
+/// simulator (see #run_simulation) which configures several bots at once.
+/// @returns @c false if @c arg isn't a bot option. On an invalid value an
+/// error is printed and @c ok is cleared.
+bool parse_bot_argument(BotParameters* bot, const char* arg, bool* ok) {
+  const char* arg_value = arg;
+  long num = 0;
+  if ((arg_value = strip_prefix(arg, "bot-placement="))) {
+    if (strcmp(arg_value, "smart") == 0) {
+      bot->placement_strategy = BOT_PLACEMENT_SMART;
+    } else if (strcmp(arg_value, "random") == 0) {
+      bot->placement_strategy = BOT_PLACEMENT_RANDOM;
+    } else if (strcmp(arg_value, "first") == 0) {
+      bot->placement_strategy = BOT_PLACEMENT_FIRST_POSSIBLE;
+    } else if (strcmp(arg_value, "fish") == 0) {
+      bot->placement_strategy = BOT_PLACEMENT_MOST_FISH;
+    } else {
+      *ok = false;
+      fprintf(stderr, "Invalid value for the 'bot-placement' option: '%s'\n", arg_value);
+    }
+  } else if ((arg_value = strip_prefix(arg, "bot-placement-scan-area="))) {
+    if (parse_number(arg_value, &num) && num >= 0) {
+      bot->placement_scan_area = (int)num;
+    } else {
+      fprintf(stderr, "Invalid value for the 'bot-placement-scan-area' option: '%s'\n", arg_value);
+      *ok = false;
+    }
+  } else if ((arg_value = strip_prefix(arg, "bot-movement="))) {
+    if (strcmp(arg_value, "smart") == 0) {
+      bot->movement_strategy = BOT_MOVEMENT_SMART;
+    } else if (strcmp(arg_value, "random") == 0) {
+      bot->movement_strategy = BOT_MOVEMENT_RANDOM;
+    } else if (strcmp(arg_value, "first") == 0) {
+      bot->movement_strategy = BOT_MOVEMENT_FIRST_POSSIBLE;
+    } else if (strcmp(arg_value, "adversarial") == 0) {
+      bot->movement_strategy = BOT_MOVEMENT_ADVERSARIAL;
+    } else if (strcmp(arg_value, "mcts") == 0) {
+      bot->movement_strategy = BOT_MOVEMENT_MCTS;
+    } else {
+      *ok = false;
+      fprintf(stderr, "Invalid value for the 'bot-movement' option: '%s'\n", arg_value);
+    }
+  } else if ((arg_value = strip_prefix(arg, "bot-max-move-steps="))) {
+    if (parse_number(arg_value, &num) && num >= 0) {
+      bot->max_move_length = (int)num;
+    } else {
+      fprintf(stderr, "Invalid value for the 'bot-max-move-steps' option: '%s'\n", arg_value);
+      *ok = false;
+    }
+  } else if ((arg_value = strip_prefix(arg, "bot-recursion="))) {
+    if (parse_number(arg_value, &num) && num >= 0) {
+      bot->recursion_limit = (int)num;
+    } else {
+      fprintf(stderr, "Invalid value for the 'bot-recursion' option: '%s'\n", arg_value);
+      *ok = false;
+    }
+  } else if ((arg_value = strip_prefix(arg, "bot-junction-check-recursion="))) {
+    if (parse_number(arg_value, &num) && num >= -1) {
+      bot->junction_check_recursion_limit = (int)num;
+    } else {
+      fprintf(
+        stderr, "Invalid value for the 'bot-junction-check-recursion' option: '%s'\n", arg_value
+      );
+      *ok = false;
+    }
+  } else if ((arg_value = strip_prefix(arg, "bot-tt-size="))) {
+    if (parse_number(arg_value, &num) && num >= 0) {
+      bot->transposition_table_size = (size_t)num;
+    } else {
+      fprintf(stderr, "Invalid value for the 'bot-tt-size' option: '%s'\n", arg_value);
+      *ok = false;
+    }
+  } else if ((arg_value = strip_prefix(arg, "bot-adversarial="))) {
+    if (strcmp(arg_value, "paranoid") == 0) {
+      bot->adversarial_mode = BOT_ADVERSARIAL_PARANOID;
+    } else if (strcmp(arg_value, "max-n") == 0) {
+      bot->adversarial_mode = BOT_ADVERSARIAL_MAX_N;
+    } else if (strcmp(arg_value, "best-reply") == 0) {
+      bot->adversarial_mode = BOT_ADVERSARIAL_BEST_REPLY;
+    } else {
+      *ok = false;
+      fprintf(stderr, "Invalid value for the 'bot-adversarial' option: '%s'\n", arg_value);
+    }
+  } else if ((arg_value = strip_prefix(arg, "bot-search-depth="))) {
+    if (parse_number(arg_value, &num) && num > 0) {
+      bot->search_depth = (int)num;
+    } else {
+      fprintf(stderr, "Invalid value for the 'bot-search-depth' option: '%s'\n", arg_value);
+      *ok = false;
+    }
+  } else if ((arg_value = strip_prefix(arg, "bot-time-ms="))) {
+    if (parse_number(arg_value, &num) && num >= 0) {
+      bot->time_limit_ms = (int)num;
+    } else {
+      fprintf(stderr, "Invalid value for the 'bot-time-ms' option: '%s'\n", arg_value);
+      *ok = false;
+    }
+  } else if ((arg_value = strip_prefix(arg, "bot-threads="))) {
+    if (parse_number(arg_value, &num) && num >= 0) {
+      bot->threads_count = (int)num;
+    } else {
+      fprintf(stderr, "Invalid value for the 'bot-threads' option: '%s'\n", arg_value);
+      *ok = false;
+    }
+  } else if ((arg_value = strip_prefix(arg, "bot-mcts-iterations="))) {
+    if (parse_number(arg_value, &num) && num > 0) {
+      bot->mcts_iterations = (int)num;
+    } else {
+      fprintf(stderr, "Invalid value for the 'bot-mcts-iterations' option: '%s'\n", arg_value);
+      *ok = false;
+    }
+  } else if ((arg_value = strip_prefix(arg, "bot-endgame-tiles="))) {
+    if (parse_number(arg_value, &num) && num >= 0 && num <= ENDGAME_MAX_TILES) {
+      bot->endgame_tile_limit = (int)num;
+    } else {
+      fprintf(stderr, "Invalid value for the 'bot-endgame-tiles' option: '%s'\n", arg_value);
+      *ok = false;
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
 bool parse_arguments(Arguments* result, int argc, char* argv[]) {
   init_arguments(result);
 
@@ -73,69 +210,39 @@ bool parse_arguments(Arguments* result, int argc, char* argv[]) {
       result->action = ACTION_ARG_GENERATE;
     } else if (strcmp(arg, "view") == 0) {
       result->action = ACTION_ARG_VIEW;
-    } else if ((arg_value = strip_prefix(arg, "name="))) {
+    } else if (strcmp(arg, "book") == 0) {
+      result->action = ACTION_ARG_BOOK;
+    } else if ((arg_value = strip_prefix(arg, "book="))) {
       if (*arg_value != '\0') {
-        result->set_name = arg_value;
+        result->book_file = arg_value;
       } else {
+        fprintf(stderr, "Invalid value for the 'book' option: '%s'\n", arg_value);
         ok = false;
-        fprintf(stderr, "Invalid value for the 'name' option: '%s'\n", arg_value);
       }
-    } else if ((arg_value = strip_prefix(arg, "bot-placement="))) {
-      if (strcmp(arg_value, "smart") == 0) {
-        result->bot.placement_strategy = BOT_PLACEMENT_SMART;
-      } else if (strcmp(arg_value, "random") == 0) {
-        result->bot.placement_strategy = BOT_PLACEMENT_RANDOM;
-      } else if (strcmp(arg_value, "first") == 0) {
-        result->bot.placement_strategy = BOT_PLACEMENT_FIRST_POSSIBLE;
-      } else if (strcmp(arg_value, "fish") == 0) {
-        result->bot.placement_strategy = BOT_PLACEMENT_MOST_FISH;
+    } else if ((arg_value = strip_prefix(arg, "players="))) {
+      if (parse_number(arg_value, &num) && num > 0 && num <= 9) {
+        result->book_players = (int)num;
       } else {
+        fprintf(stderr, "Invalid value for the 'players' option: '%s'\n", arg_value);
         ok = false;
-        fprintf(stderr, "Invalid value for the 'bot-placement' option: '%s'\n", arg_value);
       }
-    } else if ((arg_value = strip_prefix(arg, "bot-placement-scan-area="))) {
+    } else if ((arg_value = strip_prefix(arg, "seed="))) {
       if (parse_number(arg_value, &num) && num >= 0) {
-        result->bot.placement_scan_area = (int)num;
-      } else {
-        fprintf(
-          stderr, "Invalid value for the 'bot-placement-scan-area' option: '%s'\n", arg_value
-        );
-        ok = false;
-      }
-    } else if ((arg_value = strip_prefix(arg, "bot-movement="))) {
-      if (strcmp(arg_value, "smart") == 0) {
-        result->bot.movement_strategy = BOT_MOVEMENT_SMART;
-      } else if (strcmp(arg_value, "random") == 0) {
-        result->bot.movement_strategy = BOT_MOVEMENT_RANDOM;
-      } else if (strcmp(arg_value, "first") == 0) {
-        result->bot.movement_strategy = BOT_MOVEMENT_FIRST_POSSIBLE;
+        result->seed = (uint64_t)num;
+        result->has_seed = true;
       } else {
+        fprintf(stderr, "Invalid value for the 'seed' option: '%s'\n", arg_value);
         ok = false;
-        fprintf(stderr, "Invalid value for the 'bot-movement' option: '%s'\n", arg_value);
       }
-    } else if ((arg_value = strip_prefix(arg, "bot-max-move-steps="))) {
-      if (parse_number(arg_value, &num) && num >= 0) {
-        result->bot.max_move_length = (int)num;
-      } else {
-        fprintf(stderr, "Invalid value for the 'bot-max-move-steps' option: '%s'\n", arg_value);
-        ok = false;
-      }
-    } else if ((arg_value = strip_prefix(arg, "bot-recursion="))) {
-      if (parse_number(arg_value, &num) && num >= 0) {
-        result->bot.recursion_limit = (int)num;
-      } else {
-        fprintf(stderr, "Invalid value for the 'bot-recursion' option: '%s'\n", arg_value);
-        ok = false;
-      }
-    } else if ((arg_value = strip_prefix(arg, "bot-junction-check-recursion="))) {
-      if (parse_number(arg_value, &num) && num >= -1) {
-        result->bot.junction_check_recursion_limit = (int)num;
+    } else if ((arg_value = strip_prefix(arg, "name="))) {
+      if (*arg_value != '\0') {
+        result->set_name = arg_value;
       } else {
-        fprintf(
-          stderr, "Invalid value for the 'bot-junction-check-recursion' option: '%s'\n", arg_value
-        );
         ok = false;
+        fprintf(stderr, "Invalid value for the 'name' option: '%s'\n", arg_value);
       }
+    } else if (parse_bot_argument(&result->bot, arg, &ok)) {
+      // Handled.
     } else if (is_board_gen && file_arg == 0) {
       if (strcmp(arg, "island") == 0) {
         result->board_gen_type = GENERATE_ARG_ISLAND;
@@ -174,6 +281,18 @@ bool parse_arguments(Arguments* result, int argc, char* argv[]) {
     } else if (is_placement_or_movement && file_arg == 1) {
       result->output_board_file = arg;
       file_arg++;
+    } else if (result->action == ACTION_ARG_BOOK && file_arg == 0) {
+      result->book_file = arg;
+      file_arg++;
+    } else if (result->action == ACTION_ARG_BOOK &&
+               (result->book_board_files_count == 0 ||
+                result->book_board_files + result->book_board_files_count == &argv[i])) {
+      // The board files must be listed one after another at the very end.
+      if (result->book_board_files_count == 0) {
+        result->book_board_files = &argv[i];
+      }
+      result->book_board_files_count++;
+      file_arg++;
     } else {
       fprintf(stderr, "Unexpected argument: '%s'\n", arg);
       ok = false;
@@ -191,7 +310,7 @@ bool parse_arguments(Arguments* result, int argc, char* argv[]) {
     }
   }
 
-  if (result->action == ACTION_ARG_PLACEMENT) {
+  if (result->action == ACTION_ARG_PLACEMENT || result->action == ACTION_ARG_BOOK) {
     if (result->penguins <= 0) {
       fprintf(stderr, "Expected a value for the 'penguins' option\n");
       ok = false;
@@ -217,6 +336,21 @@ bool parse_arguments(Arguments* result, int argc, char* argv[]) {
     }
   }
 
+  if (result->action == ACTION_ARG_BOOK) {
+    if (result->book_players <= 0) {
+      fprintf(stderr, "Expected a value for the 'players' option\n");
+      ok = false;
+    }
+    if (result->book_file == NULL) {
+      fprintf(stderr, "Expected a value for the required argument 'book_file'\n");
+      ok = false;
+    }
+    if (result->book_board_files_count == 0) {
+      fprintf(stderr, "Expected a value for the required argument 'board_files'\n");
+      ok = false;
+    }
+  }
+
   if (result->action == ACTION_ARG_VIEW) {
     if (result->input_board_file == NULL) {
       fprintf(stderr, "Expected a value for the required argument 'input_board_file'\n");
@@ -5,6 +5,7 @@
 
 #include "bot.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,6 +20,7 @@ typedef enum ActionArg {
   ACTION_ARG_MOVEMENT,
   ACTION_ARG_GENERATE,
   ACTION_ARG_VIEW,
+  ACTION_ARG_BOOK,
 } ActionArg;
 
 typedef enum GenerateArg {
@@ -37,10 +39,23 @@ typedef struct Arguments {
   int board_gen_width;
   int board_gen_height;
   GenerateArg board_gen_type;
+  /// The opening book consulted in the placement phase or written by the
+  /// @c book action, see #PlacementBook.
+  const char* book_file;
+  /// The boards the @c book action builds the book from, points into @c argv.
+  char* const* book_board_files;
+  int book_board_files_count;
+  int book_players;
+  /// @brief The seed of the #Rng given with the @c seed option, which makes
+  /// the runs reproducible. Only valid if #has_seed is set, otherwise a
+  /// random seed is used.
+  uint64_t seed;
+  bool has_seed;
 } Arguments;
 
 void init_arguments(Arguments* self);
 void print_usage(const char* prog_name);
+bool parse_bot_argument(BotParameters* bot, const char* arg, bool* ok);
 bool parse_arguments(Arguments* result, int argc, char* argv[]);
 
 #ifdef __cplusplus
@@ -1,6 +1,7 @@
 #include "autonomous.h"
 #include "arguments.h"
 #include "board.h"
+#include "book.h"
 #include "bot.h"
 #include "game.h"
 #include "interactive.h"
@@ -21,14 +22,18 @@ const char* MY_AUTONOMOUS_PLAYER_NAME = "102D";
 #define MIN_PLAYER_ID 1
 #define MAX_PLAYER_ID 9
 
+static int run_book_builder(const Arguments* args);
+
 int run_autonomous_mode(const Arguments* args) {
   const char* my_player_name = args->set_name != NULL ? args->set_name : MY_AUTONOMOUS_PLAYER_NAME;
   if (args->action == ACTION_ARG_PRINT_NAME) {
     printf("%s\n", my_player_name);
     return EXIT_OK;
+  } else if (args->action == ACTION_ARG_BOOK) {
+    return run_book_builder(args);
   }
 
-  Rng rng = init_stdlib_rng();
+  Rng rng = args->has_seed ? init_rng(args->seed) : init_random_rng();
   Game* game = game_new();
   FILE *input_file, *output_file;
   bool move_ok = true;
@@ -76,19 +81,27 @@ int run_autonomous_mode(const Arguments* args) {
     BotState* bot = bot_state_new(&args->bot, game, &rng);
 
     if (args->action == ACTION_ARG_PLACEMENT) {
+      PlacementBook* book = NULL;
+      if (args->book_file != NULL && (book = placement_book_open(args->book_file)) == NULL) {
+        fprintf(stderr, "Failed to open the opening book, it will not be used\n");
+      }
       placement_begin(game);
-      game->current_player_index = my_player_index - 1;
+      game_set_current_player(game, my_player_index - 1);
       if (placement_switch_player(game) == my_player_index) {
         Coords target;
-        move_ok = bot_compute_placement(bot, &target);
+        move_ok = placement_book_lookup(book, game, &args->bot, &target) ||
+                  bot_compute_placement(bot, &target);
         if (move_ok) {
           place_penguin(game, target);
         }
       }
       placement_end(game);
+      if (book != NULL) {
+        placement_book_free(book);
+      }
     } else if (args->action == ACTION_ARG_MOVEMENT) {
       movement_begin(game);
-      game->current_player_index = my_player_index - 1;
+      game_set_current_player(game, my_player_index - 1);
       if (movement_switch_player(game) == my_player_index) {
         Coords penguin, target;
         move_ok = bot_compute_move(bot, &penguin, &target);
@@ -119,6 +132,100 @@ int run_autonomous_mode(const Arguments* args) {
   return move_ok ? EXIT_OK : EXIT_NO_POSSIBLE_MOVES;
 }
 
+/// @brief Loads a board for #placement_book_build and creates a game for the
+/// given number of players on it. The board must have no penguins on it.
+static Game* load_book_board(const char* path, int players_count, int penguins) {
+  FILE* file;
+  if ((file = fopen(path, "r")) == NULL) {
+    perror("Failed to open the board file");
+    return NULL;
+  }
+  Game* board = game_new();
+  game_begin_setup(board);
+  bool ok = load_game_state(board, file, penguins, MY_AUTONOMOUS_PLAYER_NAME);
+  fclose(file);
+  if (!ok) {
+    fprintf(stderr, "Failed to parse the board file '%s'\n", path);
+    game_free(board);
+    return NULL;
+  }
+
+  Game* game = game_new();
+  game_begin_setup(game);
+  setup_board(game, board->board_width, board->board_height);
+  for (int y = 0; y < board->board_height; y++) {
+    for (int x = 0; x < board->board_width; x++) {
+      Coords coords = { x, y };
+      short tile = get_tile(board, coords);
+      if (is_penguin_tile(tile)) {
+        fprintf(stderr, "The board file '%s' has penguins on it\n", path);
+        game_free(board);
+        game_free(game);
+        return NULL;
+      }
+      set_tile(game, coords, tile);
+    }
+  }
+  game_free(board);
+  game_set_penguins_per_player(game, penguins);
+  game_set_players_count(game, players_count);
+  for (int i = 0; i < players_count; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "%d", i + 1);
+    game_set_player_name(game, i, name);
+  }
+  game_end_setup(game);
+  return game;
+}
+
+/// @brief Implements the @c book action: plays out the placement phase on
+/// every board and adds the placements to the book file, the entries already
+/// in it are kept.
+static int run_book_builder(const Arguments* args) {
+  if (!placement_book_supports(&args->bot)) {
+    fprintf(stderr, "The opening book can't be built for the chosen placement strategy\n");
+    return EXIT_INTERNAL_ERROR;
+  }
+  int games_count = args->book_board_files_count;
+  Game** games = malloc(sizeof(*games) * games_count);
+  for (int i = 0; i < games_count; i++) {
+    games[i] = load_book_board(args->book_board_files[i], args->book_players, args->penguins);
+    if (games[i] == NULL) {
+      for (int j = 0; j < i; j++) game_free(games[j]);
+      free(games);
+      return EXIT_INPUT_FILE_ERROR;
+    }
+  }
+
+  PlacementBookEntry* entries;
+  size_t count =
+    placement_book_build(games, games_count, &args->bot, args->bot.threads_count, &entries);
+  for (int i = 0; i < games_count; i++) game_free(games[i]);
+  free(games);
+
+  PlacementBook* old_book = placement_book_open(args->book_file);
+  if (old_book != NULL) {
+    // The old entries go after the new ones, so the new answers win when the
+    // same position is in both (see placement_book_sort_entries).
+    size_t total_count = count + old_book->entries_count;
+    entries = realloc(entries, sizeof(*entries) * my_max(total_count, 1));
+    for (size_t i = 0; i < old_book->entries_count; i++) {
+      entries[count + i] = old_book->entries[i];
+    }
+    count = total_count;
+    // The file must be unmapped before it can be overwritten on Windows.
+    placement_book_free(old_book);
+  }
+
+  bool ok = placement_book_write(args->book_file, entries, count);
+  free(entries);
+  if (!ok) {
+    perror("Failed to write the book file");
+    return EXIT_INTERNAL_ERROR;
+  }
+  return EXIT_OK;
+}
+
 static size_t read_line(FILE* file, char** buf, size_t* line_len) {
   *line_len = 0;
   size_t buf_size = 64;
@@ -0,0 +1,251 @@
+#include "bitboard.h"
+#include "board.h"
+#include "game.h"
+#include "movement.h"
+#include "utils.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// @relatesalso Bitboard
+/// @brief Constructs an empty #Bitboard, the planes are allocated later by
+/// #bitboard_load_game.
+Bitboard* bitboard_new(void) {
+  Bitboard* self = malloc(sizeof(*self));
+  self->width = 0;
+  self->height = 0;
+  self->row_words = 0;
+  self->col_words = 0;
+  self->players_count = 0;
+  self->walkable = NULL;
+  self->walkable_t = NULL;
+  for (int i = 0; i < BITBOARD_FISH_PLANES; i++) {
+    self->fish[i] = NULL;
+  }
+  self->penguins = NULL;
+  self->player_penguins = NULL;
+  return self;
+}
+
+/// @relatesalso Bitboard
+/// @brief Destroys a #Bitboard and all of its planes.
+void bitboard_free(Bitboard* self) {
+  if (self == NULL) return;
+  free_and_clear(self->walkable);
+  free_and_clear(self->walkable_t);
+  for (int i = 0; i < BITBOARD_FISH_PLANES; i++) {
+    free_and_clear(self->fish[i]);
+  }
+  free_and_clear(self->penguins);
+  free_and_clear(self->player_penguins);
+  free(self);
+}
+
+/// @relatesalso Bitboard
+/// @brief Sets or clears a single bit of a row-major plane.
+static inline void bitboard_plane_set(Bitboard* self, uint64_t* plane, int x, int y, bool value) {
+  uint64_t* word = &plane[y * self->row_words + (x >> 6)];
+  *word = change_bit(*word, (uint64_t)1 << (x & 63), value);
+}
+
+/// @relatesalso Bitboard
+/// @brief (Re)allocates the planes to fit the board of the given #Game and
+/// fills them with the tiles of the board.
+void bitboard_load_game(Bitboard* self, const Game* game) {
+  int w = game->board_width, h = game->board_height;
+  int row_words = (w + 63) / 64, col_words = (h + 63) / 64;
+  int players_count = my_max(game->players_count, 0);
+  bool resize = self->width != w || self->height != h || self->players_count != players_count;
+
+  self->width = w, self->height = h;
+  self->row_words = row_words, self->col_words = col_words;
+  self->players_count = players_count;
+
+  size_t plane_size = sizeof(uint64_t) * row_words * h;
+  size_t plane_t_size = sizeof(uint64_t) * col_words * w;
+  if (resize) {
+    self->walkable = realloc(self->walkable, plane_size);
+    self->walkable_t = realloc(self->walkable_t, plane_t_size);
+    for (int i = 0; i < BITBOARD_FISH_PLANES; i++) {
+      self->fish[i] = realloc(self->fish[i], plane_size);
+    }
+    self->penguins = realloc(self->penguins, plane_size);
+    self->player_penguins = realloc(self->player_penguins, plane_size * my_max(players_count, 1));
+  }
+  memset(self->walkable, 0, plane_size);
+  memset(self->walkable_t, 0, plane_t_size);
+  for (int i = 0; i < BITBOARD_FISH_PLANES; i++) {
+    memset(self->fish[i], 0, plane_size);
+  }
+  memset(self->penguins, 0, plane_size);
+  memset(self->player_penguins, 0, plane_size * players_count);
+
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      Coords coords = { x, y };
+      if (!is_water_tile(get_tile(game, coords))) {
+        bitboard_sync_tile(self, game, coords);
+      }
+    }
+  }
+}
+
+/// @relatesalso Bitboard
+/// @brief Updates the bits of all planes at @c coords to match the current
+/// contents of the tile in the #Game.
+void bitboard_sync_tile(Bitboard* self, const Game* game, Coords coords) {
+  assert(is_tile_in_bounds(game, coords));
+  assert(self->width == game->board_width && self->height == game->board_height);
+  short tile = get_tile(game, coords);
+  short player_id = get_tile_player_id(tile);
+  int player_idx = player_id != 0 ? game_find_player_by_id(game, player_id) : -1;
+  bitboard_set_tile(self, coords, tile, player_idx);
+}
+
+/// @relatesalso Bitboard
+/// @brief Updates the bits of all planes at @c coords to match the given
+/// tile, @c player_idx is the index of the owner of the penguin on it (if
+/// there is one). Used where the tiles don't come from a #Game.
+void bitboard_set_tile(Bitboard* self, Coords coords, short tile, int player_idx) {
+  assert(0 <= coords.x && coords.x < self->width && 0 <= coords.y && coords.y < self->height);
+  int x = coords.x, y = coords.y;
+
+  bool walkable = is_fish_tile(tile);
+  bitboard_plane_set(self, self->walkable, x, y, walkable);
+  uint64_t* word_t = &self->walkable_t[x * self->col_words + (y >> 6)];
+  *word_t = change_bit(*word_t, (uint64_t)1 << (y & 63), walkable);
+
+  short fish = get_tile_fish(tile);
+  assert(fish < (1 << BITBOARD_FISH_PLANES));
+  for (int i = 0; i < BITBOARD_FISH_PLANES; i++) {
+    bitboard_plane_set(self, self->fish[i], x, y, test_bit(fish, 1 << i));
+  }
+
+  bool penguin = is_penguin_tile(tile);
+  bitboard_plane_set(self, self->penguins, x, y, penguin);
+  for (int i = 0; i < self->players_count; i++) {
+    uint64_t* plane = (uint64_t*)bitboard_player_plane(self, i);
+    bitboard_plane_set(self, plane, x, y, penguin && i == player_idx);
+  }
+}
+
+/// @brief Spreads the set bits of @c seeds towards the higher bits over the
+/// runs of consecutive set bits of @c mask (the Kogge-Stone occluded fill).
+/// @see <https://www.chessprogramming.org/Kogge-Stone_Algorithm>
+static inline uint64_t bitboard_fill_up(uint64_t seeds, uint64_t mask) {
+  seeds |= mask & (seeds << 1), mask &= mask << 1;
+  seeds |= mask & (seeds << 2), mask &= mask << 2;
+  seeds |= mask & (seeds << 4), mask &= mask << 4;
+  seeds |= mask & (seeds << 8), mask &= mask << 8;
+  seeds |= mask & (seeds << 16), mask &= mask << 16;
+  seeds |= mask & (seeds << 32);
+  return seeds;
+}
+
+/// @brief The same as #bitboard_fill_up, but towards the lower bits.
+static inline uint64_t bitboard_fill_down(uint64_t seeds, uint64_t mask) {
+  seeds |= mask & (seeds >> 1), mask &= mask >> 1;
+  seeds |= mask & (seeds >> 2), mask &= mask >> 2;
+  seeds |= mask & (seeds >> 4), mask &= mask >> 4;
+  seeds |= mask & (seeds >> 8), mask &= mask >> 8;
+  seeds |= mask & (seeds >> 16), mask &= mask >> 16;
+  seeds |= mask & (seeds >> 32);
+  return seeds;
+}
+
+/// @relatesalso Bitboard
+/// @brief Grows the row @c y of the @c region by the tiles of the @c mask
+/// adjacent to it from the rows above and below, and then along the row
+/// itself as far as the @c mask allows. Returns @c true if the row changed.
+static bool bitboard_fill_row(
+  const Bitboard* self, const uint64_t* mask, uint64_t* region, int y
+) {
+  int words = self->row_words;
+  uint64_t* row = &region[y * words];
+  const uint64_t* mask_row = &mask[y * words];
+  const uint64_t* above = y > 0 ? row - words : NULL;
+  const uint64_t* below = y + 1 < self->height ? row + words : NULL;
+  bool changed = false;
+  // The rows of the planes may span multiple words, so the bits carried over
+  // the boundaries of the words are passed along to the next word: upwards on
+  // the first pass, and downwards on the second one.
+  uint64_t carry = 0;
+  for (int i = 0; i < words; i++) {
+    uint64_t seeds = row[i] | carry;
+    if (above != NULL) seeds |= above[i];
+    if (below != NULL) seeds |= below[i];
+    uint64_t filled = bitboard_fill_up(seeds & mask_row[i], mask_row[i]);
+    carry = filled >> 63;
+    changed |= filled != row[i];
+    row[i] = filled;
+  }
+  carry = 0;
+  for (int i = words - 1; i >= 0; i--) {
+    uint64_t filled = bitboard_fill_down(row[i] | (carry & mask_row[i]), mask_row[i]);
+    carry = filled << 63;
+    changed |= filled != row[i];
+    row[i] = filled;
+  }
+  return changed;
+}
+
+/// @relatesalso Bitboard
+/// @brief Sets the @c region plane to the tiles of the @c mask plane which
+/// are reachable from @c start through the sides of the tiles of the @c mask.
+/// The @c region is left empty if the @c start itself isn't in the @c mask.
+///
+/// This is the bit-parallel alternative of #flood_fill: instead of visiting
+/// the tiles one by one, whole rows of the region are grown at once with
+/// shifts (see #bitboard_fill_up), sweeping the board from top to bottom and
+/// back until nothing changes anymore. Usually it takes just a couple of
+/// sweeps, only the regions winding up and down a lot take more.
+void bitboard_flood_fill(
+  const Bitboard* self, const uint64_t* mask, uint64_t* region, Coords start
+) {
+  int h = self->height;
+  memset(region, 0, sizeof(*region) * self->row_words * h);
+  if (!bitboard_test(self, mask, start)) return;
+  region[start.y * self->row_words + (start.x >> 6)] = (uint64_t)1 << (start.x & 63);
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int y = start.y; y < h; y++) {
+      changed |= bitboard_fill_row(self, mask, region, y);
+    }
+    for (int y = h - 1; y >= 0; y--) {
+      changed |= bitboard_fill_row(self, mask, region, y);
+    }
+    // Initially the region is empty above the start, so only the first sweep
+    // may skip those rows.
+    start.y = 0;
+  }
+}
+
+/// @relatesalso Bitboard
+/// @brief Returns the total number of fish on the tiles set in the @c plane.
+int bitboard_count_fish(const Bitboard* self, const uint64_t* plane) {
+  int total = 0;
+  int words = self->row_words * self->height;
+  for (int i = 0; i < BITBOARD_FISH_PLANES; i++) {
+    int count = 0;
+    for (int j = 0; j < words; j++) {
+      count += popcount64(plane[j] & self->fish[i][j]);
+    }
+    total += count << i;
+  }
+  return total;
+}
+
+extern const uint64_t* bitboard_player_plane(const Bitboard* self, int idx);
+extern bool bitboard_test(const Bitboard* self, const uint64_t* plane, Coords coords);
+extern int bitboard_tile_fish(const Bitboard* self, Coords coords);
+extern unsigned bitboard_row_window(const Bitboard* self, const uint64_t* plane, int x, int y);
+extern unsigned bitboard_neighbors_mask(
+  const Bitboard* self, const uint64_t* plane, Coords coords
+);
+extern int bitboard_count_obstructed(const Bitboard* self, Coords coords);
+extern int bitboard_scan_forward(const uint64_t* row, int words, int start);
+extern int bitboard_scan_backward(const uint64_t* row, int start);
+extern PossibleSteps bitboard_possible_steps(const Bitboard* self, Coords start);
@@ -0,0 +1,214 @@
+#pragma once
+
+/// @file
+/// @brief A bitboard representation of the board used by the bot
+/// @see bot.h
+
+#include "game.h"
+#include "movement.h"
+#include "utils.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// The number of bit planes used for encoding the fish counts, see #Bitboard::fish.
+#define BITBOARD_FISH_PLANES 4
+
+/// @brief A mirror of the #Game::board_grid where every kind of tile is stored
+/// as a separate bit plane.
+///
+/// A bit plane is a grid of bits, one bit per tile, packed into 64-bit words.
+/// The rows of a plane are laid out one after another just like in the
+/// #Game::board_grid, but every row is padded to a whole number of words
+/// (#row_words), so that bit @c x of the row @c y is located in the word
+/// <tt>y * row_words + x / 64</tt> at the position <tt>x % 64</tt>. The bits
+/// in the padding are always zero, which conveniently means that the tiles
+/// outside the board behave just like water.
+///
+/// The point of this representation is that most of the questions the bot
+/// asks about the board, such as "how far can the penguin slide in this
+/// direction" or "how many neighbors of this tile are free", can be answered
+/// by looking at a whole row of tiles at once with a couple of shifts and
+/// popcounts, instead of walking the board tile by tile with #get_tile.
+///
+/// @see <https://www.chessprogramming.org/Bitboards>
+///
+/// The bitboard doesn't track changes of the #Game by itself, every modified
+/// tile has to be re-synchronized with #bitboard_sync_tile.
+typedef struct Bitboard {
+  int width;
+  int height;
+  /// The number of words in a row of the row-major planes.
+  int row_words;
+  /// The number of words in a column of the column-major (transposed) planes.
+  int col_words;
+  /// The number of players which have a plane in #player_penguins.
+  int players_count;
+
+  /// @brief The tiles a penguin can move onto or over, i.e. the ice tiles
+  /// with fish on them. Row-major.
+  uint64_t* walkable;
+  /// @brief The transposed copy of #walkable, bit @c y of the column @c x is
+  /// stored in the column @c x, used for scanning the columns.
+  uint64_t* walkable_t;
+  /// @brief The binary digits of the fish counts: the number of fish on a tile
+  /// is the sum of <tt>(1 << i)</tt> for every plane @c i which has a bit set
+  /// at that tile. Row-major.
+  uint64_t* fish[BITBOARD_FISH_PLANES];
+  /// All tiles occupied by penguins of any player. Row-major.
+  uint64_t* penguins;
+  /// @brief The penguins of every player, indexed by the player index (and not
+  /// the ID!). The planes are stored sequentially, see #bitboard_player_plane.
+  uint64_t* player_penguins;
+} Bitboard;
+
+Bitboard* bitboard_new(void);
+void bitboard_free(Bitboard* self);
+void bitboard_load_game(Bitboard* self, const Game* game);
+void bitboard_sync_tile(Bitboard* self, const Game* game, Coords coords);
+void bitboard_set_tile(Bitboard* self, Coords coords, short tile, int player_idx);
+void bitboard_flood_fill(
+  const Bitboard* self, const uint64_t* mask, uint64_t* region, Coords start
+);
+int bitboard_count_fish(const Bitboard* self, const uint64_t* plane);
+
+/// @relatesalso Bitboard
+/// @brief Returns a pointer to the penguins plane of the player at @c idx.
+inline const uint64_t* bitboard_player_plane(const Bitboard* self, int idx) {
+  assert(0 <= idx && idx < self->players_count);
+  return &self->player_penguins[idx * self->row_words * self->height];
+}
+
+/// @relatesalso Bitboard
+/// @brief Tests the bit at @c coords in a row-major plane. Returns @c false
+/// for the coordinates outside the board.
+inline ALWAYS_INLINE bool bitboard_test(
+  const Bitboard* self, const uint64_t* plane, Coords coords
+) {
+  int x = coords.x, y = coords.y;
+  if (!(0 <= x && x < self->width && 0 <= y && y < self->height)) return false;
+  return (plane[y * self->row_words + (x >> 6)] >> (x & 63)) & 1;
+}
+
+/// @relatesalso Bitboard
+/// @brief Returns the number of fish on the tile at @c coords (zero if the
+/// tile doesn't contain fish or is outside the board).
+inline int bitboard_tile_fish(const Bitboard* self, Coords coords) {
+  int fish = 0;
+  for (int i = 0; i < BITBOARD_FISH_PLANES; i++) {
+    fish |= bitboard_test(self, self->fish[i], coords) << i;
+  }
+  return fish;
+}
+
+/// @relatesalso Bitboard
+/// @brief Extracts the bits <tt>x - 1</tt>, @c x and <tt>x + 1</tt> of the
+/// row @c y of a plane into the lowest three bits of the result.
+inline ALWAYS_INLINE unsigned bitboard_row_window(
+  const Bitboard* self, const uint64_t* plane, int x, int y
+) {
+  if (!(0 <= y && y < self->height)) return 0;
+  const uint64_t* row = &plane[y * self->row_words];
+  int bit = x & 63, word = x >> 6;
+  if (1 <= bit && bit <= 62) {
+    // The fast path: the whole window is contained within a single word.
+    return (unsigned)(row[word] >> (bit - 1)) & 7;
+  }
+  unsigned result = ((unsigned)(row[word] >> bit) & 1) << 1;
+  if (x - 1 >= 0) result |= (unsigned)(row[(x - 1) >> 6] >> ((x - 1) & 63)) & 1;
+  if (((x + 1) >> 6) < self->row_words) {
+    result |= ((unsigned)(row[(x + 1) >> 6] >> ((x + 1) & 63)) & 1) << 2;
+  }
+  return result;
+}
+
+/// @relatesalso Bitboard
+/// @brief Collects the bits of all eight neighbors of a tile in a plane into a
+/// mask, where bit @c i corresponds to the #Neighbor variant @c i.
+inline ALWAYS_INLINE unsigned bitboard_neighbors_mask(
+  const Bitboard* self, const uint64_t* plane, Coords coords
+) {
+  assert(0 <= coords.x && coords.x < self->width && 0 <= coords.y && coords.y < self->height);
+  int x = coords.x, y = coords.y;
+  unsigned above = bitboard_row_window(self, plane, x, y - 1);
+  unsigned middle = bitboard_row_window(self, plane, x, y);
+  unsigned below = bitboard_row_window(self, plane, x, y + 1);
+  // The bits of the windows are ordered left-to-right: bit 0 is x - 1, bit 1
+  // is x and bit 2 is x + 1.
+  return ((middle >> 2) & 1) << NEIGHBOR_RIGHT |      //
+         ((below >> 2) & 1) << NEIGHBOR_BOTTOM_RIGHT | //
+         ((below >> 1) & 1) << NEIGHBOR_BOTTOM |       //
+         ((below >> 0) & 1) << NEIGHBOR_BOTTOM_LEFT |  //
+         ((middle >> 0) & 1) << NEIGHBOR_LEFT |        //
+         ((above >> 0) & 1) << NEIGHBOR_TOP_LEFT |     //
+         ((above >> 1) & 1) << NEIGHBOR_TOP |          //
+         ((above >> 2) & 1) << NEIGHBOR_TOP_RIGHT;
+}
+
+/// The bits of the mask returned by #bitboard_neighbors_mask which correspond
+/// to the four #Direction s.
+#define BITBOARD_DIRECTIONS_MASK \
+  ((1u << NEIGHBOR_RIGHT) | (1u << NEIGHBOR_BOTTOM) | (1u << NEIGHBOR_LEFT) | (1u << NEIGHBOR_TOP))
+
+/// @relatesalso Bitboard
+/// @brief The bitboard version of #count_obstructed_directions.
+inline int bitboard_count_obstructed(const Bitboard* self, Coords coords) {
+  unsigned neighbors = bitboard_neighbors_mask(self, self->walkable, coords);
+  return DIRECTION_MAX - popcount64(neighbors & BITBOARD_DIRECTIONS_MASK);
+}
+
+/// @relatesalso Bitboard
+/// @brief Counts the run of consecutive set bits in a row of words starting at
+/// the bit @c start and going towards the higher bits.
+inline ALWAYS_INLINE int bitboard_scan_forward(const uint64_t* row, int words, int start) {
+  int word = start >> 6, bit = start & 63;
+  if (word >= words) return 0;
+  // The bits below the start are shifted out and the zeroes shifted in at the
+  // top are (intentionally) treated as the set bits.
+  uint64_t inverted = ~row[word] >> bit;
+  if (inverted != 0) return ctz64(inverted);
+  int steps = 64 - bit;
+  for (word++; word < words; word++) {
+    if (~row[word] != 0) return steps + ctz64(~row[word]);
+    steps += 64;
+  }
+  return steps;
+}
+
+/// @relatesalso Bitboard
+/// @brief Counts the run of consecutive set bits in a row of words starting at
+/// the bit @c start and going towards the lower bits.
+inline ALWAYS_INLINE int bitboard_scan_backward(const uint64_t* row, int start) {
+  if (start < 0) return 0;
+  int word = start >> 6, bit = start & 63;
+  uint64_t inverted = ~row[word] << (63 - bit);
+  if (inverted != 0) return clz64(inverted);
+  int steps = bit + 1;
+  for (word--; word >= 0; word--) {
+    if (~row[word] != 0) return steps + clz64(~row[word]);
+    steps += 64;
+  }
+  return steps;
+}
+
+/// @relatesalso Bitboard
+/// @brief The bitboard version of #calculate_penguin_possible_moves.
+inline PossibleSteps bitboard_possible_steps(const Bitboard* self, Coords start) {
+  assert(0 <= start.x && start.x < self->width && 0 <= start.y && start.y < self->height);
+  const uint64_t* row = &self->walkable[start.y * self->row_words];
+  const uint64_t* col = &self->walkable_t[start.x * self->col_words];
+  PossibleSteps moves;
+  moves.steps[DIRECTION_RIGHT] = bitboard_scan_forward(row, self->row_words, start.x + 1);
+  moves.steps[DIRECTION_LEFT] = bitboard_scan_backward(row, start.x - 1);
+  moves.steps[DIRECTION_DOWN] = bitboard_scan_forward(col, self->col_words, start.y + 1);
+  moves.steps[DIRECTION_UP] = bitboard_scan_backward(col, start.y - 1);
+  return moves;
+}
+
+#ifdef __cplusplus
+}
+#endif
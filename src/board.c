@@ -7,18 +7,80 @@
 
 /// @relatesalso Game
 /// @brief Sets #Game::board_width and #Game::board_height and allocates
-/// #Game::board_grid and #Game::tile_attributes. Can only be called within
-/// #GAME_PHASE_SETUP. The @c width and @c height values must be positive.
+/// #Game::board_grid, #Game::tile_rays and #Game::tile_attributes. Can only be
+/// called within #GAME_PHASE_SETUP. The @c width and @c height values must be
+/// positive.
 void setup_board(Game* game, int width, int height) {
   assert(game->phase == GAME_PHASE_SETUP);
   assert(width > 0 && height > 0);
   free_and_clear(game->board_grid);
+  free_and_clear(game->tile_rays);
   free_and_clear(game->tile_attributes);
   game->board_width = width;
   game->board_height = height;
   game->board_grid = calloc(width * height, sizeof(*game->board_grid));
+  // The board is all water, so all rays are empty and nothing is placeable.
+  game->tile_rays = calloc(width * height * DIRECTION_MAX, sizeof(*game->tile_rays));
+  game->placeable_tiles_count = 0;
+  game_recount_mobile_penguins(game);
   game->tile_attributes = calloc(width * height, sizeof(*game->tile_attributes));
   set_all_tiles_attr(game, TILE_DIRTY, true);
+  game->zobrist_key = game_compute_zobrist_key(game);
+}
+
+/// @relatesalso Game
+/// @brief Updates the #Player::mobile_penguins_count of the owner of the
+/// penguin at @c coords whose mobility has just changed, unless the penguin
+/// isn't in the #Player::penguins list (yet).
+static void update_penguin_mobility(Game* game, Coords coords, short tile, int delta) {
+  int idx = game_find_player_by_id(game, (short)get_tile_player_id(tile));
+  if (idx >= 0 && game_find_player_penguin(game, idx, coords) != NULL) {
+    game_get_player(game, idx)->mobile_penguins_count += delta;
+  }
+}
+
+/// @relatesalso Game
+/// @brief Updates the #Game::tile_rays after the walkability of the tile at
+/// @c coords has changed, called by #set_tile.
+///
+/// The rays which can pass through the tile are the ones of the tiles in the
+/// same row and column, pointing towards it. Going away from the tile in the
+/// direction opposite to the ray, their lengths grow by one with every
+/// walkable tile, starting from zero if the tile itself isn't walkable, or
+/// from the length of its own ray plus one otherwise, and the first
+/// non-walkable tile on the way is the last one whose ray is affected.
+///
+/// Only the adjacent tiles can change their mobility: a penguin next to the
+/// tile whose other rays are empty becomes stuck or unstuck.
+void update_tile_rays(Game* game, Coords coords) {
+  int w = game->board_width, h = game->board_height;
+  int x = coords.x, y = coords.y, idx = x + y * w;
+  const short* grid = game->board_grid;
+  short* rays = game->tile_rays;
+  bool walkable = is_fish_tile(grid[idx]);
+  for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+    Coords d = DIRECTION_TO_COORDS[dir];
+    // The number of tiles behind this one, on the side opposite to dir.
+    int remaining = d.x > 0 ? x : d.x < 0 ? w - 1 - x : d.y > 0 ? y : h - 1 - y;
+    int step = -(d.x + d.y * w);
+    short length = walkable ? rays[idx * DIRECTION_MAX + dir] + 1 : 0;
+    if (remaining > 0 && is_penguin_tile(grid[idx + step])) {
+      const short* neighbor_rays = &rays[(idx + step) * DIRECTION_MAX];
+      bool other_rays_empty = true;
+      for (int other = 0; other < DIRECTION_MAX; other++) {
+        if (other != dir && neighbor_rays[other] != 0) other_rays_empty = false;
+      }
+      if (other_rays_empty) {
+        Coords neighbor = { x - d.x, y - d.y };
+        update_penguin_mobility(game, neighbor, grid[idx + step], walkable ? 1 : -1);
+      }
+    }
+    for (int i = idx + step; remaining > 0; i += step, remaining--) {
+      rays[i * DIRECTION_MAX + dir] = length;
+      if (!is_fish_tile(grid[i])) break;
+      length++;
+    }
+  }
 }
 
 /// @brief Generates the board by setting every tile purely randomly. The
@@ -67,3 +129,4 @@ extern void set_tile_attr(Game* game, Coords coords, short attr, bool value);
 extern void set_all_tiles_attr(Game* game, short attr, bool value);
 extern short get_tile(const Game* game, Coords coords);
 extern void set_tile(Game* game, Coords coords, short value);
+extern const short* get_tile_rays(const Game* game, Coords coords);
@@ -7,6 +7,7 @@
 #include "utils.h"
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -55,6 +56,8 @@ enum TileAttribute {
 
 void setup_board(Game* game, int width, int height);
 
+void update_tile_rays(Game* game, Coords coords);
+
 void generate_board_random(Game* game, Rng* rng);
 void generate_board_island(Game* game, Rng* rng);
 
@@ -112,14 +115,30 @@ inline ALWAYS_INLINE short get_tile(const Game* game, Coords coords) {
 
 /// @relatesalso Game
 /// @brief Sets the value of the tile at @c coords (and also sets the attribute
-/// #TILE_DIRTY). Fails if @c coords are outside the bounds.
+/// #TILE_DIRTY and updates #Game::zobrist_key, #Game::tile_rays,
+/// #Game::placeable_tiles_count and #Player::mobile_penguins_count). Fails if
+/// @c coords are outside the bounds.
 /// @see #Game::board_grid
 inline ALWAYS_INLINE void set_tile(Game* game, Coords coords, short value) {
   assert(is_tile_in_bounds(game, coords));
-  game->board_grid[coords.x + game->board_width * coords.y] = value;
+  int idx = coords.x + game->board_width * coords.y;
+  short* tile = &game->board_grid[idx];
+  game->zobrist_key ^= game_zobrist_tile_key(idx, *tile) ^ game_zobrist_tile_key(idx, value);
+  bool walkability_changed = is_fish_tile(*tile) != is_fish_tile(value);
+  game->placeable_tiles_count += (get_tile_fish(value) == 1) - (get_tile_fish(*tile) == 1);
+  *tile = value;
+  if (walkability_changed) update_tile_rays(game, coords);
   set_tile_attr(game, coords, TILE_DIRTY, true);
 }
 
+/// @relatesalso Game
+/// @brief Returns the lengths of the rays of the tile at @c coords, see
+/// #Game::tile_rays.
+inline ALWAYS_INLINE const short* get_tile_rays(const Game* game, Coords coords) {
+  assert(is_tile_in_bounds(game, coords));
+  return &game->tile_rays[(coords.x + game->board_width * coords.y) * DIRECTION_MAX];
+}
+
 /// @}
 
 #ifdef __cplusplus
@@ -0,0 +1,364 @@
+#include "book.h"
+#include "board.h"
+#include "bot.h"
+#include "game.h"
+#include "placement.h"
+#include "threading.h"
+#include "utils.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// @brief Maps the coordinates on a board of the given size into its
+/// orientation number @c transform (see #placement_book_key).
+static Coords book_to_canonical(Coords coords, int width, int height, int transform) {
+  if (transform & 1) coords.x = width - 1 - coords.x;
+  if (transform & 2) coords.y = height - 1 - coords.y;
+  if (transform & 4) coords = (Coords){ coords.y, coords.x };
+  return coords;
+}
+
+/// @brief The inverse of #book_to_canonical, the size is of the original
+/// board and not of the transformed one.
+static Coords book_from_canonical(Coords coords, int width, int height, int transform) {
+  if (transform & 4) coords = (Coords){ coords.y, coords.x };
+  if (transform & 2) coords.y = height - 1 - coords.y;
+  if (transform & 1) coords.x = width - 1 - coords.x;
+  return coords;
+}
+
+/// @relatesalso PlacementBook
+/// @brief Maps a book file into memory, returns @c NULL if the file can't be
+/// opened or is not a valid book (@c errno is set in the former case).
+PlacementBook* placement_book_open(const char* path) {
+  size_t size = 0;
+  void* mapping = NULL;
+#ifdef _WIN32
+  HANDLE file = CreateFileA(
+    path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL
+  );
+  if (file == INVALID_HANDLE_VALUE) return NULL;
+  LARGE_INTEGER file_size;
+  HANDLE mapping_handle = NULL;
+  bool size_ok = GetFileSizeEx(file, &file_size) != 0;
+  if (size_ok && file_size.QuadPart >= (LONGLONG)sizeof(PlacementBookHeader)) {
+    size = (size_t)file_size.QuadPart;
+    mapping_handle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  }
+  CloseHandle(file);
+  if (mapping_handle == NULL) return NULL;
+  mapping = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+  if (mapping == NULL) {
+    CloseHandle(mapping_handle);
+    return NULL;
+  }
+#else
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return NULL;
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == 0 && file_stat.st_size >= (off_t)sizeof(PlacementBookHeader)) {
+    size = (size_t)file_stat.st_size;
+    mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) mapping = NULL;
+  }
+  close(fd);
+  if (mapping == NULL) return NULL;
+#endif
+
+  PlacementBook* self = malloc(sizeof(*self));
+  self->mapping = mapping;
+  self->mapping_size = size;
+#ifdef _WIN32
+  self->mapping_handle = mapping_handle;
+#endif
+  const PlacementBookHeader* header = mapping;
+  size_t entries_size = size - sizeof(*header);
+  if (header->magic != PLACEMENT_BOOK_MAGIC || header->version != PLACEMENT_BOOK_VERSION ||
+      entries_size / sizeof(PlacementBookEntry) < header->entries_count) {
+    placement_book_free(self);
+    return NULL;
+  }
+  self->entries = (const PlacementBookEntry*)(header + 1);
+  self->entries_count = header->entries_count;
+  return self;
+}
+
+/// @relatesalso PlacementBook
+/// @brief Unmaps the book file.
+void placement_book_free(PlacementBook* self) {
+#ifdef _WIN32
+  UnmapViewOfFile(self->mapping);
+  CloseHandle(self->mapping_handle);
+#else
+  munmap(self->mapping, self->mapping_size);
+#endif
+  free(self);
+}
+
+/// @relatesalso PlacementBook
+/// @brief Checks if the placements chosen with the given parameters can be
+/// stored in the book.
+///
+/// Only the strategies which are deterministic and don't depend on the
+/// orientation of the board qualify, these are #BOT_PLACEMENT_SMART and
+/// #BOT_PLACEMENT_MOST_FISH. Strictly speaking they break the ties between
+/// the equally good tiles by their order, but any of them is as good a
+/// placement.
+bool placement_book_supports(const BotParameters* params) {
+  return params->placement_strategy == BOT_PLACEMENT_SMART ||
+         params->placement_strategy == BOT_PLACEMENT_MOST_FISH;
+}
+
+/// @relatesalso PlacementBook
+/// @brief Computes the key of the position of the current player of the
+/// placement phase.
+///
+/// The key is a Zobrist-style hash of the board size, the placement
+/// parameters and the tiles, where the penguins are only distinguished as
+/// belonging to the current player or to the others, since that is all the
+/// bot can see. The board is hashed in all 8 orientations (the 4 rotations,
+/// each of them possibly mirrored), and the smallest hash is taken as the
+/// key. The number of the orientation which produced it is returned in @c
+/// out_transform: the bit 0 means that the board was flipped horizontally,
+/// the bit 1 that it was flipped vertically and the bit 2 that the rows were
+/// then swapped with the columns.
+uint64_t placement_book_key(const Game* game, const BotParameters* params, int* out_transform) {
+  int width = game->board_width, height = game->board_height;
+  short my_id = game_get_current_player(game)->id;
+  uint64_t best_key = 0;
+  int best_transform = 0;
+  for (int transform = 0; transform < 8; transform++) {
+    int canon_width = transform & 4 ? height : width;
+    int canon_height = transform & 4 ? width : height;
+    uint64_t key = splitmix64_mix(
+      PLACEMENT_BOOK_MAGIC ^ (uint64_t)canon_width ^ (uint64_t)canon_height << 16 ^
+      (uint64_t)params->placement_strategy << 32 ^ (uint64_t)params->placement_scan_area << 40
+    );
+    for (int y = 0; y < canon_height; y++) {
+      for (int x = 0; x < canon_width; x++) {
+        Coords coords = book_from_canonical((Coords){ x, y }, width, height, transform);
+        short tile = get_tile(game, coords);
+        uint64_t kind = 0;
+        if (is_fish_tile(tile)) {
+          kind = (uint64_t)tile;
+        } else if (is_penguin_tile(tile)) {
+          kind = get_tile_player_id(tile) == my_id ? 0x40 : 0x41;
+        }
+        if (kind != 0) {
+          key ^= splitmix64_mix((uint64_t)(x + canon_width * y) << 8 | kind);
+        }
+      }
+    }
+    if (transform == 0 || key < best_key) {
+      best_key = key;
+      best_transform = transform;
+    }
+  }
+  if (out_transform != NULL) *out_transform = best_transform;
+  return best_key;
+}
+
+/// @relatesalso PlacementBook
+/// @brief Looks up the placement for the current player, returns @c false if
+/// the position is not in the book.
+///
+/// The found placement is additionally validated, so a collision of the keys
+/// can at worst result in a legal, but bad move.
+bool placement_book_lookup(
+  const PlacementBook* self, const Game* game, const BotParameters* params, Coords* out_target
+) {
+  if (self == NULL || !placement_book_supports(params)) return false;
+  int transform;
+  uint64_t key = placement_book_key(game, params, &transform);
+  size_t low = 0, high = self->entries_count;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (self->entries[mid].key < key) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  if (low >= self->entries_count || self->entries[low].key != key) {
+    return false;
+  }
+  const PlacementBookEntry* entry = &self->entries[low];
+  int width = game->board_width, height = game->board_height;
+  int canon_width = transform & 4 ? height : width;
+  int canon_height = transform & 4 ? width : height;
+  if (!(0 <= entry->x && entry->x < canon_width && 0 <= entry->y && entry->y < canon_height)) {
+    return false;
+  }
+  Coords target = book_from_canonical((Coords){ entry->x, entry->y }, width, height, transform);
+  if (!validate_placement_simple(game, target)) {
+    return false;
+  }
+  *out_target = target;
+  return true;
+}
+
+typedef struct PlacementBookWorker {
+  Thread thread;
+  Game* const* games;
+  int games_count;
+  volatile int* next_game;
+  BotParameters params;
+  PlacementBookEntry* entries;
+  size_t entries_count;
+  size_t entries_cap;
+} PlacementBookWorker;
+
+static void placement_book_worker_main(void* arg) {
+  PlacementBookWorker* self = arg;
+  int game_idx;
+  while ((game_idx = atomic_fetch_add_int(self->next_game, 1)) < self->games_count) {
+    Game* game = game_clone(self->games[game_idx]);
+    Rng rng = init_random_rng();
+    BotState* bot = bot_state_new(&self->params, game, &rng);
+    placement_begin(game);
+    Coords target;
+    while (placement_switch_player(game) >= 0 && bot_compute_placement(bot, &target)) {
+      if (self->entries_count >= self->entries_cap) {
+        self->entries_cap = my_max(self->entries_cap * 2, 64);
+        self->entries = realloc(self->entries, sizeof(*self->entries) * self->entries_cap);
+      }
+      int transform;
+      PlacementBookEntry* entry = &self->entries[self->entries_count++];
+      entry->key = placement_book_key(game, &self->params, &transform);
+      Coords canon = book_to_canonical(target, game->board_width, game->board_height, transform);
+      entry->x = canon.x, entry->y = canon.y;
+      place_penguin(game, target);
+    }
+    bot_state_free(bot);
+    game_free(game);
+  }
+}
+
+/// @relatesalso PlacementBook
+/// @brief Plays out the placement phase of every game with the bot and
+/// collects the placements it has made into a sorted array of book entries.
+///
+/// The games must be set up (in the #GAME_PHASE_SETUP_DONE phase) and are
+/// not modified, they are distributed between @c threads_count threads (or
+/// as many as there are CPUs if it is zero or less). The returned array is
+/// allocated with @c malloc and must be freed by the caller.
+size_t placement_book_build(
+  Game* const* games,
+  int games_count,
+  const BotParameters* params,
+  int threads_count,
+  PlacementBookEntry** out_entries
+) {
+  assert(placement_book_supports(params));
+  if (threads_count <= 0) threads_count = get_cpu_count();
+  threads_count = my_max(1, my_min(threads_count, games_count));
+  volatile int next_game = 0;
+  PlacementBookWorker* workers = malloc(sizeof(*workers) * threads_count);
+  for (int i = 0; i < threads_count; i++) {
+    PlacementBookWorker* worker = &workers[i];
+    worker->games = games;
+    worker->games_count = games_count;
+    worker->next_game = &next_game;
+    worker->params = *params;
+    // The parallelism is already achieved by giving a game to every thread.
+    worker->params.threads_count = 1;
+    worker->entries = NULL;
+    worker->entries_count = worker->entries_cap = 0;
+  }
+  // The calling thread takes part in the work as well.
+  int spawned = 1;
+  while (spawned < threads_count &&
+         thread_spawn(&workers[spawned].thread, &placement_book_worker_main, &workers[spawned])) {
+    spawned++;
+  }
+  placement_book_worker_main(&workers[0]);
+  size_t total_count = 0;
+  for (int i = 0; i < spawned; i++) {
+    if (i != 0) thread_join(&workers[i].thread);
+    total_count += workers[i].entries_count;
+  }
+
+  PlacementBookEntry* entries = malloc(sizeof(*entries) * my_max(total_count, 1));
+  size_t offset = 0;
+  for (int i = 0; i < spawned; i++) {
+    for (size_t j = 0; j < workers[i].entries_count; j++) {
+      entries[offset++] = workers[i].entries[j];
+    }
+    free(workers[i].entries);
+  }
+  free(workers);
+  *out_entries = entries;
+  return placement_book_sort_entries(entries, total_count);
+}
+
+/// @brief An entry together with its position in the unsorted array, see
+/// #placement_book_sort_entries.
+typedef struct IndexedBookEntry {
+  PlacementBookEntry entry;
+  size_t index;
+} IndexedBookEntry;
+
+static int compare_book_entries(const void* a, const void* b) {
+  const IndexedBookEntry* entry_a = a;
+  const IndexedBookEntry* entry_b = b;
+  uint64_t key_a = entry_a->entry.key, key_b = entry_b->entry.key;
+  if (key_a != key_b) return key_a < key_b ? -1 : 1;
+  // qsort isn't stable, the ties are broken by the original order instead.
+  return entry_a->index < entry_b->index ? -1 : entry_a->index > entry_b->index ? 1 : 0;
+}
+
+/// @relatesalso PlacementBook
+/// @brief Sorts the entries by their keys and removes the duplicate keys.
+/// Out of the entries with the same key the one which comes first in the
+/// array is kept, so when merging books the newer entries should be put
+/// before the older ones.
+/// @returns The new number of entries.
+size_t placement_book_sort_entries(PlacementBookEntry* entries, size_t count) {
+  if (count == 0) return 0;
+  IndexedBookEntry* indexed = malloc(sizeof(*indexed) * count);
+  for (size_t i = 0; i < count; i++) {
+    indexed[i].entry = entries[i];
+    indexed[i].index = i;
+  }
+  qsort(indexed, count, sizeof(*indexed), &compare_book_entries);
+  size_t unique_count = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (i == 0 || indexed[i].entry.key != indexed[i - 1].entry.key) {
+      entries[unique_count++] = indexed[i].entry;
+    }
+  }
+  free(indexed);
+  return unique_count;
+}
+
+/// @relatesalso PlacementBook
+/// @brief Writes a book file for #placement_book_open. The entries are sorted
+/// with #placement_book_sort_entries in the process.
+/// @returns @c false on I/O errors, @c errno is set accordingly.
+bool placement_book_write(const char* path, PlacementBookEntry* entries, size_t count) {
+  count = placement_book_sort_entries(entries, count);
+  if (count > UINT32_MAX) return false;
+  FILE* file = fopen(path, "wb");
+  if (file == NULL) return false;
+  PlacementBookHeader header;
+  header.magic = PLACEMENT_BOOK_MAGIC;
+  header.version = PLACEMENT_BOOK_VERSION;
+  header.entries_count = (uint32_t)count;
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+            fwrite(entries, sizeof(*entries), count, file) == count;
+  ok = fclose(file) == 0 && ok;
+  return ok;
+}
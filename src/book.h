@@ -0,0 +1,86 @@
+#pragma once
+
+/// @file
+/// @brief The opening book of the placement phase
+/// @see bot.h
+
+#include "bot.h"
+#include "game.h"
+#include "utils.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief The signature at the start of the book files, also tells apart
+/// files written on machines of the other endianness.
+#define PLACEMENT_BOOK_MAGIC 0x4b4f4f42474e5050ULL // "PPNGBOOK"
+/// @brief Bumped whenever the format of the keys or of the entries changes.
+#define PLACEMENT_BOOK_VERSION 1
+
+/// @brief The header of a book file, followed by the sorted array of
+/// #PlacementBookEntry.
+typedef struct PlacementBookHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t entries_count;
+} PlacementBookHeader;
+
+/// @brief A single position of the #PlacementBook.
+typedef struct PlacementBookEntry {
+  /// The canonical key of the position, see #placement_book_key.
+  uint64_t key;
+  /// The best placement in the canonical orientation of the board.
+  int32_t x, y;
+} PlacementBookEntry;
+
+/// @brief A precomputed table of the best placements for the positions of
+/// the placement phase.
+///
+/// Computing a good placement takes a considerable amount of time on large
+/// boards, yet at the start of a game the board is usually one of a few
+/// generated ones, so the answers can be prepared offline (with
+/// #placement_book_build) and just looked up during the game. The book is a
+/// file with a sorted array of #PlacementBookEntry, it is memory-mapped, so
+/// opening it costs nothing regardless of its size and it is searched with a
+/// binary search.
+///
+/// The positions are keyed by #placement_book_key, which identifies the
+/// boards that differ only by a rotation or a reflection and only looks at
+/// what the placement algorithms look at, so a single entry covers up to 8
+/// orientations of a board and does not care about the IDs of the players.
+typedef struct PlacementBook {
+  const PlacementBookEntry* entries;
+  size_t entries_count;
+  /// The start of the mapped file.
+  void* mapping;
+  size_t mapping_size;
+#ifdef _WIN32
+  /// The @c HANDLE of the file mapping object.
+  void* mapping_handle;
+#endif
+} PlacementBook;
+
+PlacementBook* placement_book_open(const char* path);
+void placement_book_free(PlacementBook* self);
+bool placement_book_supports(const BotParameters* params);
+uint64_t placement_book_key(const Game* game, const BotParameters* params, int* out_transform);
+bool placement_book_lookup(
+  const PlacementBook* self, const Game* game, const BotParameters* params, Coords* out_target
+);
+size_t placement_book_build(
+  Game* const* games,
+  int games_count,
+  const BotParameters* params,
+  int threads_count,
+  PlacementBookEntry** out_entries
+);
+size_t placement_book_sort_entries(PlacementBookEntry* entries, size_t count);
+bool placement_book_write(const char* path, PlacementBookEntry* entries, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,9 +2,7 @@
 // memory of how chess bots work, plus some non-trivial on-the-spot solutions.
 // The code leaves a lot to be desired: it is very inefficient (it has to
 // evaluate a lot of useless moves, performs some costly calculations twice
-// etc), is generally a spaghetti mess, and also apparently I have implemented
-// cancellation incorrectly (the sub states don't see it since the `cancelled`
-// flag is set only on the root state), but I think it's best to leave it in
+// etc) and is generally a spaghetti mess, but I think it's best to leave it in
 // this imperfect state.
 //
 // If ever desired, here are some nice projects from which some inspiration
@@ -14,15 +12,25 @@
 // <https://github.com/ethiery/HeyThatsMyFish>
 
 #include "bot.h"
+#include "bitboard.h"
 #include "board.h"
+#include "endgame.h"
 #include "game.h"
+#include "junctions.h"
+#include "mcts.h"
 #include "movement.h"
 #include "placement.h"
+#include "position.h"
+#include "regions.h"
+#include "search.h"
+#include "threading.h"
+#include "transposition.h"
 #include "utils.h"
 #include <assert.h>
 #include <limits.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -35,18 +43,47 @@ void init_bot_parameters(BotParameters* self) {
   self->max_move_length = INT_MAX;
   self->recursion_limit = 4;
   self->junction_check_recursion_limit = 2;
+  self->transposition_table_size = 1 << 16;
+  self->adversarial_mode = BOT_ADVERSARIAL_PARANOID;
+  self->search_depth = 5;
+  self->time_limit_ms = 0;
+  self->threads_count = 1;
+  self->mcts_iterations = 20000;
+  self->endgame_tile_limit = 40;
 }
 
+#ifndef NDEBUG
+volatile int64_t bot_debug_allocations = 0;
+#endif
+
 /// @relatedalso BotState
-/// @brief Constructs a #BotState (similarly #game_new).
-BotState* bot_state_new(const BotParameters* params, Game* game, Rng* rng) {
-  BotState* self = malloc(sizeof(*self));
+/// @brief Initializes all fields of a #BotState, used by #bot_state_new and
+/// for the frames of the #BotSearchStack.
+static void bot_state_init(BotState* self, const BotParameters* params, Game* game, Rng* rng) {
   self->params = params;
   self->game = game;
   self->rng = rng;
+  self->bitboard = NULL;
+  self->position = NULL;
+  self->junctions = NULL;
+  self->region_map = NULL;
+  self->transposition_table = NULL;
+  self->transposition_salt = 0;
   self->substate = NULL;
   self->depth = 0;
-  self->cancelled = false;
+  self->recursion_limit = params->recursion_limit;
+  self->placement_scan_area = params->placement_scan_area;
+  self->workers = NULL;
+  self->workers_count = 0;
+  self->mcts_random_state = 0;
+  self->own_stop.cancelled = false;
+  self->own_stop.timed_out = false;
+  self->own_stop.deadline = 0;
+  self->own_stop.clock_countdown = 0;
+  self->own_stop.parent = NULL;
+  self->stop = &self->own_stop;
+  self->search_stack = NULL;
+  self->in_search_stack = false;
 
   self->tile_coords_cap = 0;
   self->tile_coords = NULL;
@@ -61,52 +98,566 @@ BotState* bot_state_new(const BotParameters* params, Game* game, Rng* rng) {
   self->move_scores = NULL;
   self->fill_grid1_cap = 0;
   self->fill_grid1 = NULL;
-  self->fill_grid2_cap = 0;
-  self->fill_grid2 = NULL;
   self->fill_stack_cap = 0;
   self->fill_stack = NULL;
+  self->fill_planes_cap = 0;
+  self->fill_planes = NULL;
+  self->placement_kinds_cap = 0;
+  self->placement_kinds = NULL;
+  self->placement_weights_cap = 0;
+  self->placement_weights = NULL;
+  self->placement_grid_cap = 0;
+  self->placement_grid = NULL;
+  self->placement_scores_cap = 0;
+  self->placement_scores = NULL;
+  self->placement_scores_area = -1;
+  self->placement_scores_width = 0;
+  self->placement_scores_height = 0;
+  self->placement_kinds_count = 0;
+  self->search_values_cap = 0;
+  self->search_values = NULL;
+  self->mcts_nodes_cap = 0;
+  self->mcts_nodes = NULL;
+  self->mcts_steps_cap = 0;
+  self->mcts_steps = NULL;
+  self->endgame_memo_cap = 0;
+  self->endgame_memo = NULL;
+}
 
+/// @relatedalso BotState
+/// @brief Constructs a #BotState (similarly #game_new).
+BotState* bot_state_new(const BotParameters* params, Game* game, Rng* rng) {
+  BotState* self = malloc(sizeof(*self));
+  bot_count_allocation();
+  bot_state_init(self, params, game, rng);
   return self;
 }
 
+/// @relatedalso BotState
+/// @brief Destroys the #BotState::workers.
+static void bot_free_workers(BotState* self) {
+  for (int i = 0; i < self->workers_count; i++) {
+    // The table belongs to the base state.
+    if (self->workers[i].state != NULL) self->workers[i].state->transposition_table = NULL;
+    bot_state_free(self->workers[i].state);
+    game_free(self->workers[i].game);
+  }
+  free_and_clear(self->workers);
+  self->workers_count = 0;
+}
+
 /// @relatedalso BotState
 /// @brief Recursively destroys a #BotState and its substates (similarly to
 /// #game_free).
 void bot_state_free(BotState* self) {
+  BotSearchStack* stack = self != NULL ? self->search_stack : NULL;
   while (self != NULL) {
+    bool in_search_stack = self->in_search_stack;
+    if (in_search_stack) {
+      // These belong to the arena.
+      self->tile_coords = NULL;
+      self->possible_steps = NULL;
+      self->all_moves = NULL;
+      self->move_scores = NULL;
+      self->search_values = NULL;
+    }
     free_and_clear(self->tile_coords);
     free_and_clear(self->tile_scores);
     free_and_clear(self->possible_steps);
     free_and_clear(self->all_moves);
     free_and_clear(self->move_scores);
     free_and_clear(self->fill_grid1);
-    free_and_clear(self->fill_grid2);
     free_and_clear(self->fill_stack);
+    free_and_clear(self->fill_planes);
+    free_and_clear(self->placement_kinds);
+    free_and_clear(self->placement_weights);
+    free_and_clear(self->placement_grid);
+    free_and_clear(self->placement_scores);
+    free_and_clear(self->search_values);
+    free_and_clear(self->mcts_nodes);
+    free_and_clear(self->mcts_steps);
+    free_and_clear(self->endgame_memo);
+    junctions_free(self->junctions);
+    self->junctions = NULL;
+    if (self->depth == 0) {
+      bitboard_free(self->bitboard);
+      search_position_free(self->position);
+      region_map_free(self->region_map);
+      transposition_table_free(self->transposition_table);
+      bot_free_workers(self);
+    }
+    self->bitboard = NULL;
+    self->position = NULL;
+    self->region_map = NULL;
+    self->transposition_table = NULL;
     BotState* next = self->substate;
     self->substate = NULL;
-    free(self);
+    self->search_stack = NULL;
+    if (!in_search_stack) free(self);
     self = next;
   }
+  // The frames are freed only now since the chain runs through them.
+  if (stack != NULL) {
+    free(stack->arena);
+    free(stack);
+  }
 }
 
 /// @relatedalso BotState
 /// @brief Allocates #BotState::substate if necessary and returns it.
+///
+/// Once the #BotSearchStack has been prepared, the substates are the frames of
+/// its arena and no allocation happens here, unless the recursion goes deeper
+/// than the stack.
 BotState* bot_enter_substate(BotState* self) {
   if (self->substate == NULL) {
     self->substate = bot_state_new(self->params, self->game, self->rng);
     self->substate->depth = self->depth + 1;
   }
+  self->substate->stop = self->stop;
+  self->substate->bitboard = self->bitboard;
+  self->substate->position = self->position;
+  self->substate->region_map = self->region_map;
+  self->substate->transposition_table = self->transposition_table;
+  self->substate->transposition_salt = self->transposition_salt;
+  self->substate->recursion_limit = self->recursion_limit;
+  self->substate->placement_scan_area = self->placement_scan_area;
   return self->substate;
 }
 
-/// @brief A helper for allocating the buffers cached within the #BotState.
+/// @relatedalso BotState
+/// @brief Updates the #BotState::junctions and (if it is used) the
+/// #BotState::region_map to the #BotState::position, which is the root of the
+/// search, see #bot_rate_moves_list.
+static void bot_analyze_junctions(BotState* self) {
+  assert(self->depth == 0 && self->junctions != NULL);
+  const SearchPosition* position = self->position;
+  junctions_analyze_grid(
+    self->junctions, position->grid, position->board_width, position->board_height
+  );
+  if (self->region_map != NULL) {
+    // The moves are applied to the map down to the deepest junction check.
+    int max_moves = self->params->junction_check_recursion_limit + 1;
+    region_map_load(self->region_map, position, max_moves);
+  }
+}
+
+/// @brief Rounds the size of a part of a #BotSearchStack frame up, so that all
+/// parts stay aligned.
+static inline size_t bot_frame_align(size_t size) {
+  return (size + 15) & ~(size_t)15;
+}
+
+/// @relatedalso BotState
+/// @brief Makes sure that the #BotState::search_stack fits the current #Game
+/// and #BotParameters, (re)creating it if necessary. Must be called on the
+/// base state.
+///
+/// The number of frames is the deepest recursion the movement strategy can
+/// reach, the capacities of their buffers are the upper bounds for any
+/// position on the board: every penguin of every player can be moved at most
+/// <tt>w - 1</tt> tiles horizontally and <tt>h - 1</tt> tiles vertically. The
+/// buffers of the base state are reserved at the same capacities. For the
+/// smart strategy the #BotState::position (which must be loaded) is also
+/// analyzed for the junction checks with #bot_analyze_junctions, which
+/// allocates the grids of the analysis. After this no heap allocations happen
+/// during #bot_compute_move.
+void bot_prepare_search_stack(BotState* self) {
+  assert(self->depth == 0);
+  const BotParameters* params = self->params;
+  const Game* game = self->game;
+  int depth = 0;
+  if (params->movement_strategy == BOT_MOVEMENT_SMART) {
+    depth = params->recursion_limit;
+  } else if (params->movement_strategy == BOT_MOVEMENT_ADVERSARIAL) {
+    // Half of the helper threads of bot_search_move go one level deeper.
+    depth = params->search_depth + 1;
+  }
+  depth = my_max(depth, 0);
+  size_t max_players = (size_t)my_max(game->players_count, 0);
+  size_t max_penguins = max_players * (size_t)my_max(game->penguins_per_player, 0);
+  size_t max_moves =
+    max_penguins * (size_t)my_max(game->board_width + game->board_height - 2, 0);
+
+  // The base state is allocated by the caller, its buffers are simply reserved.
+  size_t search_values_size = 2 * max_players;
+  bot_alloc_buf(self->possible_steps, self->possible_steps_cap, max_penguins);
+  bot_alloc_buf(self->tile_coords, self->tile_coords_cap, max_penguins);
+  bot_alloc_buf(self->all_moves, self->all_moves_cap, max_moves);
+  bot_alloc_buf(self->move_scores, self->move_scores_cap, max_moves);
+  bot_alloc_buf(self->search_values, self->search_values_cap, search_values_size);
+  if (params->movement_strategy == BOT_MOVEMENT_MCTS) {
+    // Every move of a playout takes away a tile. The playouts don't go through
+    // the substates, so the stack of the MCTS has no frames at all.
+    size_t tiles_count = (size_t)game->board_width * game->board_height;
+    bot_alloc_buf(self->mcts_steps, self->mcts_steps_cap, tiles_count);
+  }
+
+  if (params->movement_strategy == BOT_MOVEMENT_SMART) {
+    if (self->junctions == NULL) {
+      self->junctions = junctions_new();
+      bot_count_allocation();
+    }
+    // The map is needed only for the junction checks below the root.
+    if (params->junction_check_recursion_limit > 0 && self->region_map == NULL) {
+      self->region_map = region_map_new();
+      bot_count_allocation();
+    } else if (params->junction_check_recursion_limit <= 0 && self->region_map != NULL) {
+      region_map_free(self->region_map);
+      self->region_map = NULL;
+    }
+    bot_analyze_junctions(self);
+  }
+
+  BotSearchStack* stack = self->search_stack;
+  if (stack != NULL && stack->frames_count >= depth && stack->max_players >= max_players &&
+      stack->max_penguins >= max_penguins && stack->max_moves >= max_moves) {
+    return;
+  }
+  // The old frames (plus the substates allocated past them) are discarded.
+  bot_state_free(self->substate);
+  self->substate = NULL;
+  if (stack == NULL) {
+    stack = malloc(sizeof(*stack));
+    bot_count_allocation();
+    stack->arena = NULL;
+    self->search_stack = stack;
+  }
+  free(stack->arena);
+  stack->arena = NULL;
+  stack->frames_count = depth;
+  stack->max_players = max_players;
+  stack->max_penguins = max_penguins;
+  stack->max_moves = max_moves;
+  size_t state_size = bot_frame_align(sizeof(BotState));
+  size_t steps_size = bot_frame_align(sizeof(PossibleSteps) * max_penguins);
+  size_t coords_size = bot_frame_align(sizeof(Coords) * max_penguins);
+  size_t moves_size = bot_frame_align(sizeof(BotMove) * max_moves);
+  size_t scores_size = bot_frame_align(sizeof(int) * max_moves);
+  size_t values_size = bot_frame_align(sizeof(int) * search_values_size);
+  stack->frame_size =
+    state_size + steps_size + coords_size + moves_size + scores_size + values_size;
+  if (depth == 0) return;
+  stack->arena = malloc(stack->frame_size * depth);
+  bot_count_allocation();
+
+  BotState* parent = self;
+  for (int i = 0; i < depth; i++) {
+    char* frame = (char*)stack->arena + stack->frame_size * i;
+    BotState* sub = (BotState*)frame;
+    bot_state_init(sub, params, self->game, self->rng);
+    sub->depth = i + 1;
+    sub->in_search_stack = true;
+    frame += state_size;
+    sub->possible_steps = (PossibleSteps*)frame;
+    sub->possible_steps_cap = max_penguins;
+    frame += steps_size;
+    sub->tile_coords = (Coords*)frame;
+    sub->tile_coords_cap = max_penguins;
+    frame += coords_size;
+    sub->all_moves = (BotMove*)frame;
+    sub->all_moves_cap = max_moves;
+    frame += moves_size;
+    sub->move_scores = (int*)frame;
+    sub->move_scores_cap = max_moves;
+    frame += scores_size;
+    sub->search_values = (int*)frame;
+    sub->search_values_cap = search_values_size;
+    parent->substate = sub;
+    parent = sub;
+  }
+}
+
+/// @relatedalso BotState
+/// @brief Reserves the buffers which are used by #bot_compute_move only in the
+/// base state, and not in the #BotState::workers: those of #bot_solve_endgame
+/// and the tree of #bot_mcts_move. The #BotState::bitboard must be loaded.
+static void bot_prepare_base_buffers(BotState* self) {
+  const BotParameters* params = self->params;
+  BotMovementStrategy strategy = params->movement_strategy;
+  if (strategy != BOT_MOVEMENT_SMART && strategy != BOT_MOVEMENT_ADVERSARIAL &&
+      strategy != BOT_MOVEMENT_MCTS) {
+    return;
+  }
+  if (params->endgame_tile_limit > 0) {
+    // This reserves the mask of the fills as well.
+    bot_flood_fill_reset_grid(self, &self->fill_grid1, &self->fill_grid1_cap);
+    bot_alloc_buf(self->endgame_memo, self->endgame_memo_cap, ENDGAME_MEMO_SIZE);
+  }
+  if (strategy == BOT_MOVEMENT_MCTS) {
+    // The root plus a node per iteration, see bot_mcts_move.
+    bot_alloc_buf(self->mcts_nodes, self->mcts_nodes_cap, my_max(params->mcts_iterations, 1) + 1);
+  }
+}
+
+/// @relatedalso BotState
+/// @brief Points the #BotState and all of its substates to another #Game. The
+/// caches of the bot are kept, which is useful for reusing a single state
+/// across the turns of a whole game.
+void bot_state_set_game(BotState* self, Game* game) {
+  for (; self != NULL; self = self->substate) {
+    self->game = game;
+  }
+}
+
+/// @relatedalso BotState
+/// @brief Applies a move to the #BotState::position on behalf of the owner of
+/// the penguin and updates the #BotState::bitboard accordingly. Must be paired
+/// with #bot_undo_move.
+void bot_make_move(BotState* self, BotMove move) {
+  SearchPosition* position = self->position;
+  search_position_make_move(position, move.penguin, move.target);
+  short penguin_tile = search_position_get_tile(position, move.target);
+  int owner = search_position_penguin_owner(position, move.target);
+  bitboard_set_tile(self->bitboard, move.penguin, WATER_TILE, -1);
+  bitboard_set_tile(self->bitboard, move.target, penguin_tile, owner);
+}
+
+/// @relatedalso BotState
+/// @brief Undoes a move previously applied with #bot_make_move.
+void bot_undo_move(BotState* self, BotMove move) {
+  SearchPosition* position = self->position;
+  search_position_unmake_move(position);
+  short penguin_tile = search_position_get_tile(position, move.penguin);
+  short target_tile = search_position_get_tile(position, move.target);
+  int owner = search_position_penguin_owner(position, move.penguin);
+  bitboard_set_tile(self->bitboard, move.penguin, penguin_tile, owner);
+  bitboard_set_tile(self->bitboard, move.target, target_tile, -1);
+}
+
+/// @relatedalso BotState
+/// @brief Checks whether the computation should be stopped, either because it
+/// was cancelled (see #BotStopToken::cancelled) or because the
+/// #BotStopToken::deadline has passed.
+///
+/// The token is shared by all substates, so this can be called at any depth
+/// of the recursion to unwind it as soon as possible.
+bool bot_should_stop(BotState* self) {
+  BotStopToken* token = self->stop;
+  if (token->cancelled || token->timed_out) return true;
+  const BotStopToken* parent = token->parent;
+  if (parent != NULL && (parent->cancelled || parent->timed_out)) return true;
+  if (token->deadline == 0 || --token->clock_countdown > 0) return false;
+  token->clock_countdown = BOT_STOP_CHECK_INTERVAL;
+  if (get_monotonic_time_ms() >= token->deadline) {
+    token->timed_out = true;
+  }
+  return token->timed_out;
+}
+
+/// @relatedalso BotState
+/// @brief Cancels the computation running on the #BotState, can be called
+/// from another thread.
+void bot_cancel(BotState* self) {
+  self->stop->cancelled = true;
+}
+
+/// @relatedalso BotState
+/// @brief Starts the time budget of #BotParameters::time_limit_ms, which is
+/// enforced after the first iteration of the search has been completed.
+/// @returns The deadline, zero if there is no limit.
+uint64_t bot_start_timer(BotState* self) {
+  self->stop->deadline = 0;
+  self->stop->timed_out = false;
+  self->stop->clock_countdown = 0;
+  int time_limit = self->params->time_limit_ms;
+  return time_limit > 0 ? get_monotonic_time_ms() + (uint64_t)time_limit : 0;
+}
+
+/// @relatedalso BotState
+/// @brief (Re)allocates the #BotState::transposition_table according to the
+/// #BotParameters and starts a new generation in it.
+static void bot_prepare_transposition_table(BotState* self) {
+  const BotParameters* params = self->params;
+  TranspositionTable* table = self->transposition_table;
+  if (params->transposition_table_size == 0) {
+    transposition_table_free(table);
+    self->transposition_table = NULL;
+    self->transposition_salt = 0;
+    return;
+  }
+  if (table == NULL || transposition_table_size(table) > params->transposition_table_size ||
+      transposition_table_size(table) * 2 <= params->transposition_table_size) {
+    transposition_table_free(table);
+    self->transposition_table = transposition_table_new(params->transposition_table_size);
+  }
+  transposition_table_next_generation(self->transposition_table);
+}
+
+/// @relatedalso BotState
+/// @brief Derives the #BotState::transposition_salt from the parameters of the
+/// current iteration of the search.
+static void bot_update_transposition_salt(BotState* self) {
+  const BotParameters* params = self->params;
+  // The cached scores are valid only for the same parameters of the search.
+  uint64_t salt = (uint64_t)(uint32_t)self->recursion_limit;
+  salt = splitmix64_mix(salt ^ (uint64_t)(uint32_t)params->junction_check_recursion_limit << 32);
+  salt = splitmix64_mix(salt ^ (uint32_t)params->max_move_length);
+  self->transposition_salt = salt;
+}
+
+/// @brief Checks if the board and the players of @c base can be copied into
+/// @c game in place, i.e. they have the same dimensions and the same numbers
+/// of penguins.
+static bool bot_worker_game_matches(const Game* game, const Game* base) {
+  if (game == NULL || game->phase != base->phase) return false;
+  if (game->board_width != base->board_width || game->board_height != base->board_height) {
+    return false;
+  }
+  if (game->players_count != base->players_count ||
+      game->penguins_per_player != base->penguins_per_player) {
+    return false;
+  }
+  for (int i = 0; i < base->players_count; i++) {
+    if (game->players[i].penguins_count != base->players[i].penguins_count) return false;
+  }
+  return true;
+}
+
+/// @relatedalso BotState
+/// @brief (Re)creates the #BotState::workers according to
+/// #BotParameters::threads_count and brings their copies of the #Game up to
+/// date. The #BotState::transposition_table is shared with the workers, so it
+/// must be prepared first, and the #BotState::position must be loaded.
 ///
-/// Checks if the buffer has enough capacity for data of the requested size, if
-/// not -- reallocates it at the requested size. The @c capacity and @c size
-/// arguments are the number of elements (not the number of bytes), and are
-/// implicitly converted to @c size_t (the multiplication by 1 is used for that).
-#define bot_alloc_buf(buf, capacity, size) \
-  ((size_t)1 * size > capacity ? (buf = realloc(buf, sizeof(*buf) * size), capacity = size) : 0)
+/// Normally the workers keep their games between the turns and just get the
+/// position written into them, the games are cloned only when the layout of
+/// the board or the players changes (e.g. a new game has been started).
+static void bot_prepare_workers(BotState* self) {
+  int threads_count = self->params->threads_count;
+  if (threads_count <= 0) threads_count = get_cpu_count();
+  int workers_count = threads_count - 1;
+  if (workers_count != self->workers_count) {
+    bot_free_workers(self);
+    if (workers_count > 0) {
+      self->workers = calloc(workers_count, sizeof(*self->workers));
+      bot_count_allocation();
+      self->workers_count = workers_count;
+    }
+  }
+  for (int i = 0; i < self->workers_count; i++) {
+    BotWorker* worker = &self->workers[i];
+    if (bot_worker_game_matches(worker->game, self->game)) {
+      search_position_store(self->position, worker->game);
+    } else {
+      game_free(worker->game);
+      worker->game = game_clone(self->game);
+      bot_count_allocation();
+      // The workers never undo anything in their games.
+      worker->game->log_disabled = true;
+      if (worker->state != NULL) bot_state_set_game(worker->state, worker->game);
+    }
+    if (worker->state == NULL) {
+      worker->state = bot_state_new(self->params, worker->game, self->rng);
+      worker->state->bitboard = bitboard_new();
+      worker->state->position = search_position_new();
+      bot_count_allocation();
+    }
+    bitboard_load_game(worker->state->bitboard, worker->game);
+    search_position_load(worker->state->position, worker->game);
+    bot_prepare_search_stack(worker->state);
+    worker->state->transposition_table = self->transposition_table;
+    worker->state->own_stop.parent = self->stop;
+  }
+}
+
+/// @relatedalso BotState
+/// @brief Checks whether the movement strategy hands any work to the
+/// #BotState::workers (see #BotWorker), so that they aren't prepared for
+/// nothing.
+static bool bot_movement_uses_workers(const BotState* self) {
+  const BotParameters* params = self->params;
+  switch (params->movement_strategy) {
+    case BOT_MOVEMENT_SMART: return true;
+    case BOT_MOVEMENT_MCTS: return true;
+    // The same condition as for spawning the helpers in #bot_search_move.
+    case BOT_MOVEMENT_ADVERSARIAL:
+      return self->transposition_table != NULL &&
+             params->adversarial_mode != BOT_ADVERSARIAL_MAX_N;
+    default: return false;
+  }
+}
+
+/// @brief The shared state of a single run of #bot_rate_moves_in_parallel.
+typedef struct BotParallelJob {
+  const BotMove* moves;
+  int moves_count;
+  /// Receives the results of #bot_rate_move for every move.
+  int* scores;
+  /// The index of the next move to be evaluated by any of the threads.
+  volatile int next_move;
+} BotParallelJob;
+
+/// @relatedalso BotState
+/// @brief Evaluates the moves of the job until none are left.
+/// @returns @c false if the computation was stopped.
+static bool bot_run_parallel_job(BotState* self, BotParallelJob* job) {
+  while (true) {
+    int i = atomic_fetch_add_int(&job->next_move, 1);
+    if (i >= job->moves_count) return true;
+    job->scores[i] = bot_rate_move(self, job->moves[i]);
+    if (bot_should_stop(self)) return false;
+  }
+}
+
+static void bot_worker_main(void* arg) {
+  BotWorker* worker = arg;
+  BotParallelJob* job = worker->job;
+  worker->stopped = !bot_run_parallel_job(worker->state, job);
+}
+
+/// @relatedalso BotState
+/// @brief Computes #bot_rate_move for every move in the list on the
+/// #BotState::workers and the calling thread, the results are written to
+/// #BotState::move_scores.
+/// @returns @c false if there are no workers to share the work with.
+static bool bot_rate_moves_in_parallel(BotState* self, int moves_count, BotMove* moves_list) {
+  if (self->workers_count == 0 || moves_count < 2) return false;
+  BotParallelJob job;
+  job.moves = moves_list;
+  job.moves_count = moves_count;
+  job.scores = self->move_scores;
+  job.next_move = 0;
+
+  for (int i = 0; i < self->workers_count; i++) {
+    BotWorker* worker = &self->workers[i];
+    BotState* state = worker->state;
+    state->recursion_limit = self->recursion_limit;
+    state->transposition_salt = self->transposition_salt;
+    state->stop->deadline = self->stop->deadline;
+    state->stop->timed_out = false;
+    state->stop->cancelled = false;
+    state->stop->clock_countdown = 0;
+    worker->stopped = false;
+    worker->job = &job;
+    if (!thread_spawn(&worker->thread, &bot_worker_main, worker)) {
+      // Not a big deal, the remaining threads will pick up the slack.
+      worker->job = NULL;
+    }
+  }
+
+  // The workers notice the cancellation or the deadline by themselves.
+  bot_run_parallel_job(self, &job);
+
+  for (int i = 0; i < self->workers_count; i++) {
+    BotWorker* worker = &self->workers[i];
+    if (worker->job == NULL) continue;
+    thread_join(&worker->thread);
+    worker->job = NULL;
+    if (worker->stopped) self->stop->timed_out = true;
+  }
+  return true;
+}
+
+/// @relatedalso BotState
+/// @brief Computes the key of the #BotState::transposition_table for the
+/// current position of the #Game with the penguin at @c penguin being the one
+/// evaluated at the current depth.
+static inline uint64_t bot_transposition_key(const BotState* self, Coords penguin) {
+  uint64_t x = (uint16_t)penguin.x, y = (uint16_t)penguin.y, depth = (uint16_t)self->depth;
+  return self->position->zobrist_key ^
+         splitmix64_mix(self->transposition_salt ^ (x << 32 | y << 16 | depth));
+}
 
 /// @details The only distance function that is relevant for us since penguins
 /// can move only along the axes.
@@ -115,6 +666,8 @@ static inline int distance(Coords start, Coords end) {
   return abs(end.x - start.x) + abs(end.y - start.y);
 }
 
+static int bot_rate_move_consequences(BotState* self, BotMove move);
+
 static int pick_best_score(int scores_length, int* scores) {
   int best_index = -1;
   int best_score = INT_MIN;
@@ -128,6 +681,268 @@ static int pick_best_score(int scores_length, int* scores) {
   return best_index;
 }
 
+/// @brief The contribution of a tile with the given score at the distance @c d
+/// from the penguin to the score of the placement, see #bot_rate_placement.
+static inline int placement_tile_weight(int tile_score, int d) {
+  const int DIV_PRECISION = 1000;
+  // The further away the tile is from the penguin, the less effect it
+  // should have on the calculation
+  return tile_score * 4 * DIV_PRECISION / (d * d + 1) / DIV_PRECISION;
+}
+
+/// @brief The kinds of tiles distinguished by #bot_rate_placement, used as
+/// the indexes of the weight tables by #bot_rate_all_placements. The tiles
+/// with @c n fish are of the kind <tt>PLACEMENT_TILE_FISH + n - 1</tt>.
+enum PlacementTileKind {
+  PLACEMENT_TILE_OUTSIDE,
+  PLACEMENT_TILE_WATER,
+  PLACEMENT_TILE_MY_PENGUIN,
+  PLACEMENT_TILE_PENGUIN,
+  PLACEMENT_TILE_FISH,
+};
+
+/// @brief The score of a tile of the given #PlacementTileKind, see #bot_rate_placement.
+static int placement_tile_kind_score(int kind) {
+  switch (kind) {
+    case PLACEMENT_TILE_OUTSIDE: return 10;
+    case PLACEMENT_TILE_WATER: return -40;
+    case PLACEMENT_TILE_MY_PENGUIN: return -500;
+    case PLACEMENT_TILE_PENGUIN: return -600;
+    default: return 10 * (kind - PLACEMENT_TILE_FISH + 1);
+  }
+}
+
+/// @relatedalso BotState
+/// @brief The #BOT_PLACEMENT_MOST_FISH part of #bot_rate_all_placements.
+///
+/// The fish within a window are counted in constant time with a summed-area
+/// table, in which every element is the total number of fish in the rectangle
+/// between the top left corner of the board and the corresponding tile.
+///
+/// @see <https://en.wikipedia.org/wiki/Summed-area_table>
+static void bot_rate_all_placements_by_fish(
+  BotState* self, int tiles_count, const Coords* tiles
+) {
+  Game* game = self->game;
+  int w = game->board_width, h = game->board_height;
+  int area = self->placement_scan_area;
+  // The table has an extra row and column of zeroes at the top and on the
+  // left, so that the windows touching the edges need no special handling.
+  int stride = w + 1;
+  bot_alloc_buf(self->placement_grid, self->placement_grid_cap, stride * (h + 1));
+  int* sums = self->placement_grid;
+  for (int x = 0; x <= w; x++) sums[x] = 0;
+  for (int y = 0; y < h; y++) {
+    int* row = &sums[(y + 1) * stride];
+    int row_fish = 0;
+    row[0] = 0;
+    for (int x = 0; x < w; x++) {
+      row_fish += get_tile_fish(game->board_grid[x + y * w]);
+      row[x + 1] = row[x + 1 - stride] + row_fish;
+    }
+  }
+  for (int i = 0; i < tiles_count; i++) {
+    Coords tile = tiles[i];
+    int x1 = my_max(tile.x - area, 0), x2 = my_min(tile.x + area + 1, w);
+    int y1 = my_max(tile.y - area, 0), y2 = my_min(tile.y + area + 1, h);
+    self->tile_scores[i] = sums[y2 * stride + x2] - sums[y1 * stride + x2] -
+                           sums[y2 * stride + x1] + sums[y1 * stride + x1];
+  }
+}
+
+/// @brief Returns the #PlacementTileKind of the @c tile for the player whose
+/// ID is @c my_id.
+static inline int placement_tile_kind(short tile, short my_id) {
+  short fish, player_id;
+  if ((fish = get_tile_fish(tile))) {
+    return PLACEMENT_TILE_FISH + my_min(fish, UCHAR_MAX - PLACEMENT_TILE_FISH) - 1;
+  } else if ((player_id = get_tile_player_id(tile))) {
+    return player_id == my_id ? PLACEMENT_TILE_MY_PENGUIN : PLACEMENT_TILE_PENGUIN;
+  } else {
+    return PLACEMENT_TILE_WATER;
+  }
+}
+
+/// @relatedalso BotState
+/// @brief Computes the #BotState::placement_scores of all tiles of the board
+/// from scratch. Returns @c false if interrupted by #bot_should_stop.
+///
+/// The weight of a tile within the scan area depends only on its kind (see
+/// #PlacementTileKind) and on the distance to the penguin, so all weights are
+/// computed once beforehand. The scores of all tiles of the board are then
+/// accumulated offset by offset, like in a convolution. The board is padded
+/// with the tiles outside of it, so that the innermost loop, which runs along
+/// a row of the board, contains neither the bounds checks nor the divisions
+/// anymore.
+static bool bot_compute_placement_scores(BotState* self) {
+  Game* game = self->game;
+  int w = game->board_width, h = game->board_height;
+  int area = self->placement_scan_area;
+  assert(area >= 0);
+  short my_id = game_get_current_player(game)->id;
+  self->placement_scores_area = -1;
+
+  int padded_w = w + 2 * area, padded_h = h + 2 * area;
+  bot_alloc_buf(self->placement_kinds, self->placement_kinds_cap, padded_w * padded_h);
+  unsigned char* kinds = self->placement_kinds;
+  memset(kinds, PLACEMENT_TILE_OUTSIDE, sizeof(*kinds) * padded_w * padded_h);
+  int kinds_count = PLACEMENT_TILE_FISH;
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      int kind = placement_tile_kind(game->board_grid[x + y * w], my_id);
+      kinds[(x + area) + (y + area) * padded_w] = (unsigned char)kind;
+      kinds_count = my_max(kinds_count, kind + 1);
+    }
+  }
+
+  // The weights of every kind of tile at every distance up to 2 * area.
+  int distances = 2 * area + 1;
+  bot_alloc_buf(self->placement_weights, self->placement_weights_cap, distances * kinds_count);
+  int* weights = self->placement_weights;
+  for (int d = 0; d < distances; d++) {
+    for (int kind = 0; kind < kinds_count; kind++) {
+      weights[d * kinds_count + kind] = placement_tile_weight(placement_tile_kind_score(kind), d);
+    }
+  }
+
+  bot_alloc_buf(self->placement_scores, self->placement_scores_cap, w * h);
+  int* scores = self->placement_scores;
+  memset(scores, 0, sizeof(*scores) * w * h);
+  for (int dy = -area; dy <= area; dy++) {
+    if (bot_should_stop(self)) return false;
+    for (int dx = -area; dx <= area; dx++) {
+      // The tile under the penguin itself is skipped.
+      if (dx == 0 && dy == 0) continue;
+      const int* table = &weights[(abs(dx) + abs(dy)) * kinds_count];
+      for (int kind = 0; kind < kinds_count; kind++) {
+        // Far enough from the penguin most of the weights get rounded to zero.
+        int weight = table[kind];
+        if (weight == 0) continue;
+        for (int y = 0; y < h; y++) {
+          const unsigned char* src = &kinds[(area + dx) + (y + area + dy) * padded_w];
+          int* dst = &scores[y * w];
+          // This loop is simple enough to be vectorized by the compiler.
+          for (int x = 0; x < w; x++) {
+            dst[x] += src[x] == kind ? weight : 0;
+          }
+        }
+      }
+    }
+  }
+
+  self->placement_scores_area = area;
+  self->placement_scores_width = w, self->placement_scores_height = h;
+  self->placement_kinds_count = kinds_count;
+  return true;
+}
+
+/// @relatedalso BotState
+/// @brief Updates the #BotState::placement_scores left over from the
+/// previous call of #bot_rate_all_placements after some tiles of the board
+/// have changed (usually that means the penguins placed in the meantime).
+/// Returns @c false if they can't be updated and must be recomputed.
+///
+/// The tiles contribute to the scores independently of each other, so for
+/// every tile whose kind differs from the one it had the last time, the
+/// difference of its weights is added to the scores of the tiles around it.
+/// The changes are found by comparing the board with the previous kinds of the
+/// tiles instead of relying on #TILE_DIRTY, since that attribute belongs to
+/// the UI. This is exact: the result is the same as of a full recomputation.
+static bool bot_update_placement_scores(BotState* self) {
+  Game* game = self->game;
+  int w = game->board_width, h = game->board_height;
+  int area = self->placement_scan_area;
+  if (!(self->placement_scores_area == area && self->placement_scores_width == w &&
+        self->placement_scores_height == h)) {
+    return false;
+  }
+  short my_id = game_get_current_player(game)->id;
+  int padded_w = w + 2 * area;
+  unsigned char* kinds = self->placement_kinds;
+  const int* weights = self->placement_weights;
+  int kinds_count = self->placement_kinds_count;
+  int* scores = self->placement_scores;
+  // Past this many changes recomputing the scores is cheaper.
+  int changes_limit = my_max(w * h / 16, 1), changes_count = 0;
+
+  for (int cy = 0; cy < h; cy++) {
+    for (int cx = 0; cx < w; cx++) {
+      int kind = placement_tile_kind(game->board_grid[cx + cy * w], my_id);
+      unsigned char* prev_kind = &kinds[(cx + area) + (cy + area) * padded_w];
+      if (kind == *prev_kind) continue;
+      if (kind >= kinds_count || ++changes_count > changes_limit) {
+        self->placement_scores_area = -1;
+        return false;
+      }
+      const int* new_weights = &weights[kind];
+      const int* prev_weights = &weights[*prev_kind];
+      for (int y = my_max(cy - area, 0); y <= my_min(cy + area, h - 1); y++) {
+        for (int x = my_max(cx - area, 0); x <= my_min(cx + area, w - 1); x++) {
+          if (x == cx && y == cy) continue;
+          int d = (abs(x - cx) + abs(y - cy)) * kinds_count;
+          scores[x + y * w] += new_weights[d] - prev_weights[d];
+        }
+      }
+      *prev_kind = (unsigned char)kind;
+    }
+  }
+  return true;
+}
+
+/// @relatedalso BotState
+/// @brief Rates all of the given placement @c tiles at once, writing the
+/// results to #BotState::tile_scores (which must have enough space for
+/// them). Returns @c false if the computation was interrupted by
+/// #bot_should_stop.
+///
+/// The results are exactly the same as if #bot_rate_placement was called for
+/// every tile, but they are computed in a single pass over the board (see
+/// #bot_compute_placement_scores), and on the subsequent calls only updated
+/// around the tiles which have changed (see #bot_update_placement_scores).
+bool bot_rate_all_placements(BotState* self, int tiles_count, const Coords* tiles) {
+  if (bot_should_stop(self)) return false;
+  if (self->params->placement_strategy == BOT_PLACEMENT_MOST_FISH) {
+    bot_rate_all_placements_by_fish(self, tiles_count, tiles);
+    return true;
+  }
+
+  if (!bot_update_placement_scores(self)) {
+    if (!bot_compute_placement_scores(self)) return false;
+  }
+  Game* game = self->game;
+  const int* scores = self->placement_scores;
+  for (int i = 0; i < tiles_count; i++) {
+    Coords tile = tiles[i];
+    // This is a significant one
+    int obstructed = count_obstructed_directions(game, tile) * -1000;
+    self->tile_scores[i] = scores[tile.x + tile.y * game->board_width] + obstructed;
+  }
+  return true;
+}
+
+/// @relatedalso BotState
+/// @brief Reserves the buffers of #bot_compute_placement for the
+/// #BotParameters::placement_scan_area, so that they don't have to be grown
+/// while the scan area is being raised.
+static void bot_prepare_placement_buffers(BotState* self) {
+  const Game* game = self->game;
+  int w = game->board_width, h = game->board_height;
+  bot_alloc_buf(self->tile_coords, self->tile_coords_cap, w * h);
+  bot_alloc_buf(self->tile_scores, self->tile_scores_cap, w * h);
+  BotPlacementStrategy strategy = self->params->placement_strategy;
+  int area = my_max(self->params->placement_scan_area, 0);
+  if (strategy == BOT_PLACEMENT_MOST_FISH) {
+    bot_alloc_buf(self->placement_grid, self->placement_grid_cap, (w + 1) * (h + 1));
+  } else if (strategy == BOT_PLACEMENT_SMART) {
+    int padded_w = w + 2 * area, padded_h = h + 2 * area;
+    bot_alloc_buf(self->placement_kinds, self->placement_kinds_cap, padded_w * padded_h);
+    // All kinds of tiles fit into an unsigned char, see placement_tile_kind.
+    int weights_size = (2 * area + 1) * UCHAR_MAX;
+    bot_alloc_buf(self->placement_weights, self->placement_weights_cap, weights_size);
+    bot_alloc_buf(self->placement_scores, self->placement_scores_cap, w * h);
+  }
+}
+
 /// @relatedalso BotState
 /// @brief Computes the best placement for the current player given the current
 /// game state.
@@ -143,7 +958,7 @@ static int pick_best_score(int scores_length, int* scores) {
 bool bot_compute_placement(BotState* self, Coords* out_target) {
   Game* game = self->game;
 
-  bot_alloc_buf(self->tile_coords, self->tile_coords_cap, game->board_width * game->board_height);
+  bot_prepare_placement_buffers(self);
   int tiles_count = 0;
   for (int y = 0; y < game->board_height; y++) {
     for (int x = 0; x < game->board_width; x++) {
@@ -166,13 +981,25 @@ bool bot_compute_placement(BotState* self, Coords* out_target) {
     return true;
   }
 
-  bot_alloc_buf(self->tile_scores, self->tile_scores_cap, tiles_count);
-  for (int i = 0; i < tiles_count; i++) {
-    self->tile_scores[i] = bot_rate_placement(self, self->tile_coords[i]);
-    if (self->cancelled) return false;
+  // With a time limit, the scan area is grown gradually (see
+  // BotParameters::time_limit_ms), the result of the last complete pass wins.
+  uint64_t deadline = bot_start_timer(self);
+  int max_scan_area = self->params->placement_scan_area;
+  int best_tile_idx = -1;
+  int start_area = deadline != 0 ? my_min(1, max_scan_area) : max_scan_area;
+  // The deepening isn't needed if the scores left over from the previous call
+  // can be updated, which doesn't take long.
+  if (self->placement_scores_area == max_scan_area) start_area = max_scan_area;
+  for (int area = start_area; area <= max_scan_area; area++) {
+    self->placement_scan_area = area;
+    if (!bot_rate_all_placements(self, tiles_count, self->tile_coords)) break;
+    best_tile_idx = pick_best_score(tiles_count, self->tile_scores);
+    self->stop->deadline = deadline;
   }
+  self->placement_scan_area = max_scan_area;
+  self->stop->deadline = 0;
+  if (self->stop->cancelled) return false;
 
-  int best_tile_idx = pick_best_score(tiles_count, self->tile_scores);
   assert(best_tile_idx >= 0);
   *out_target = self->tile_coords[best_tile_idx];
   return true;
@@ -184,13 +1011,13 @@ bool bot_compute_placement(BotState* self, Coords* out_target) {
 /// Evaluates the nearby tiles to determine how good the placement location is.
 int bot_rate_placement(BotState* self, Coords penguin) {
   int score = 0;
-  if (self->cancelled) return score;
+  if (self->stop->cancelled) return score;
   Player* my_player = game_get_current_player(self->game);
 
-  int area_start_x = penguin.x - self->params->placement_scan_area;
-  int area_start_y = penguin.y - self->params->placement_scan_area;
-  int area_end_x = penguin.x + self->params->placement_scan_area;
-  int area_end_y = penguin.y + self->params->placement_scan_area;
+  int area_start_x = penguin.x - self->placement_scan_area;
+  int area_start_y = penguin.y - self->placement_scan_area;
+  int area_end_x = penguin.x + self->placement_scan_area;
+  int area_end_y = penguin.y + self->placement_scan_area;
 
   if (self->params->placement_strategy == BOT_PLACEMENT_MOST_FISH) {
     int total_fish = 0;
@@ -228,11 +1055,7 @@ int bot_rate_placement(BotState* self, Coords penguin) {
         // Makes the board bounds less unattractive
         tile_score += 10;
       }
-      int d = distance(penguin, coords);
-      const int DIV_PRECISION = 1000;
-      // The further away the tile is from the penguin, the less effect it
-      // should have on the calculation
-      score += tile_score * 4 * DIV_PRECISION / (d * d + 1) / DIV_PRECISION;
+      score += placement_tile_weight(tile_score, distance(penguin, coords));
     }
   }
 
@@ -274,7 +1097,8 @@ int bot_rate_placement(BotState* self, Coords penguin) {
 /// instead of creating a copy of it each time. However, recursive evaluation
 /// currently has a significant limitation -- it only considers sequences of
 /// moves of a single penguin, and doesn't take the opponents' moves into
-/// account at all (doing otherwise consumes too much computing time).
+/// account at all (doing otherwise consumes too much computing time). For a
+/// search which does, see #BOT_MOVEMENT_ADVERSARIAL.
 ///
 /// @returns @c true if a move was found, @c false if there were no moves
 /// available for the player or if the computation was cancelled. If found, the
@@ -293,6 +1117,20 @@ int bot_rate_placement(BotState* self, Coords penguin) {
 /// against those) -- primarily because they are very persistent at just moving
 /// in a single direction.
 bool bot_compute_move(BotState* self, Coords* out_penguin, Coords* out_target) {
+  if (self->bitboard == NULL) {
+    self->bitboard = bitboard_new();
+  }
+  bitboard_load_game(self->bitboard, self->game);
+  if (self->position == NULL) {
+    self->position = search_position_new();
+  }
+  search_position_load(self->position, self->game);
+  bot_prepare_transposition_table(self);
+  bot_prepare_search_stack(self);
+  bot_prepare_base_buffers(self);
+  self->recursion_limit = self->params->recursion_limit;
+  bot_update_transposition_salt(self);
+
   Player* my_player = game_get_current_player(self->game);
   int moves_count = 0;
   BotMove* moves_list = bot_generate_all_moves_list(
@@ -303,6 +1141,23 @@ bool bot_compute_move(BotState* self, Coords* out_penguin, Coords* out_target) {
   }
 
   BotMovementStrategy strategy = self->params->movement_strategy;
+  if (strategy == BOT_MOVEMENT_SMART || strategy == BOT_MOVEMENT_ADVERSARIAL ||
+      strategy == BOT_MOVEMENT_MCTS) {
+    // Once the bot is left alone on its islands, there is nothing left to
+    // guess, the moves can be simply computed exactly.
+    if (bot_solve_endgame(self, out_penguin, out_target)) {
+      return true;
+    }
+    if (bot_movement_uses_workers(self)) {
+      bot_prepare_workers(self);
+    }
+  }
+  if (strategy == BOT_MOVEMENT_ADVERSARIAL) {
+    return bot_search_move(self, out_penguin, out_target);
+  }
+  if (strategy == BOT_MOVEMENT_MCTS) {
+    return bot_mcts_move(self, out_penguin, out_target);
+  }
   if (strategy == BOT_MOVEMENT_FIRST_POSSIBLE || strategy == BOT_MOVEMENT_RANDOM) {
     Rng* rng = self->rng;
     int picked_move_idx =
@@ -312,10 +1167,25 @@ bool bot_compute_move(BotState* self, Coords* out_penguin, Coords* out_target) {
     return true;
   }
 
-  int* move_scores = bot_rate_moves_list(self, moves_count, moves_list);
-  if (self->cancelled) return false;
+  // With a time limit, iterative deepening is performed: the recursion limit
+  // is raised one level at a time and the best move of the last completed
+  // iteration is kept.
+  uint64_t deadline = bot_start_timer(self);
+  int max_recursion_limit = self->params->recursion_limit;
+  int best_index = -1;
+  for (int limit = deadline != 0 ? 0 : max_recursion_limit; limit <= max_recursion_limit;
+       limit++) {
+    self->recursion_limit = limit;
+    bot_update_transposition_salt(self);
+    int* move_scores = bot_rate_moves_list(self, moves_count, moves_list);
+    if (move_scores == NULL) break;
+    best_index = pick_best_score(moves_count, move_scores);
+    self->stop->deadline = deadline;
+  }
+  self->recursion_limit = max_recursion_limit;
+  self->stop->deadline = 0;
+  if (self->stop->cancelled) return false;
 
-  int best_index = pick_best_score(moves_count, move_scores);
   assert(best_index >= 0);
   BotMove picked_move = moves_list[best_index];
   *out_penguin = picked_move.penguin, *out_target = picked_move.target;
@@ -335,7 +1205,7 @@ BotMove* bot_generate_all_moves_list(
   bot_alloc_buf(self->possible_steps, self->possible_steps_cap, penguins_count);
   *moves_count = 0;
   for (int i = 0; i < penguins_count; i++) {
-    PossibleSteps moves = calculate_penguin_possible_moves(self->game, penguins[i]);
+    PossibleSteps moves = bitboard_possible_steps(self->bitboard, penguins[i]);
     for (int dir = 0; dir < DIRECTION_MAX; dir++) {
       moves.steps[dir] = my_min(moves.steps[dir], self->params->max_move_length);
       *moves_count += moves.steps[dir];
@@ -367,52 +1237,48 @@ BotMove* bot_generate_all_moves_list(
 /// @brief Applies #bot_rate_move to every move in the provided list and
 /// returns a pointer to the list of scores.
 int* bot_rate_moves_list(BotState* self, int moves_count, BotMove* moves_list) {
-  if (self->cancelled) return NULL;
+  if (bot_should_stop(self)) return NULL;
   Coords prev_penguin = { -1, -1 };
+  int regions_per_dir[DIRECTION_MAX];
   int fishes_per_dir[DIRECTION_MAX];
-  short* fill_grid = NULL;
+  // The root position has been analyzed by bot_prepare_search_stack.
+  const Junctions* junctions = self->junctions;
 
   bot_alloc_buf(self->move_scores, self->move_scores_cap, moves_count);
+  // The moves are rated independently from each other, so at the root this
+  // can be done on multiple threads.
+  bool prerated = self->depth == 0 && bot_rate_moves_in_parallel(self, moves_count, moves_list);
   for (int i = 0; i < moves_count; i++) {
     BotMove move = moves_list[i];
-    int score = bot_rate_move(self, move);
-    if (self->cancelled) return NULL;
+    int score = prerated ? self->move_scores[i] : bot_rate_move(self, move);
+    if (bot_should_stop(self)) return NULL;
     Coords penguin = move.penguin, target = move.target;
 
     // This is the primary junction check: whenever a choice must be made, we
     // choose in favor of the direction from which the most fish is accessible.
     if (self->depth == 0) {
       if (!(prev_penguin.x == penguin.x && prev_penguin.y == penguin.y)) {
+        // Set the elements of fishes_per_dir to the total number of fish
+        // reachable in that direction, unless that region is also reachable
+        // from one of the previous directions.
         for (int dir = 0; dir < DIRECTION_MAX; dir++) {
-          fishes_per_dir[dir] = 0;
-        }
-        fill_grid = NULL;
-        if (bot_quick_junction_check(self, penguin)) {
-          fill_grid = bot_flood_fill_reset_grid(self, &self->fill_grid1, &self->fill_grid1_cap);
-          // Fill the cells of the fill grid with the directions they are
-          // reachable from and set the elements of fishes_per_dir to the total
-          // number of fish reachable in that direction.
-          for (int dir = 0; dir < DIRECTION_MAX; dir++) {
-            Coords neighbor = DIRECTION_TO_COORDS[dir];
-            neighbor.x += penguin.x, neighbor.y += penguin.y;
-            if (!is_tile_in_bounds(self->game, neighbor)) continue;
-            if (fill_grid[neighbor.x + neighbor.y * self->game->board_width] == 0) {
-              short marker = (short)(dir + 1);
-              fishes_per_dir[dir] = bot_flood_fill_count_fish(self, fill_grid, neighbor, marker);
-            }
+          Coords neighbor = DIRECTION_TO_COORDS[dir];
+          neighbor.x += penguin.x, neighbor.y += penguin.y;
+          int region = junctions_region(junctions, neighbor);
+          regions_per_dir[dir] = region;
+          fishes_per_dir[dir] = region >= 0 ? junctions_region_fish(junctions, region) : 0;
+          for (int prev_dir = 0; prev_dir < dir; prev_dir++) {
+            if (regions_per_dir[prev_dir] == region) fishes_per_dir[dir] = 0;
           }
         }
       }
 
-      if (fill_grid) {
-        short marker = fill_grid[target.x + target.y * self->game->board_width];
-        int available_fish = fishes_per_dir[marker - 1];
-        for (int dir = 0; dir < DIRECTION_MAX; dir++) {
-          int missed_fish = fishes_per_dir[dir];
-          if (missed_fish != 0) {
-            // Will give a bonus if the chosen direction has more fish
-            score += 10 * (available_fish - missed_fish);
-          }
+      int available_fish = junctions_region_fish(junctions, junctions_region(junctions, target));
+      for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+        int missed_fish = fishes_per_dir[dir];
+        if (missed_fish != 0) {
+          // Will give a bonus if the chosen direction has more fish
+          score += 10 * (available_fish - missed_fish);
         }
       }
     }
@@ -427,200 +1293,155 @@ int* bot_rate_moves_list(BotState* self, int moves_count, BotMove* moves_list) {
 /// @brief The heart of the bot, assigns a score to the given move according to
 /// its usefulness.
 ///
-/// In case a cancellation is requested (see #BotState::cancelled), this
+/// In case a cancellation is requested (see #bot_should_stop), this
 /// function starts unwinding the recursive calls and returns some garbage
 /// score, but otherwise the move computation is stopped.
 int bot_rate_move(BotState* self, BotMove move) {
   int score = 0;
-  if (self->cancelled) return score;
+  if (bot_should_stop(self)) return score;
   Coords penguin = move.penguin, target = move.target;
-  Player* my_player = game_get_current_player(self->game);
 
   int move_len = distance(penguin, target);
   // Prioritize shorter moves
   score += 64 / move_len - 8;
-  short target_tile = get_tile(self->game, target);
+  short target_tile = search_position_get_tile(self->position, target);
   short fish = get_tile_fish(target_tile);
   // Prioritize collecting more fish
   score += 10 * fish * fish;
 
-  if (self->depth == 0 && count_obstructed_directions(self->game, penguin) == 3) {
+  const Bitboard* bitboard = self->bitboard;
+  if (self->depth == 0 && bitboard_count_obstructed(bitboard, penguin) == 3) {
     // Emergency escape mode
     score += 1000;
   }
-  if (self->depth == 0 && count_obstructed_directions(self->game, target) == 4) {
+  if (self->depth == 0 && bitboard_count_obstructed(bitboard, target) == 4) {
     // A suicide move
     score += -10000;
   }
 
-  for (int dir = 0; dir < DIRECTION_MAX; dir++) {
-    Coords neighbor = DIRECTION_TO_COORDS[dir];
-    neighbor.x += penguin.x, neighbor.y += penguin.y;
-    if (!is_tile_in_bounds(self->game, neighbor)) continue;
-    short other_tile = get_tile(self->game, neighbor);
-    if (is_penguin_tile(other_tile) && distance(penguin, target) == 1) {
-      // This was supposed to prevent the bot from chasing the penguins of the
-      // stupidest first-available-move bots, though it didn't work in
-      // practice.
-      score += -1000;
-    }
+  unsigned penguin_neighbors = BITBOARD_DIRECTIONS_MASK &
+                               bitboard_neighbors_mask(bitboard, bitboard->penguins, penguin);
+  if (move_len == 1) {
+    // This was supposed to prevent the bot from chasing the penguins of the
+    // stupidest first-available-move bots, though it didn't work in practice.
+    score += -1000 * popcount64(penguin_neighbors);
   }
 
+  const uint64_t* my_penguins =
+    bitboard_player_plane(bitboard, self->position->current_player_index);
+  unsigned target_neighbors = BITBOARD_DIRECTIONS_MASK &
+                              bitboard_neighbors_mask(bitboard, bitboard->penguins, target);
   for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+    if (!test_bit(target_neighbors, 1u << DIRECTION_TO_NEIGHBOR[dir])) continue;
     Coords neighbor = DIRECTION_TO_COORDS[dir];
     neighbor.x += target.x, neighbor.y += target.y;
-    if (!is_tile_in_bounds(self->game, neighbor)) continue;
     if (neighbor.x == penguin.x && neighbor.y == penguin.y) continue;
-    short other_tile = get_tile(self->game, neighbor), other_player_id;
-    if ((other_player_id = get_tile_player_id(other_tile))) {
-      if (other_player_id != my_player->id) {
-        // One side will be blocked by us, so add 1.
-        int blocked = count_obstructed_directions(self->game, neighbor) + 1;
-        if (2 <= blocked && blocked <= 3 && move_len == 1) {
-          // This is also a (non-functional) chasing protection, see the
-          // comment above.
-          score += 250;
-        } else if (blocked > 2) {
-          // The aggressiveness bonus
-          score += 500 * (blocked - 2);
-        }
-      } else {
-        // Don't block our own penguins!
-        score += -1000;
+    if (!bitboard_test(bitboard, my_penguins, neighbor)) {
+      // One side will be blocked by us, so add 1.
+      int blocked = bitboard_count_obstructed(bitboard, neighbor) + 1;
+      if (2 <= blocked && blocked <= 3 && move_len == 1) {
+        // This is also a (non-functional) chasing protection, see the comment
+        // above.
+        score += 250;
+      } else if (blocked > 2) {
+        // The aggressiveness bonus
+        score += 500 * (blocked - 2);
       }
+    } else {
+      // Don't block our own penguins!
+      score += -1000;
     }
   }
 
-  if (self->depth < self->params->recursion_limit) {
-    move_penguin(self->game, penguin, target);
-
-    if (self->depth <= self->params->junction_check_recursion_limit) {
-      // Another junction check, this one discourages the bot from creating
-      // junctions in the first place. This prevents it from getting itself
-      // into trouble sometimes.
-      if (bot_quick_junction_check(self, target)) {
-        short* fill_grid =
-          bot_flood_fill_reset_grid(self, &self->fill_grid2, &self->fill_grid2_cap);
-        int dir;
-        for (dir = 0; dir < DIRECTION_MAX; dir++) {
-          Coords neighbor = DIRECTION_TO_COORDS[dir];
-          neighbor.x += target.x, neighbor.y += target.y;
-          if (!is_tile_in_bounds(self->game, neighbor)) continue;
-          short marker = (short)(dir + 1);
-          if (bot_flood_fill_count_fish(self, fill_grid, neighbor, marker) > 0) {
-            break;
-          }
-        }
-        // If there was no unobstructed direction, dir will be equal to
-        // DIRECTION_MAX at the start of this second loop.
-        for (; dir < DIRECTION_MAX; dir++) {
-          Coords neighbor = DIRECTION_TO_COORDS[dir];
-          neighbor.x += target.x, neighbor.y += target.y;
-          if (!is_tile_in_bounds(self->game, neighbor)) continue;
-          short other_tile = get_tile(self->game, neighbor);
-          if (is_fish_tile(other_tile)) {
-            short marker = fill_grid[neighbor.x + neighbor.y * self->game->board_width];
-            if (marker == 0) {
-              // If a tile in some other direction is not reachable from the
-              // direction at which we ran the flood fill, then we must created
-              // junction somewhere.
-              score += -200;
-              break;
-            }
-          }
-        }
-      }
-    }
-
-    BotState* sub = bot_enter_substate(self);
-    int moves_count = 0;
-    BotMove* moves_list = bot_generate_all_moves_list(sub, 1, &target, &moves_count);
-    int* move_scores = bot_rate_moves_list(sub, moves_count, moves_list);
-    if (!self->cancelled) {
-      int best_index = pick_best_score(moves_count, move_scores);
-      if (best_index >= 0) {
-        // The score of recursive moves is scaled by a coefficient so as to
-        // encourage the bot to make quicker gains and not dream too much about
-        // the future, since the situation might change quickly.
-        score += move_scores[best_index] * 3 / 4;
-      }
-    }
-
-    undo_move_penguin(self->game);
+  if (self->depth < self->recursion_limit) {
+    bot_make_move(self, move);
+    score += bot_rate_move_consequences(self, move);
+    bot_undo_move(self, move);
   }
 
   return score;
 }
 
 /// @relatedalso BotState
-/// @brief A precondition for junction checks to know if a more expensive flood
-/// fill test is necessary.
+/// @brief The recursive part of #bot_rate_move, evaluates the position after
+/// the @c move has been applied to the #Game.
 ///
-/// A "junction" is a state when then bot has to choose between two or more
-/// directions because once it makes a move the other paths will become
-/// inaccessible. This function only performs a quick heuristic check which can
-/// only tell if the current tile is <em>definitely not</em> a junction, so it
-/// is used to know if a further more time-consuming flood fill test is
-/// necessary.
-bool bot_quick_junction_check(BotState* self, Coords coords) {
-  bool in_bounds[NEIGHBOR_MAX];
-  bool is_fish[NEIGHBOR_MAX];
-  bool connected[NEIGHBOR_MAX];
-
-  // Collect the information about neighboring tiles first
-  int dir;
-  for (dir = 0; dir < NEIGHBOR_MAX; dir++) {
-    Coords neighbor = NEIGHBOR_TO_COORDS[dir];
-    neighbor.x += coords.x, neighbor.y += coords.y;
-    connected[dir] = false;
-    is_fish[dir] = false;
-    if ((in_bounds[dir] = is_tile_in_bounds(self->game, neighbor))) {
-      short tile = get_tile(self->game, neighbor);
-      is_fish[dir] = is_fish_tile(tile);
+/// The result depends only on the board, the position of the moved penguin
+/// and the current depth, so it is cached in the
+/// #BotState::transposition_table.
+static int bot_rate_move_consequences(BotState* self, BotMove move) {
+  Coords target = move.target;
+  TranspositionTable* table = self->transposition_table;
+  uint64_t key = 0;
+  int score = 0;
+  if (table != NULL) {
+    key = bot_transposition_key(self, target);
+    if (transposition_table_probe(table, key, &score)) {
+      return score;
     }
   }
 
-  // Find the starting direction
-  int start_dir = NEIGHBOR_MAX;
-  for (dir = 0; dir < DIRECTION_MAX; dir++) {
-    start_dir = DIRECTION_TO_NEIGHBOR[dir];
-    if (is_fish[start_dir]) break;
-  }
-  if (dir == DIRECTION_MAX) {
-    // The tile is obstructed on all sides - definitely not a junction.
-    return false;
-  }
-
-  // Walk in the clockwise direction
-  for (dir = start_dir; dir < NEIGHBOR_MAX; dir++) {
-    if (!is_fish[dir]) break;
-    connected[dir] = true;
-  }
-  // Walk in the counter-clockwise direction
-  for (dir = start_dir - 1; dir != start_dir; dir--) {
-    if (dir < 0) dir += NEIGHBOR_MAX;
-    if (!is_fish[dir]) break;
-    connected[dir] = true;
+  bool tracks_regions = false;
+  if (self->depth <= self->params->junction_check_recursion_limit) {
+    // Another junction check, this one discourages the bot from creating
+    // junctions in the first place. This prevents it from getting itself
+    // into trouble sometimes. If the tiles around the target are no longer
+    // reachable from each other, then we must have created a junction
+    // somewhere -- that is, the target was a cut tile of the position before
+    // the move. For the moves at the root this is known from the analysis of
+    // the position, deeper down the region map (which follows the moves of
+    // the recursion) finds it out while the move is applied to it.
+    bool is_cut_tile = self->depth == 0 && junctions_is_cut_tile(self->junctions, target);
+    if (self->region_map != NULL) {
+      bool splits =
+        region_map_move_penguin(self->region_map, self->position, move.penguin, target);
+      assert(self->depth > 0 || splits == is_cut_tile);
+      if (self->depth > 0) is_cut_tile = splits;
+      tracks_regions = true;
+    }
+    if (is_cut_tile) {
+      score += -200;
+    }
   }
 
-  for (dir = 0; dir < DIRECTION_MAX; dir++) {
-    if (is_fish[DIRECTION_TO_NEIGHBOR[dir]] && !connected[DIRECTION_TO_NEIGHBOR[dir]]) {
-      // Found an unobstructed tile which is not connected - maybe a junction.
-      return true;
+  BotState* sub = bot_enter_substate(self);
+  int moves_count = 0;
+  BotMove* moves_list = bot_generate_all_moves_list(sub, 1, &target, &moves_count);
+  int* move_scores = bot_rate_moves_list(sub, moves_count, moves_list);
+  if (move_scores != NULL) {
+    int best_index = pick_best_score(moves_count, move_scores);
+    if (best_index >= 0) {
+      // The score of recursive moves is scaled by a coefficient so as to
+      // encourage the bot to make quicker gains and not dream too much about
+      // the future, since the situation might change quickly.
+      score += move_scores[best_index] * 3 / 4;
     }
   }
 
-  // All neighbor tiles are connected - definitely not a junction.
-  return false;
+  if (tracks_regions) {
+    region_map_undo_move(self->region_map);
+  }
+  if (table != NULL && !bot_should_stop(self)) {
+    int remaining_depth = self->recursion_limit - self->depth;
+    transposition_table_store(table, key, remaining_depth, score);
+  }
+  return score;
 }
 
 /// @relatedalso BotState
 /// @brief Allocates a grid for use in #bot_flood_fill_count_fish and fills it
-/// with zeroes.
+/// with zeroes. If the #BotState::bitboard is loaded, the mask of the fills is
+/// also reset to all of its walkable tiles.
 short* bot_flood_fill_reset_grid(BotState* self, short** fill_grid, size_t* fill_grid_cap) {
   int w = self->game->board_width, h = self->game->board_height;
   bot_alloc_buf(*fill_grid, *fill_grid_cap, w * h);
   memset(*fill_grid, 0, sizeof(**fill_grid) * w * h);
+  const Bitboard* bitboard = self->bitboard;
+  if (bitboard != NULL && bitboard->width == w && bitboard->height == h) {
+    int plane_words = bitboard->row_words * h;
+    bot_alloc_buf(self->fill_planes, self->fill_planes_cap, 2 * plane_words);
+    memcpy(self->fill_planes, bitboard->walkable, sizeof(*self->fill_planes) * plane_words);
+  }
   return *fill_grid;
 }
 
@@ -628,6 +1449,9 @@ short* bot_flood_fill_reset_grid(BotState* self, short** fill_grid, size_t* fill
 /// @brief See #bot_flood_fill_count_fish.
 struct BotFloodFillCtx {
   BotState* self;
+  /// Copied from the #Game for quicker access.
+  const short* board_grid;
+  int board_width, board_height;
   short* fill_grid;
   short marker_value;
   int fish_count;
@@ -635,12 +1459,11 @@ struct BotFloodFillCtx {
 
 /// @relatedalso BotState
 /// @brief See #bot_flood_fill_count_fish and #flood_fill.
-static bool bot_flood_fill_check(int x, int y, void* data) {
+static inline bool bot_flood_fill_check(int x, int y, void* data) {
   struct BotFloodFillCtx* ctx = data;
-  Game* game = ctx->self->game;
-  int w = game->board_width, h = game->board_height;
+  int w = ctx->board_width, h = ctx->board_height;
   if ((0 <= x && x < w && 0 <= y && y < h) && ctx->fill_grid[x + y * w] == 0) {
-    short tile = game->board_grid[x + y * w];
+    short tile = ctx->board_grid[x + y * w];
     return is_fish_tile(tile);
   }
   return false;
@@ -648,11 +1471,10 @@ static bool bot_flood_fill_check(int x, int y, void* data) {
 
 /// @relatedalso BotState
 /// @brief See #bot_flood_fill_count_fish and #flood_fill.
-static void bot_flood_fill_mark(int x, int y, void* data) {
+static inline void bot_flood_fill_mark(int x, int y, void* data) {
   struct BotFloodFillCtx* ctx = data;
-  Game* game = ctx->self->game;
-  int w = game->board_width;
-  ctx->fish_count += game->board_grid[x + y * w];
+  int w = ctx->board_width;
+  ctx->fish_count += ctx->board_grid[x + y * w];
   ctx->fill_grid[x + y * w] = ctx->marker_value;
 }
 
@@ -665,29 +1487,7 @@ static FillSpan* bot_flood_fill_alloc_stack(size_t capacity, void* data) {
   return self->fill_stack;
 }
 
-/// @relatedalso BotState
-/// @brief Counts all fish accessible within an enclosed area starting at the
-/// given point using the flood fill algorithm.
-///
-/// Returns the number of reachable fish, the counted tiles are marked on the
-/// provided fill grid with @c marker_value, which must be non-zero.
-/// Additionally is used for junction checks.
-///
-/// @see #flood_fill
-int bot_flood_fill_count_fish(BotState* self, short* grid, Coords start, short marker_value) {
-  assert(marker_value != 0);
-  struct BotFloodFillCtx ctx;
-  ctx.self = self;
-  ctx.fill_grid = grid;
-  ctx.fish_count = 0;
-  ctx.marker_value = marker_value;
-  flood_fill(
-    start.x, start.y, bot_flood_fill_check, bot_flood_fill_mark, bot_flood_fill_alloc_stack, &ctx
-  );
-  return ctx.fish_count;
-}
-
-static void flood_fill_push(
+static inline void flood_fill_push(
   FillSpan** stack,
   size_t* stack_len,
   size_t* stack_cap,
@@ -707,34 +1507,26 @@ static void flood_fill_push(
   *stack_len += 1;
 }
 
-/// @brief An implementation of flood fill using the span filling algorithm.
+/// @brief The actual implementation of #flood_fill.
 ///
-/// This is essentially the algorithm behind the "bucket" tool in paint
-/// programs. The code was pretty much copied (and translated from pseudocode)
-/// from Wikipedia.
-///
-/// @param x the starting point
-/// @param y the starting point
-/// @param check a function that returns @c true if the given cell should be marked
-/// @param mark a function that marks the given cell
-/// @param alloc_stack a function that allocates that stack for #FillSpan s
-/// @param data extra data to be passed into the provided functions
-///
-/// @see <https://en.wikipedia.org/wiki/Flood_fill#Span_Filling>
-/// @see <https://github.com/erich666/GraphicsGems/blob/c3263439c281da62df4a559ec8164cf8c9eb88ca/gems/SeedFill.c>
-void flood_fill(
+/// It is always inlined, so that when the @c check and @c mark functions are
+/// known at compile time (like in #bot_flood_fill_count_fish), the compiler
+/// can inline them as well and get rid of the indirect calls on every tile.
+/// Additionally, the caller may provide a preallocated @c stack of the
+/// capacity @c stack_cap, @c alloc_stack is then called only if it runs out.
+static inline ALWAYS_INLINE void flood_fill_impl(
   int x,
   int y,
   bool (*check)(int x, int y, void* data),
   void (*mark)(int x, int y, void* data),
   FillSpan* (*alloc_stack)(size_t capacity, void* data),
-  void* data
+  void* data,
+  FillSpan* stack,
+  size_t stack_cap
 ) {
   if (!check(x, y, data)) return;
 
   size_t stack_len = 0;
-  size_t stack_cap = 0;
-  FillSpan* stack = NULL;
 #define stack_push(x1, x2, y, dy) \
   flood_fill_push(&stack, &stack_len, &stack_cap, x1, x2, y, dy, alloc_stack, data)
 
@@ -772,3 +1564,99 @@ void flood_fill(
 
 #undef stack_push
 }
+
+/// @relatedalso BotState
+/// @brief Counts all fish accessible within an enclosed area starting at the
+/// given point using the flood fill algorithm.
+///
+/// Returns the number of reachable fish, the counted tiles are marked on the
+/// provided fill grid with @c marker_value, which must be non-zero. This
+/// serves only the labeling of the regions by #bot_solve_endgame: the
+/// junction checks of #bot_rate_moves_list and #bot_rate_move read the
+/// regions from the #Junctions and the #RegionMap, which answer them without
+/// a fill per move.
+///
+/// If the #BotState::bitboard has been loaded (which means that it is in sync
+/// with the #Game), the fill is performed with #bitboard_flood_fill,
+/// otherwise with a version of #flood_fill specialized for this case. Both
+/// give exactly the same results. In the first case the tiles marked by the
+/// previous fills are excluded through a mask plane kept next to the grid, so
+/// the grid must come from #bot_flood_fill_reset_grid and mustn't be changed
+/// by anything else in between the fills.
+///
+/// @see #flood_fill
+int bot_flood_fill_count_fish(BotState* self, short* grid, Coords start, short marker_value) {
+  assert(marker_value != 0);
+  Game* game = self->game;
+  int w = game->board_width, h = game->board_height;
+  const Bitboard* bitboard = self->bitboard;
+  if (bitboard != NULL && bitboard->width == w && bitboard->height == h) {
+    int plane_words = bitboard->row_words * h;
+    assert(self->fill_planes_cap >= (size_t)(2 * plane_words));
+    uint64_t* mask = self->fill_planes;
+    uint64_t* region = &self->fill_planes[plane_words];
+    bitboard_flood_fill(bitboard, mask, region, start);
+    // The marked tiles are taken out of the mask right away, so that the next
+    // fills skip them without having to look at the grid.
+    for (int y = 0; y < h; y++) {
+      for (int i = 0; i < bitboard->row_words; i++) {
+        uint64_t bits = region[y * bitboard->row_words + i];
+        mask[y * bitboard->row_words + i] &= ~bits;
+        for (; bits != 0; bits &= bits - 1) {
+          grid[i * 64 + ctz64(bits) + y * w] = marker_value;
+        }
+      }
+    }
+    return bitboard_count_fish(bitboard, region);
+  }
+
+  struct BotFloodFillCtx ctx;
+  ctx.self = self;
+  ctx.board_grid = game->board_grid;
+  ctx.board_width = w, ctx.board_height = h;
+  ctx.fill_grid = grid;
+  ctx.fish_count = 0;
+  ctx.marker_value = marker_value;
+  // Every span pushed onto the stack either starts the fill or follows the
+  // marking of a tile, at most three spans per tile, so with the stack of this
+  // size it never has to be grown.
+  size_t stack_size = (size_t)w * h * 3 + 2;
+  bot_alloc_buf(self->fill_stack, self->fill_stack_cap, stack_size);
+  flood_fill_impl(
+    start.x,
+    start.y,
+    bot_flood_fill_check,
+    bot_flood_fill_mark,
+    bot_flood_fill_alloc_stack,
+    &ctx,
+    self->fill_stack,
+    self->fill_stack_cap
+  );
+  return ctx.fish_count;
+}
+
+/// @brief An implementation of flood fill using the span filling algorithm.
+///
+/// This is essentially the algorithm behind the "bucket" tool in paint
+/// programs. The code was pretty much copied (and translated from pseudocode)
+/// from Wikipedia.
+///
+/// @param x the starting point
+/// @param y the starting point
+/// @param check a function that returns @c true if the given cell should be marked
+/// @param mark a function that marks the given cell
+/// @param alloc_stack a function that allocates that stack for #FillSpan s
+/// @param data extra data to be passed into the provided functions
+///
+/// @see <https://en.wikipedia.org/wiki/Flood_fill#Span_Filling>
+/// @see <https://github.com/erich666/GraphicsGems/blob/c3263439c281da62df4a559ec8164cf8c9eb88ca/gems/SeedFill.c>
+void flood_fill(
+  int x,
+  int y,
+  bool (*check)(int x, int y, void* data),
+  void (*mark)(int x, int y, void* data),
+  FillSpan* (*alloc_stack)(size_t capacity, void* data),
+  void* data
+) {
+  flood_fill_impl(x, y, check, mark, alloc_stack, data, NULL, 0);
+}
@@ -4,11 +4,18 @@
 /// @brief The bot algorithm
 /// @see autonomous.h
 
+#include "bitboard.h"
 #include "game.h"
+#include "junctions.h"
 #include "movement.h"
+#include "position.h"
+#include "regions.h"
+#include "threading.h"
+#include "transposition.h"
 #include "utils.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,8 +43,27 @@ typedef enum BotMovementStrategy {
   BOT_MOVEMENT_RANDOM,
   /// Pick the first possible move (also known as the "dumb" algorithm).
   BOT_MOVEMENT_FIRST_POSSIBLE,
+  /// @brief A game-tree search over the moves of all players, see
+  /// #bot_search_move and #BotParameters::adversarial_mode.
+  BOT_MOVEMENT_ADVERSARIAL,
+  /// @brief The Monte Carlo Tree Search, see #bot_mcts_move and
+  /// #BotParameters::mcts_iterations.
+  BOT_MOVEMENT_MCTS,
 } BotMovementStrategy;
 
+/// Values of #BotParameters::adversarial_mode.
+typedef enum BotAdversarialMode {
+  /// @brief Assume that all opponents play together against the bot, which
+  /// turns the game into a two-player one and allows alpha-beta pruning.
+  BOT_ADVERSARIAL_PARANOID,
+  /// @brief Every player maximizes their own evaluation, without pruning.
+  BOT_ADVERSARIAL_MAX_N,
+  /// @brief The Best-Reply Search: like #BOT_ADVERSARIAL_PARANOID, but only
+  /// the single strongest opponent move is considered between the moves of
+  /// the bot, which lets the search look further ahead.
+  BOT_ADVERSARIAL_BEST_REPLY,
+} BotAdversarialMode;
+
 /// @brief Various parameters for the bot algorithm.
 ///
 /// Mainly used for configuring the bot to be a dumber opponent for testing.
@@ -54,6 +80,33 @@ typedef struct BotParameters {
   int recursion_limit;
   /// The maximum recursion depth at which junction checks are performed.
   int junction_check_recursion_limit;
+  /// @brief The number of entries in the #BotState::transposition_table,
+  /// rounded down to a power of two. Zero disables the table.
+  size_t transposition_table_size;
+  /// The algorithm of #BOT_MOVEMENT_ADVERSARIAL.
+  BotAdversarialMode adversarial_mode;
+  /// @brief The depth (in moves of all players, i.e. plies) of the search of
+  /// #BOT_MOVEMENT_ADVERSARIAL, must be positive.
+  int search_depth;
+  /// @brief The time budget of a single #bot_compute_move or
+  /// #bot_compute_placement call in milliseconds. Zero means no limit.
+  ///
+  /// When set, the searches are performed with iterative deepening: the depth
+  /// is increased one step at a time up to #recursion_limit (or #search_depth,
+  /// or #placement_scan_area), and once the time is up the result of the last
+  /// completed iteration is returned. The first iteration is always completed.
+  int time_limit_ms;
+  /// @brief The number of threads (including the calling one) among which
+  /// the root moves of #BOT_MOVEMENT_SMART are split, see #BotWorker. Zero
+  /// means one thread per CPU.
+  int threads_count;
+  /// @brief The maximum number of iterations (and, therefore, of the nodes of
+  /// the tree) of #BOT_MOVEMENT_MCTS, must be positive.
+  int mcts_iterations;
+  /// @brief The maximum size (in tiles) of an isolated region of the board
+  /// which is solved exactly by #bot_solve_endgame, at most
+  /// #ENDGAME_MAX_TILES. Zero disables the endgame solver.
+  int endgame_tile_limit;
 } BotParameters;
 
 void init_bot_parameters(BotParameters* self);
@@ -68,66 +121,47 @@ typedef struct FillSpan {
   int x1, x2, y, dy;
 } FillSpan;
 
-/// @brief Contains temporary data created during the evaluation of bot's moves.
-///
-/// Unlike the #Game, this is really just a complementary struct for
-/// #bot_compute_move and #bot_compute_placement and less of a class in the OOP
-/// sense, though it is implemented as such (refer to the documentation of
-/// #Game for the explanation). The primary reason for this being the
-/// autonomous mode, where the program is invoked each time just to make a
-/// single move and is not kept alive for the entire game, meaning that we
-/// can't have some additional state (@e unless we store it in a file,
-/// which I didn't want to do to keep things simple). Hence the logic in the
-/// autonomous mode and, therefore, the bot algorithm, is generally stateless
-/// or, in other words, "fire and forget" -- at any point of the game, you can
-/// create a #BotState, which stores only the intermediate data, compute and
-/// make a move, and then destroy it (though of course the #BotState objects
-/// can be reused later). You could say that this kind of makes the bot
-/// algorithm a function of the game state in the mathematical sense.
+struct BotState;
+struct MctsNode;
+struct MctsStep;
+struct EndgameEntry;
+
+/// @brief A helper thread for evaluating the moves in parallel.
 ///
-/// For the purposes of recursive evaluation (see #bot_compute_move), the
-/// #BotState is actually represented as a linked list (because why not) of
-/// substates. Also, it keeps around the previously allocated memory blocks for
-/// lists (the @c _cap fields are for capacity of the lists) because constantly
-/// making the OS allocate and free temporary buffers is slow, but also since
-/// this makes the overall memory management in the bot much simpler -- every
-/// function can return whenever and not care about freeing stuff because
-/// #bot_state_free will free everything in the end.
+/// Each worker has its own copy of the #Game and its own #BotState (with its
+/// own substates and #BotState::bitboard), only the
+/// #BotState::transposition_table is shared by all threads. The workers are
+/// used in three ways:
 ///
-/// Additional note regarding the rating functions (#bot_rate_placement and
-/// #bot_rate_move): all score calculations are performed with integers and not
-/// floats because integer arithmetic is faster (though marginally on modern
-/// CPUs) than floating point one, and we need to perform A LOT of it.
-typedef struct BotState {
-  /// @name References to other stuff
-  /// The #BotState isn't responsible for freeing these.
-  /// @{
-
-  /// Shouldn't be changed while the bot is running (hence marked as @c const).
-  const BotParameters* params;
-  /// @brief May be modified during the move evaluation, but once the job is
-  /// done the #Game will be returned to its original state.
+/// 1. By #BOT_MOVEMENT_SMART, which splits the list of the root moves among
+///    the threads, every thread takes the moves one at a time. The score of
+///    every move is computed in exactly the same way regardless of which
+///    thread does it, so the chosen move doesn't depend on the number of
+///    threads.
+/// 2. By #BOT_MOVEMENT_ADVERSARIAL, where the workers search the same root
+///    position as the calling thread, but at staggered depths, and only fill
+///    the shared table with the scores the calling thread will need later
+///    (see #bot_search_move). The result of the calling thread is the only
+///    one which counts.
+/// 3. By #BOT_MOVEMENT_MCTS, where all threads grow the same tree (see
+///    #bot_mcts_move).
+typedef struct BotWorker {
+  Thread thread;
+  /// Owned by the worker, cloned from the #Game of the base state.
   Game* game;
-  /// Just the #Rng, nothing special.
-  Rng* rng;
-
-  /// @}
-
-  /// @name Substates
-  /// See #bot_enter_substate.
-  /// @{
-
-  /// @brief The link to the next recursive substate. Substates are allocated
-  /// on demand by #bot_enter_substate.
-  struct BotState* substate;
-  /// @brief The recursion depth of the current state, starts at 0 for the base
-  /// state and increases in substates.
-  int depth;
-
-  /// @}
+  struct BotState* state;
+  /// @brief The data of the job the worker is currently running, @c NULL if
+  /// the worker's thread is not running.
+  void* job;
+  /// Set if the worker was cancelled or ran out of time.
+  bool stopped;
+} BotWorker;
 
+/// @brief The cancellation flag and the deadline of a computation, shared by
+/// a #BotState and all of its substates, see #bot_should_stop.
+typedef struct BotStopToken {
   /// @brief Can be set to @c true from another thread to cancel the move
-  /// evaluation.
+  /// evaluation, see #bot_cancel.
   ///
   /// The @c volatile keyword stops the compiler from being too smart and
   /// overoptimizing stuff. For example, given this loop:
@@ -169,6 +203,189 @@ typedef struct BotState {
   /// @see <https://stackoverflow.com/a/246148/12005228>
   /// @see <https://stackoverflow.com/a/2485733/12005228>
   volatile bool cancelled;
+  /// @brief Set by #bot_should_stop once the #deadline has passed.
+  volatile bool timed_out;
+  /// @brief The value of #get_monotonic_time_ms after which the computation
+  /// is stopped, zero if there is none.
+  uint64_t deadline;
+  /// @brief The number of the #bot_should_stop calls left until the clock is
+  /// looked at again, see #BOT_STOP_CHECK_INTERVAL.
+  int clock_countdown;
+  /// @brief The token of the base state if this one belongs to a #BotWorker,
+  /// stopping the base state stops the workers as well.
+  const struct BotStopToken* parent;
+} BotStopToken;
+
+/// @brief How often #bot_should_stop reads the clock. The calls happen at
+/// every node of the searches, so this keeps the overhead of the deadline
+/// checks down while still noticing it within a fraction of a millisecond.
+#define BOT_STOP_CHECK_INTERVAL 16
+
+/// @brief The preallocated memory of the substates, see
+/// #bot_prepare_search_stack.
+///
+/// The substates and the buffers used by the recursive evaluations live in a
+/// single block of memory, the arena, which is divided into contiguous frames,
+/// one per level of the recursion. Each frame holds the #BotState of its
+/// depth followed by its buffers, which have enough capacity for any position
+/// on a board of the given size, so once the stack has been prepared the
+/// searches run without touching the heap at all.
+typedef struct BotSearchStack {
+  /// The single allocation of the whole stack.
+  void* arena;
+  /// The size of a frame in bytes.
+  size_t frame_size;
+  /// The number of frames, that is the depth of the deepest substate.
+  int frames_count;
+  /// @brief The capacities of the buffers of every frame, derived from the
+  /// size of the board and the number of players and penguins.
+  size_t max_penguins, max_moves, max_players;
+} BotSearchStack;
+
+/// @brief Contains temporary data created during the evaluation of bot's moves.
+///
+/// Unlike the #Game, this is really just a complementary struct for
+/// #bot_compute_move and #bot_compute_placement and less of a class in the OOP
+/// sense, though it is implemented as such (refer to the documentation of
+/// #Game for the explanation). The primary reason for this being the
+/// autonomous mode, where the program is invoked each time just to make a
+/// single move and is not kept alive for the entire game, meaning that we
+/// can't have some additional state (@e unless we store it in a file,
+/// which I didn't want to do to keep things simple). Hence the logic in the
+/// autonomous mode and, therefore, the bot algorithm, is generally stateless
+/// or, in other words, "fire and forget" -- at any point of the game, you can
+/// create a #BotState, which stores only the intermediate data, compute and
+/// make a move, and then destroy it (though of course the #BotState objects
+/// can be reused later). You could say that this kind of makes the bot
+/// algorithm a function of the game state in the mathematical sense.
+///
+/// For the purposes of recursive evaluation (see #bot_compute_move), every
+/// level of the recursion has its own substate, and the substates are chained
+/// through #substate. They are the frames of the #BotSearchStack, a single
+/// arena which #bot_prepare_search_stack lays out for the deepest recursion of
+/// the movement strategy, together with the lists of every frame sized for the
+/// worst case on the board. The buffers of the base state (the @c _cap fields
+/// are for capacity of the lists) are reserved in the same way when
+/// #bot_compute_move or #bot_compute_placement starts, so that no memory is
+/// allocated while the bot is thinking, and are kept between the calls
+/// because constantly making the OS allocate and free temporary buffers is
+/// slow. Also, this makes the overall memory management in the bot much
+/// simpler -- every function can return whenever and not care about freeing
+/// stuff because #bot_state_free will free everything in the end.
+///
+/// Additional note regarding the rating functions (#bot_rate_placement and
+/// #bot_rate_move): all score calculations are performed with integers and not
+/// floats because integer arithmetic is faster (though marginally on modern
+/// CPUs) than floating point one, and we need to perform A LOT of it.
+typedef struct BotState {
+  /// @name References to other stuff
+  /// The #BotState isn't responsible for freeing these.
+  /// @{
+
+  /// Shouldn't be changed while the bot is running (hence marked as @c const).
+  const BotParameters* params;
+  /// @brief Isn't modified by the bot: the moves evaluated by the searches are
+  /// applied to the #position instead.
+  Game* game;
+  /// Just the #Rng, nothing special.
+  Rng* rng;
+
+  /// @}
+
+  /// @brief The bitboard mirror of the #game used for the move evaluation.
+  ///
+  /// Loaded by #bot_compute_move and kept in sync with the #Game while the
+  /// moves are being applied and undone. Owned by the base state, the
+  /// substates share it.
+  Bitboard* bitboard;
+  /// @brief The copy of the #game on which the moves are applied and undone
+  /// by the movement searches, see #bot_make_move.
+  ///
+  /// Loaded by #bot_compute_move, owned by the base state and shared by the
+  /// substates, just like the #bitboard.
+  SearchPosition* position;
+  /// @brief The analysis of the junctions of the root position, see
+  /// #bot_rate_moves_list. Used only by the base state (and the #BotWorker
+  /// states) of the smart strategy, @c NULL otherwise.
+  Junctions* junctions;
+  /// @brief The map of the regions for the junction checks below the root,
+  /// see #bot_rate_move.
+  ///
+  /// Loaded together with the #junctions and kept in sync with the #position
+  /// down to the #BotParameters::junction_check_recursion_limit. Owned by the
+  /// base state and shared by the substates, just like the #bitboard. @c NULL
+  /// if not used.
+  RegionMap* region_map;
+
+  /// @brief Caches the scores of the recursive evaluations performed by
+  /// #bot_rate_move. @c NULL if disabled by
+  /// #BotParameters::transposition_table_size.
+  ///
+  /// Just like the #bitboard, owned by the base state and shared by the
+  /// substates. The table is kept between the calls of #bot_compute_move, so
+  /// reusing the #BotState for consecutive turns allows hitting the positions
+  /// evaluated during the previous turns.
+  TranspositionTable* transposition_table;
+  /// @brief Mixed into the keys of the #transposition_table, derived from the
+  /// #BotParameters which affect the cached scores.
+  uint64_t transposition_salt;
+
+  /// @name Substates
+  /// See #bot_enter_substate.
+  /// @{
+
+  /// @brief The link to the next recursive substate, a frame of the
+  /// #search_stack. #bot_enter_substate allocates one only if the recursion
+  /// goes deeper than the stack.
+  struct BotState* substate;
+  /// @brief The recursion depth of the current state, starts at 0 for the base
+  /// state and increases in substates.
+  int depth;
+
+  /// @brief The recursion limit of the current iteration of #bot_compute_move,
+  /// copied to the substates. Equals #BotParameters::recursion_limit unless
+  /// the iterative deepening is in progress.
+  int recursion_limit;
+  /// @brief The scan area of the current iteration of #bot_compute_placement,
+  /// see #recursion_limit.
+  int placement_scan_area;
+
+  /// @}
+
+  /// @brief The scan area and the size of the board for which the
+  /// #placement_scores (together with #placement_kinds and
+  /// #placement_weights) were computed. They are kept between the calls of
+  /// #bot_compute_placement and updated incrementally, see
+  /// #bot_rate_all_placements. The area is negative if they aren't valid.
+  int placement_scores_area;
+  int placement_scores_width, placement_scores_height;
+  /// The number of the #PlacementTileKind s in the #placement_weights.
+  int placement_kinds_count;
+
+  /// @brief The helper threads, see #BotParameters::threads_count. Owned by the
+  /// base state, @c NULL in the substates.
+  BotWorker* workers;
+  /// The length of #workers.
+  int workers_count;
+
+  /// The state of the random number generator of the #BOT_MOVEMENT_MCTS playouts.
+  uint64_t mcts_random_state;
+
+  /// @brief The #BotStopToken checked by #bot_should_stop. Points to
+  /// #own_stop in the base state and the #BotWorker states, and to the token
+  /// of the parent state in the substates, so that the whole chain of the
+  /// recursive calls sees a cancellation or the deadline at once.
+  BotStopToken* stop;
+  /// The token of this state, unused in the substates.
+  BotStopToken own_stop;
+
+  /// @brief The arena of the substates, owned by the base state, @c NULL in
+  /// the substates. See #bot_prepare_search_stack.
+  BotSearchStack* search_stack;
+  /// @brief Set if this substate is a frame of the #search_stack, then its
+  /// #possible_steps, #all_moves, #move_scores, #tile_coords and
+  /// #search_values point into the arena.
+  bool in_search_stack;
 
   /// @name Allocation caches
   /// See also #bot_alloc_buf.
@@ -178,6 +395,14 @@ typedef struct BotState {
   Coords* tile_coords;
   size_t tile_scores_cap;
   int* tile_scores;
+  size_t placement_kinds_cap;
+  unsigned char* placement_kinds;
+  size_t placement_weights_cap;
+  int* placement_weights;
+  size_t placement_grid_cap;
+  int* placement_grid;
+  size_t placement_scores_cap;
+  int* placement_scores;
 
   size_t possible_steps_cap;
   PossibleSteps* possible_steps;
@@ -187,20 +412,65 @@ typedef struct BotState {
   int* move_scores;
   size_t fill_grid1_cap;
   short* fill_grid1;
-  size_t fill_grid2_cap;
-  short* fill_grid2;
   size_t fill_stack_cap;
   FillSpan* fill_stack;
+  size_t fill_planes_cap;
+  /// @brief The mask and the region planes of #bot_flood_fill_count_fish. The
+  /// mask holds the tiles not yet marked on the grid since the last
+  /// #bot_flood_fill_reset_grid.
+  uint64_t* fill_planes;
+  size_t search_values_cap;
+  int* search_values;
+  size_t mcts_nodes_cap;
+  struct MctsNode* mcts_nodes;
+  size_t mcts_steps_cap;
+  struct MctsStep* mcts_steps;
+  size_t endgame_memo_cap;
+  struct EndgameEntry* endgame_memo;
 
   /// @}
 } BotState;
 
+/// @brief A helper for allocating the buffers cached within the #BotState.
+///
+/// Checks if the buffer has enough capacity for data of the requested size, if
+/// not -- reallocates it at the requested size. The @c capacity and @c size
+/// arguments are the number of elements (not the number of bytes), and are
+/// implicitly converted to @c size_t (the multiplication by 1 is used for that).
+///
+/// In the debug builds every reallocation is counted in
+/// #bot_debug_allocations.
+#define bot_alloc_buf(buf, capacity, size)                                     \
+  ((size_t)1 * (size) > (capacity) ? (bot_count_allocation(),                  \
+                                      buf = realloc(buf, sizeof(*buf) * (size)), \
+                                      capacity = (size))                         \
+                                   : 0)
+
+#ifndef NDEBUG
+/// @brief The number of the heap allocations performed by the bot, only in
+/// the debug builds. Used by the tests to check that the searches run
+/// entirely within the preallocated memory, see #BotSearchStack.
+extern volatile int64_t bot_debug_allocations;
+/// Increments #bot_debug_allocations.
+#define bot_count_allocation() ((void)atomic_fetch_add_int64(&bot_debug_allocations, 1))
+#else
+#define bot_count_allocation() ((void)0)
+#endif
+
 BotState* bot_state_new(const BotParameters* params, Game* game, Rng* rng);
 void bot_state_free(BotState* self);
+void bot_state_set_game(BotState* self, Game* game);
 BotState* bot_enter_substate(BotState* self);
+void bot_prepare_search_stack(BotState* self);
+void bot_make_move(BotState* self, BotMove move);
+void bot_undo_move(BotState* self, BotMove move);
+bool bot_should_stop(BotState* self);
+void bot_cancel(BotState* self);
+uint64_t bot_start_timer(BotState* self);
 
 bool bot_compute_placement(BotState* self, Coords* out_target);
 int bot_rate_placement(BotState* self, Coords penguin);
+bool bot_rate_all_placements(BotState* self, int tiles_count, const Coords* tiles);
 
 bool bot_compute_move(BotState* self, Coords* out_penguin, Coords* out_target);
 BotMove* bot_generate_all_moves_list(
@@ -208,7 +478,6 @@ BotMove* bot_generate_all_moves_list(
 );
 int* bot_rate_moves_list(BotState* self, int moves_count, BotMove* moves_list);
 int bot_rate_move(BotState* self, BotMove move);
-bool bot_quick_junction_check(BotState* self, Coords coords);
 short* bot_flood_fill_reset_grid(BotState* self, short** fill_grid, size_t* fill_grid_cap);
 int bot_flood_fill_count_fish(BotState* self, short* grid, Coords start, short marker_value);
 
@@ -0,0 +1,241 @@
+// Late in the game the board usually falls apart into islands, and once a
+// penguin is left alone on its own island nobody else can take the fish there
+// anymore -- the only remaining question is in which order to visit the tiles
+// to collect as many of them as possible. This is the longest path problem,
+// which is NP-hard in general, but the islands are small, so it can simply be
+// solved by brute force: a depth-first search over all possible paths, where
+// the results are memoized by the set of the tiles remaining on the island and
+// the position of the penguin, since lots of paths lead to the same set.
+
+#include "endgame.h"
+#include "board.h"
+#include "bot.h"
+#include "game.h"
+#include "utils.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// @brief The maximum number of positions searched for a single region, after
+/// which the solver gives up and the move is computed by the usual algorithm.
+#define ENDGAME_MAX_NODES (1 << 20)
+
+/// @brief A region of the board reachable by a single penguin, in which the
+/// tiles are numbered from 0 to <tt>tiles_count - 1</tt>.
+typedef struct EndgameSolver {
+  BotState* self;
+  int tiles_count;
+  /// The coordinates of every tile, plus the starting tile of the penguin.
+  Coords tiles[ENDGAME_MAX_TILES + 1];
+  /// The number of fish on every tile.
+  int fish[ENDGAME_MAX_TILES];
+  /// @brief The index of the adjacent tile of every tile in every direction,
+  /// negative if there is none. The starting tile of the penguin has the index
+  /// #tiles_count.
+  signed char next[ENDGAME_MAX_TILES + 1][DIRECTION_MAX];
+  /// The bitsets of the adjacent tiles of every tile.
+  uint64_t neighbors[ENDGAME_MAX_TILES + 1];
+  int max_move_length;
+  int nodes_count;
+  /// Set if the search was cancelled or exceeded #ENDGAME_MAX_NODES.
+  bool aborted;
+} EndgameSolver;
+
+static inline uint64_t endgame_bit(int idx) {
+  return (uint64_t)1 << idx;
+}
+
+/// @brief Returns the subset of @c tiles which the penguin standing at @c
+/// position can still reach, the rest of the tiles are irrelevant.
+static uint64_t endgame_reachable(const EndgameSolver* solver, int position, uint64_t tiles) {
+  uint64_t reached = solver->neighbors[position] & tiles;
+  uint64_t frontier = reached;
+  while (frontier != 0) {
+    uint64_t expanded = 0;
+    for (uint64_t bits = frontier; bits != 0; bits &= bits - 1) {
+      expanded |= solver->neighbors[ctz64(bits)];
+    }
+    frontier = expanded & tiles & ~reached;
+    reached |= frontier;
+  }
+  return reached;
+}
+
+static int endgame_total_fish(const EndgameSolver* solver, uint64_t tiles) {
+  int total = 0;
+  for (; tiles != 0; tiles &= tiles - 1) {
+    total += solver->fish[ctz64(tiles)];
+  }
+  return total;
+}
+
+/// @brief Returns the most fish the penguin at @c position can collect from
+/// the @c tiles, which must all be reachable from the @c position. Writes the
+/// best move to @c out_target (as a tile index) if it is not @c NULL.
+static int endgame_search(
+  EndgameSolver* solver, int position, uint64_t tiles, int* out_target
+) {
+  if (tiles == 0 || solver->aborted) return 0;
+  BotState* self = solver->self;
+
+  EndgameEntry* entry = NULL;
+  if (out_target == NULL) {
+    uint64_t hash = splitmix64_mix(tiles ^ ((uint64_t)position << 58));
+    entry = &self->endgame_memo[hash & (ENDGAME_MEMO_SIZE - 1)];
+    if (entry->tiles == tiles && entry->position == position) {
+      return entry->value;
+    }
+  }
+
+  solver->nodes_count++;
+  if (solver->nodes_count > ENDGAME_MAX_NODES ||
+      ((solver->nodes_count & 1023) == 0 && bot_should_stop(self))) {
+    solver->aborted = true;
+    return 0;
+  }
+
+  // If every tile gets visited, there can't be a better path.
+  int total_fish = endgame_total_fish(solver, tiles);
+  int best_value = -1;
+  for (int dir = 0; dir < DIRECTION_MAX && best_value < total_fish; dir++) {
+    int target = solver->next[position][dir];
+    for (int steps = 1; steps <= solver->max_move_length; steps++) {
+      if (!(target >= 0 && (tiles & endgame_bit(target)))) break;
+      uint64_t remaining = endgame_reachable(solver, target, tiles & ~endgame_bit(target));
+      int value = solver->fish[target] + endgame_search(solver, target, remaining, NULL);
+      if (value > best_value) {
+        best_value = value;
+        if (out_target != NULL) *out_target = target;
+        if (best_value >= total_fish) break;
+      }
+      target = solver->next[target][dir];
+    }
+  }
+  if (solver->aborted) return 0;
+  // The penguin might not be able to move at all with a short move length.
+  best_value = my_max(best_value, 0);
+
+  if (entry != NULL) {
+    entry->tiles = tiles, entry->position = position, entry->value = best_value;
+  }
+  return best_value;
+}
+
+/// @brief Collects the tiles marked with @c marker on the fill @c grid into
+/// the @c solver. Returns @c false if there are too many of them.
+static bool endgame_load_region(
+  EndgameSolver* solver, short* grid, short marker, Coords penguin, int limit
+) {
+  Game* game = solver->self->game;
+  int w = game->board_width, h = game->board_height;
+  solver->tiles_count = 0;
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      if (grid[x + y * w] != marker) continue;
+      if (solver->tiles_count >= limit) return false;
+      Coords coords = { x, y };
+      int idx = solver->tiles_count++;
+      solver->tiles[idx] = coords;
+      solver->fish[idx] = get_tile_fish(get_tile(game, coords));
+      // The marker isn't needed anymore, so the tile indexes are stored in
+      // the grid in its place for computing the adjacency below. The regions
+      // are isolated, so the indexes left over from the regions of the other
+      // penguins are never adjacent to this one.
+      grid[x + y * w] = (short)-(idx + 1);
+    }
+  }
+  solver->tiles[solver->tiles_count] = penguin;
+
+  for (int i = 0; i <= solver->tiles_count; i++) {
+    solver->neighbors[i] = 0;
+    for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+      Coords neighbor = DIRECTION_TO_COORDS[dir];
+      neighbor.x += solver->tiles[i].x, neighbor.y += solver->tiles[i].y;
+      int idx = is_tile_in_bounds(game, neighbor) ? -grid[neighbor.x + neighbor.y * w] - 1 : -1;
+      if (!(0 <= idx && idx < solver->tiles_count)) idx = -1;
+      solver->next[i][dir] = (signed char)idx;
+      if (idx >= 0) solver->neighbors[i] |= endgame_bit(idx);
+    }
+  }
+  return true;
+}
+
+/// @relatedalso BotState
+/// @brief Computes the best move exactly if all penguins of the current
+/// player are isolated from the rest of the players.
+///
+/// The regions reachable by the penguins of the bot are labeled with
+/// #bot_flood_fill_count_fish, and if no other penguin (including the other
+/// penguins of the bot) can reach any of them, the moves of the bot no longer
+/// affect anybody else and the other way around. In this case the order in
+/// which the penguins are moved doesn't matter either, so the first penguin
+/// whose region has at most #BotParameters::endgame_tile_limit tiles is
+/// picked, and the first move on the longest path (by the number of fish)
+/// through its region is returned.
+///
+/// @returns @c false if the position can't be solved this way (the regions
+/// aren't isolated, are too large, or the search took too long), in which case
+/// the move must be computed by the usual means.
+bool bot_solve_endgame(BotState* self, Coords* out_penguin, Coords* out_target) {
+  Game* game = self->game;
+  int limit = my_min(self->params->endgame_tile_limit, ENDGAME_MAX_TILES);
+  if (limit <= 0) return false;
+  const Player* my_player = game_get_current_player(game);
+  int w = game->board_width;
+
+  short* grid = bot_flood_fill_reset_grid(self, &self->fill_grid1, &self->fill_grid1_cap);
+  for (int i = 0; i < my_player->penguins_count; i++) {
+    Coords penguin = my_player->penguins[i];
+    for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+      Coords neighbor = DIRECTION_TO_COORDS[dir];
+      neighbor.x += penguin.x, neighbor.y += penguin.y;
+      if (!is_tile_in_bounds(game, neighbor)) continue;
+      if (!is_fish_tile(get_tile(game, neighbor))) continue;
+      if (grid[neighbor.x + neighbor.y * w] == 0) {
+        bot_flood_fill_count_fish(self, grid, neighbor, (short)(i + 1));
+      }
+    }
+  }
+
+  // Now check that every penguin on the board is adjacent only to its own
+  // region (for the penguins of the opponents that is no region at all).
+  for (int player_idx = 0; player_idx < game->players_count; player_idx++) {
+    const Player* player = game_get_player(game, player_idx);
+    for (int i = 0; i < player->penguins_count; i++) {
+      short own_marker = player == my_player ? (short)(i + 1) : 0;
+      Coords penguin = player->penguins[i];
+      for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+        Coords neighbor = DIRECTION_TO_COORDS[dir];
+        neighbor.x += penguin.x, neighbor.y += penguin.y;
+        if (!is_tile_in_bounds(game, neighbor)) continue;
+        short marker = grid[neighbor.x + neighbor.y * w];
+        if (marker != 0 && marker != own_marker) return false;
+      }
+    }
+  }
+
+  bot_alloc_buf(self->endgame_memo, self->endgame_memo_cap, ENDGAME_MEMO_SIZE);
+  EndgameSolver solver_storage;
+  EndgameSolver* solver = &solver_storage;
+  solver->self = self;
+  solver->max_move_length = self->params->max_move_length;
+  bool solved = false;
+  for (int i = 0; i < my_player->penguins_count && !solved; i++) {
+    Coords penguin = my_player->penguins[i];
+    if (!endgame_load_region(solver, grid, (short)(i + 1), penguin, limit)) continue;
+    if (solver->tiles_count == 0) continue;
+    memset(self->endgame_memo, 0, sizeof(*self->endgame_memo) * ENDGAME_MEMO_SIZE);
+    solver->nodes_count = 0;
+    solver->aborted = false;
+    int start = solver->tiles_count, target = -1;
+    uint64_t tiles = endgame_bit(solver->tiles_count - 1) * 2 - 1;
+    endgame_search(solver, start, endgame_reachable(solver, start, tiles), &target);
+    if (!solver->aborted && target >= 0) {
+      *out_penguin = penguin, *out_target = solver->tiles[target];
+      solved = true;
+    }
+  }
+  return solved;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+/// @file
+/// @brief The exact solver of the endgame positions
+/// @see bot.h
+
+#include "bot.h"
+#include "utils.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief The largest region which can be solved by #bot_solve_endgame, the
+/// tiles of a region are stored as a bitset in a single 64-bit word.
+#define ENDGAME_MAX_TILES 64
+/// The number of entries in #BotState::endgame_memo, must be a power of two.
+#define ENDGAME_MEMO_SIZE (1 << 16)
+
+/// @brief An entry of the memoization table of #bot_solve_endgame.
+typedef struct EndgameEntry {
+  /// The set of the tiles which are still on the board, zero if the entry is empty.
+  uint64_t tiles;
+  /// The index of the tile the penguin is standing on.
+  int position;
+  /// The most fish which can be collected from this position.
+  int value;
+} EndgameEntry;
+
+bool bot_solve_endgame(BotState* self, Coords* out_penguin, Coords* out_target);
+
+#ifdef __cplusplus
+}
+#endif
@@ -21,6 +21,8 @@ Game* game_new(void) {
   self->board_width = -1;
   self->board_height = -1;
   self->board_grid = NULL;
+  self->tile_rays = NULL;
+  self->placeable_tiles_count = 0;
   self->tile_attributes = NULL;
   self->current_player_index = -1;
   self->log_disabled = false;
@@ -28,6 +30,7 @@ Game* game_new(void) {
   self->log_capacity = 0;
   self->log_length = 0;
   self->log_current = 0;
+  self->zobrist_key = 0;
   return self;
 }
 
@@ -40,8 +43,12 @@ Game* game_clone(const Game* other) {
     for (int i = 0; i < other->players_count; i++) {
       Player *player = &self->players[i], *other_player = &other->players[i];
       player->name = other_player->name ? strdup(other_player->name) : NULL;
-      player->penguins = memdup(
-        other_player->penguins, sizeof(*other_player->penguins) * other_player->penguins_count
+      // The lists must keep their capacity, penguins may be placed on the clone.
+      player->penguins = malloc(sizeof(*player->penguins) * my_max(0, other->penguins_per_player));
+      memcpy(
+        player->penguins,
+        other_player->penguins,
+        sizeof(*other_player->penguins) * other_player->penguins_count
       );
     }
   }
@@ -50,6 +57,12 @@ Game* game_clone(const Game* other) {
       other->board_grid, sizeof(*other->board_grid) * other->board_width * other->board_height
     );
   }
+  if (self->tile_rays) {
+    self->tile_rays = memdup(
+      other->tile_rays,
+      sizeof(*other->tile_rays) * other->board_width * other->board_height * DIRECTION_MAX
+    );
+  }
   if (self->tile_attributes) {
     self->tile_attributes = memdup(
       other->tile_attributes,
@@ -75,6 +88,7 @@ void game_free(Game* self) {
     free_and_clear(self->players);
   }
   free_and_clear(self->board_grid);
+  free_and_clear(self->tile_rays);
   free_and_clear(self->tile_attributes);
   free_and_clear(self->log_buffer);
   free(self);
@@ -114,6 +128,21 @@ uint32_t game_compute_state_hash(const Game* self) {
   return state;
 }
 
+/// @relatesalso Game
+/// @brief Computes the #Game::zobrist_key from scratch. The incrementally
+/// maintained key must always be equal to the result of this function, which
+/// is checked in the debug builds at the points where the game state changes
+/// in bulk (see #game_rewind_state_to_log_entry for example).
+uint64_t game_compute_zobrist_key(const Game* self) {
+  uint64_t key = game_zobrist_player_key(self->current_player_index);
+  if (self->board_grid) {
+    for (int i = 0; i < self->board_width * self->board_height; i++) {
+      key ^= game_zobrist_tile_key(i, self->board_grid[i]);
+    }
+  }
+  return key;
+}
+
 /// @relatesalso Game
 /// @brief Sets #Game::log_capacity and allocates that many elements in
 /// #Game::log_buffer. If the new capacity is less than #Game::log_length the
@@ -189,6 +218,15 @@ void game_set_phase(Game* self, GamePhase phase) {
   self->phase = phase;
 }
 
+/// @relatesalso Game
+/// @brief Writes #Game::current_player_index and updates #Game::zobrist_key
+/// without creating a log entry.
+static void game_write_current_player(Game* self, int idx) {
+  self->zobrist_key ^= game_zobrist_player_key(self->current_player_index);
+  self->zobrist_key ^= game_zobrist_player_key(idx);
+  self->current_player_index = idx;
+}
+
 /// @relatesalso Game
 /// @brief Sets #Game::current_player_index and creates a #GameLogPlayerChange
 /// log entry.
@@ -200,7 +238,16 @@ void game_set_current_player(Game* self, int idx) {
     entry_data->old_player_index = self->current_player_index;
     entry_data->new_player_index = idx;
   }
-  self->current_player_index = idx;
+  game_write_current_player(self, idx);
+}
+
+/// @relatesalso Game
+/// @brief Removes a #GameLogPlayerChange entry from the log and undoes it.
+void game_undo_set_current_player(Game* self) {
+  const GameLogPlayerChange* entry_data =
+    &game_pop_log_entry(self, GAME_LOG_ENTRY_PLAYER_CHANGE)->data.player_change;
+  assert(self->current_player_index == entry_data->new_player_index);
+  game_write_current_player(self, entry_data->old_player_index);
 }
 
 /// @relatesalso Game
@@ -238,6 +285,7 @@ void game_end_setup(Game* self) {
       assert(self->players[i].penguins != NULL);
     }
   }
+  assert(self->zobrist_key == game_compute_zobrist_key(self));
   game_set_phase(self, GAME_PHASE_SETUP_DONE);
 }
 
@@ -255,6 +303,7 @@ void game_set_penguins_per_player(Game* self, int value) {
     player->penguins =
       realloc(player->penguins, sizeof(*player->penguins) * self->penguins_per_player);
   }
+  game_recount_mobile_penguins(self);
 }
 
 /// @relatesalso Game
@@ -275,6 +324,7 @@ void game_set_players_count(Game* self, int count) {
     player->penguins_count = 0;
     player->penguins = malloc(sizeof(*player->penguins) * my_max(0, self->penguins_per_player));
     player->moves_count = 0;
+    player->mobile_penguins_count = 0;
     player->color = 0;
   }
 }
@@ -291,6 +341,15 @@ void game_set_player_name(Game* self, int idx, const char* name) {
   player->name = name ? strdup(name) : NULL;
 }
 
+/// @relatesalso Game
+/// @brief Checks whether a penguin at @c coords has at least one possible
+/// step. Before #setup_board is called (or outside of the board) nothing is
+/// mobile.
+static bool game_is_penguin_mobile(const Game* self, Coords coords) {
+  return self->tile_rays != NULL && is_tile_in_bounds(self, coords) &&
+         count_obstructed_directions(self, coords) < DIRECTION_MAX;
+}
+
 /// @relatesalso Game
 /// @details Fails when #Player::penguins_count is already at the maximum value
 /// (#Game::penguins_per_player).
@@ -298,6 +357,7 @@ void game_add_player_penguin(Game* self, int idx, Coords coords) {
   Player* player = game_get_player(self, idx);
   assert(0 <= player->penguins_count && player->penguins_count < self->penguins_per_player);
   player->penguins[player->penguins_count++] = coords;
+  player->mobile_penguins_count += game_is_penguin_mobile(self, coords);
 }
 
 /// @relatesalso Game
@@ -314,6 +374,34 @@ void game_remove_player_penguin(Game* self, int idx, Coords coords) {
     player->penguins[i] = player->penguins[i + 1];
   }
   player->penguins_count -= 1;
+  player->mobile_penguins_count -= game_is_penguin_mobile(self, coords);
+}
+
+/// @relatesalso Game
+/// @brief Changes the position of the penguin of the player at @c idx in the
+/// #Player::penguins list (without touching the board). Fails if the player
+/// doesn't have a penguin at @c from.
+void game_move_player_penguin(Game* self, int idx, Coords from, Coords to) {
+  Player* player = game_get_player(self, idx);
+  Coords* penguin = game_find_player_penguin(self, idx, from);
+  assert(penguin != NULL);
+  *penguin = to;
+  player->mobile_penguins_count -= game_is_penguin_mobile(self, from);
+  player->mobile_penguins_count += game_is_penguin_mobile(self, to);
+}
+
+/// @relatesalso Game
+/// @brief Recomputes #Player::mobile_penguins_count of all players from
+/// scratch, for when the board or the #Player::penguins lists have been
+/// replaced wholesale.
+void game_recount_mobile_penguins(Game* self) {
+  for (int i = 0; i < self->players_count; i++) {
+    Player* player = &self->players[i];
+    player->mobile_penguins_count = 0;
+    for (int j = 0; j < player->penguins_count; j++) {
+      player->mobile_penguins_count += game_is_penguin_mobile(self, player->penguins[j]);
+    }
+  }
 }
 
 /// @relatesalso Game
@@ -386,13 +474,7 @@ void game_rewind_state_to_log_entry(Game* self, size_t target_entry) {
         self->phase = entry_data->old_phase;
         break;
       }
-      case GAME_LOG_ENTRY_PLAYER_CHANGE: {
-        const GameLogPlayerChange* entry_data =
-          &game_pop_log_entry(self, GAME_LOG_ENTRY_PLAYER_CHANGE)->data.player_change;
-        assert(self->current_player_index == entry_data->new_player_index);
-        self->current_player_index = entry_data->old_player_index;
-        break;
-      }
+      case GAME_LOG_ENTRY_PLAYER_CHANGE: game_undo_set_current_player(self); break;
       case GAME_LOG_ENTRY_PLACEMENT: undo_place_penguin(self); break;
       case GAME_LOG_ENTRY_MOVEMENT: undo_move_penguin(self); break;
     }
@@ -412,7 +494,7 @@ void game_rewind_state_to_log_entry(Game* self, size_t target_entry) {
       case GAME_LOG_ENTRY_PLAYER_CHANGE: {
         const GameLogPlayerChange* entry_data = &entry->data.player_change;
         assert(self->current_player_index == entry_data->old_player_index);
-        self->current_player_index = entry_data->new_player_index;
+        game_write_current_player(self, entry_data->new_player_index);
         break;
       }
       case GAME_LOG_ENTRY_PLACEMENT: {
@@ -429,6 +511,7 @@ void game_rewind_state_to_log_entry(Game* self, size_t target_entry) {
   }
 
   self->log_disabled = prev_log_disabled;
+  assert(self->zobrist_key == game_compute_zobrist_key(self));
 }
 
 extern bool game_check_player_index(const Game* self, int idx);
@@ -436,3 +519,5 @@ extern Player* game_get_player(const Game* self, int idx);
 extern Player* game_get_current_player(const Game* self);
 extern int game_find_player_by_id(const Game* self, short id);
 extern Coords* game_find_player_penguin(const Game* self, int idx, Coords coords);
+extern uint64_t game_zobrist_tile_key(int idx, short tile);
+extern uint64_t game_zobrist_player_key(int idx);
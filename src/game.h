@@ -79,6 +79,10 @@ typedef struct Player {
   Coords* penguins;
   /// The number of moves (penguin placements and movements) made by the player.
   int moves_count;
+  /// @brief The number of the #penguins which have at least one possible step,
+  /// kept up to date by #set_tile and the functions which change the
+  /// #penguins list, see #any_valid_player_move_exists.
+  int mobile_penguins_count;
   /// The color of the penguins, currently used only in the TUI.
   int color;
 } Player;
@@ -305,6 +309,24 @@ typedef struct Game {
   /// bytes long).
   short* board_grid;
 
+  /// @brief The lengths of the rays of every tile: for every #Direction, the
+  /// number of the consecutive fish tiles next to the tile in that direction,
+  /// which for a penguin is the number of steps it can make. Stored as
+  /// #DIRECTION_MAX entries per tile in the same layout as #board_grid.
+  ///
+  /// Maintained by #set_tile: when a tile stops (or starts) being walkable,
+  /// only the rays pointing at it from the same row and column are changed,
+  /// and only until the nearest non-walkable tile, see #update_tile_rays.
+  /// Thanks to this #calculate_penguin_possible_moves and
+  /// #count_obstructed_directions are just lookups, regardless of the length
+  /// of the rays, and undoing a change of a tile is simply another change.
+  short* tile_rays;
+
+  /// @brief The number of tiles with exactly one fish, i.e. of the places
+  /// where a penguin can be put in the placement phase. Kept up to date by
+  /// #set_tile, see #any_valid_placement_exists.
+  int placeable_tiles_count;
+
   /// @brief Stores auxilary data of grid tiles for use in the UIs. Use
   /// #setup_board for initializing, #get_tile_attr and #set_tile_attr for
   /// accessing.
@@ -354,6 +376,22 @@ typedef struct Game {
   size_t log_current;
 
   /// @}
+
+  /// @brief The Zobrist hash of the position: the tiles of the board and the
+  /// current player.
+  ///
+  /// The key is the XOR of the keys of every tile (see #game_zobrist_tile_key)
+  /// and of the current player (see #game_zobrist_player_key), which means
+  /// that it can be updated in constant time whenever a tile or the current
+  /// player changes by XOR-ing out the key of the old value and XOR-ing in the
+  /// key of the new one -- #set_tile and #game_set_current_player do exactly
+  /// that, so the key is always up to date and serves as a cheap identifier
+  /// of a position for caches. Unlike #game_compute_state_hash it doesn't
+  /// cover the scores, the phase and the settings. #game_compute_zobrist_key
+  /// recomputes it from scratch.
+  ///
+  /// @see <https://en.wikipedia.org/wiki/Zobrist_hashing>
+  uint64_t zobrist_key;
 } Game;
 
 Game* game_new(void);
@@ -361,6 +399,7 @@ Game* game_clone(const Game* other);
 void game_free(Game* self);
 
 uint32_t game_compute_state_hash(const Game* self);
+uint64_t game_compute_zobrist_key(const Game* self);
 void game_set_log_capacity(Game* self, size_t capacity);
 GameLogEntry* game_push_log_entry(Game* self, GameLogEntryType type);
 const GameLogEntry* game_pop_log_entry(Game* self, GameLogEntryType expected_type);
@@ -368,6 +407,7 @@ const GameLogEntry* game_get_log_entry(const Game* self, size_t idx);
 
 void game_set_phase(Game* self, GamePhase phase);
 void game_set_current_player(Game* self, int idx);
+void game_undo_set_current_player(Game* self);
 
 void game_begin_setup(Game* self);
 void game_end_setup(Game* self);
@@ -377,6 +417,8 @@ void game_set_player_name(Game* self, int idx, const char* name);
 
 void game_add_player_penguin(Game* self, int idx, Coords coords);
 void game_remove_player_penguin(Game* self, int idx, Coords coords);
+void game_move_player_penguin(Game* self, int idx, Coords from, Coords to);
+void game_recount_mobile_penguins(Game* self);
 
 void game_advance_state(Game* self);
 void game_end(Game* self);
@@ -428,6 +470,27 @@ inline Coords* game_find_player_penguin(const Game* self, int idx, Coords coords
   return NULL;
 }
 
+/// @relatesalso Game
+/// @brief Returns the contribution of the tile at the index @c idx of the
+/// #Game::board_grid with the value @c tile to the #Game::zobrist_key.
+///
+/// Instead of a table of random numbers the keys are derived by hashing the
+/// index and the value, so that they don't depend on the board size and don't
+/// need any initialization. Water tiles have a zero key, so an empty board
+/// hashes to zero.
+inline ALWAYS_INLINE uint64_t game_zobrist_tile_key(int idx, short tile) {
+  if (tile == 0) return 0;
+  return splitmix64_mix((uint64_t)idx << 16 | (uint16_t)tile);
+}
+
+/// @relatesalso Game
+/// @brief Returns the contribution of the current player index to the
+/// #Game::zobrist_key, zero if no player is selected.
+inline ALWAYS_INLINE uint64_t game_zobrist_player_key(int idx) {
+  if (idx < 0) return 0;
+  return splitmix64_mix(UINT64_C(0x9E3779B97F4A7C15) ^ (uint64_t)idx);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,4 +1,6 @@
 #include "gui/better_random.hh"
+#include "utils.h"
+#include <cstdint>
 #include <memory>
 #include <random>
 
@@ -7,12 +9,6 @@ BetterRng::BetterRng() {
   // kilobytes (on GCC/Linux), therefore I think its better to allocate it on
   // the heap.
   std::unique_ptr<std::random_device> rng_dev(new std::random_device());
-  this->rng_engine.seed((*rng_dev)());
-  this->random_range = &random_range_impl;
-}
-
-int BetterRng::random_range_impl(Rng* rng, int min, int max) {
-  auto self = (BetterRng*)rng;
-  std::uniform_int_distribution<int> distribution(min, max);
-  return distribution(self->rng_engine);
+  uint64_t seed = (uint64_t)(*rng_dev)() << 32 | (uint64_t)(*rng_dev)();
+  *static_cast<Rng*>(this) = init_rng(seed);
 }
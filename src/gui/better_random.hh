@@ -1,10 +1,9 @@
 #pragma once
 
 #include "utils.h"
-#include <random>
 
-/// @brief An implementation of #Rng for C++ using the standard functions from
-/// @c \<random\>.
+/// @brief The #Rng of the GUI: the generator of #init_rng seeded with @c
+/// std::random_device instead of the clock.
 ///
 /// Here I abuse the fact that if class B inherits from class A, given an
 /// instance of B a pointer of the type A may be created to it and using the
@@ -19,11 +18,6 @@
 /// now #BetterRng can be passed anywhere #Rng can.
 struct BetterRng : Rng {
 public:
-  std::default_random_engine rng_engine;
-  /// Seeds the #rng_engine using @c std::random_device.
+  /// Seeds the generator using @c std::random_device.
   BetterRng();
-
-private:
-  /// See #Rng::random_range.
-  static int random_range_impl(Rng* rng, int min, int max);
 };
@@ -1,11 +1,19 @@
 #include "gui/bot_thread.hh"
 #include "bot.h"
+#include "game.h"
 #include "gui/controllers.hh"
+#include "gui/game.hh"
+#include "gui/game_state.hh"
 #include "movement.h"
 #include "placement.h"
 #include "utils.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
 #include <wx/debug.h>
 #include <wx/thread.h>
+#include <wx/vector.h>
 
 void BotThreadShared::wait_for_exit() {
   wxMutexLocker lock(this->mutex);
@@ -22,19 +30,77 @@ void BotThreadShared::notify_exit() {
   this->condvar.Broadcast();
 }
 
-BotThread::BotThread(BotTurnController* controller)
-: wxThread(wxTHREAD_DETACHED), controller(controller), bot_params(controller->bot_params) {
-  this->game.reset(game_clone(controller->game));
-  this->bot_state.reset(bot_state_new(this->bot_params.get(), this->game.get(), &this->rng));
-  this->cancelled_ptr = &this->bot_state->cancelled;
+uint64_t BotPonderTable::key(const Game* game) {
+  // The Zobrist key covers the tiles and the current player, but the same
+  // tiles may be seen both at the end of the placement phase and at the start
+  // of the movement phase.
+  uint64_t key = game->zobrist_key ^ splitmix64_mix(static_cast<uint64_t>(game->phase));
+  // And the same tiles can also be reached with different scores (when the
+  // penguins have come along different paths), which the bot takes into account.
+  for (int i = 0; i < game->players_count; i++) {
+    key = splitmix64_mix(key ^ static_cast<uint32_t>(game_get_player(game, i)->points));
+  }
+  return key;
+}
+
+bool BotPonderTable::contains(const Game* game) {
+  wxCriticalSectionLocker enter(this->cs);
+  return this->results.count(key(game)) != 0;
 }
 
-BotThread::~BotThread() {
-  this->cancelled_ptr = nullptr;
+void BotPonderTable::store(const Game* game, const Result& result) {
+  wxCriticalSectionLocker enter(this->cs);
+  this->results[key(game)] = result;
+}
+
+// Looks up the answer for the current position and clears the table: the
+// rest of the answers are for the positions which haven't come up.
+bool BotPonderTable::take(const Game* game, Result* out_result) {
+  wxCriticalSectionLocker enter(this->cs);
+  auto it = this->results.find(key(game));
+  bool found = it != this->results.end();
+  if (found) *out_result = it->second;
+  this->results.clear();
+  return found;
+}
+
+// Gives the bot a copy of the current state of the game, the BotState with all
+// of its caches is kept.
+BotState* BotPlayerState::prepare_turn(const Game* game) {
+  this->game.reset(game_clone(game));
+  if (this->bot_state == nullptr) {
+    this->bot_state.reset(bot_state_new(this->params.get(), this->game.get(), &this->rng));
+  } else {
+    bot_state_set_game(this->bot_state.get(), this->game.get());
+    // The previous computation might have been cancelled.
+    this->bot_state->stop->cancelled = false;
+  }
+  return this->bot_state.get();
+}
+
+BotThread::BotThread(GameController* controller, std::shared_ptr<BotPlayerState> bot)
+: wxThread(wxTHREAD_DETACHED)
+, controller(controller)
+, ponder_table(controller->panel->ponder_table)
+, bot(bot) {
+  // The previous thread which used the same bot has already exited, see
+  // GameController::stop_bot_thread.
+  this->bot_state = bot->prepare_turn(controller->game);
+  this->game = bot->game.get();
+}
+
+BotThread::~BotThread() {}
+
+// Done on the main thread before the BotPonderThread of this turn is started,
+// which would otherwise race with the clearing of the table.
+void BotThread::take_pondered() {
+  this->has_pondered = this->ponder_table->take(this->game, &this->pondered);
 }
 
 void BotThread::cancel() {
-  *this->cancelled_ptr = true;
+  // Reaches every substate and helper thread of the bot through the shared
+  // stop token, so that the search unwinds right away.
+  bot_cancel(this->bot_state);
 }
 
 void BotThread::OnExit() {
@@ -45,12 +111,24 @@ void BotThread::OnExit() {
   this->shared->notify_exit();
 }
 
+BotPlacementThread::BotPlacementThread(BotTurnController* controller)
+: BotThread(controller, controller->panel->bot_players.at(controller->game->current_player_index))
+, turn_controller(controller) {
+  this->take_pondered();
+}
+
 wxThread::ExitCode BotPlacementThread::Entry() {
   this->SetName("bot-placement");
   Coords target;
-  bool ok = bot_compute_placement(this->bot_state.get(), &target);
-  bool cancelled = this->bot_state->cancelled;
-  auto controller = this->controller;
+  bool ok;
+  if (this->has_pondered &&
+      validate_placement(this->game, this->pondered.target) == PLACEMENT_VALID) {
+    target = this->pondered.target, ok = true;
+  } else {
+    ok = bot_compute_placement(this->bot_state, &target);
+  }
+  bool cancelled = this->bot_state->stop->cancelled;
+  auto controller = this->turn_controller;
   auto shared = this->shared;
   controller->CallAfter([=]() -> void {
     shared->wait_for_exit();
@@ -60,12 +138,25 @@ wxThread::ExitCode BotPlacementThread::Entry() {
   return 0;
 }
 
+BotMovementThread::BotMovementThread(BotTurnController* controller)
+: BotThread(controller, controller->panel->bot_players.at(controller->game->current_player_index))
+, turn_controller(controller) {
+  this->take_pondered();
+}
+
 wxThread::ExitCode BotMovementThread::Entry() {
   this->SetName("bot-movement");
   Coords penguin, target;
-  bool ok = bot_compute_move(this->bot_state.get(), &penguin, &target);
-  bool cancelled = this->bot_state->cancelled;
-  auto controller = this->controller;
+  bool ok;
+  if (this->has_pondered &&
+      validate_movement(this->game, this->pondered.penguin, this->pondered.target, nullptr) ==
+        MOVEMENT_VALID) {
+    penguin = this->pondered.penguin, target = this->pondered.target, ok = true;
+  } else {
+    ok = bot_compute_move(this->bot_state, &penguin, &target);
+  }
+  bool cancelled = this->bot_state->stop->cancelled;
+  auto controller = this->turn_controller;
   auto shared = this->shared;
   controller->CallAfter([=]() -> void {
     shared->wait_for_exit();
@@ -74,3 +165,135 @@ wxThread::ExitCode BotMovementThread::Entry() {
   });
   return 0;
 }
+
+BotPonderThread::BotPonderThread(
+  GameController* controller, const wxVector<PlayerType>& player_types
+)
+: BotThread(controller, controller->panel->ponder_bot), player_types(player_types) {
+  this->low_priority = true;
+}
+
+// Pondering all possible replies would take too long, especially in the
+// placement phase, and most of the answers would go to waste anyway.
+static const size_t MAX_PONDERED_REPLIES = 16;
+
+wxThread::ExitCode BotPonderThread::Entry() {
+  this->SetName("bot-ponder");
+  Game* game = this->game;
+  BotState* bot = this->bot_state;
+
+  wxVector<BotMove> moves;
+  if (game->phase == GAME_PHASE_PLACEMENT) {
+    for (int y = 0; y < game->board_height; y++) {
+      for (int x = 0; x < game->board_width; x++) {
+        Coords coords = { x, y };
+        if (validate_placement_simple(game, coords)) {
+          moves.push_back({ { -1, -1 }, coords });
+        }
+      }
+    }
+  } else if (game->phase == GAME_PHASE_MOVEMENT) {
+    const Player* player = game_get_current_player(game);
+    for (int i = 0; i < player->penguins_count; i++) {
+      Coords penguin = player->penguins[i];
+      PossibleSteps steps = calculate_penguin_possible_moves(game, penguin);
+      for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+        Coords d = DIRECTION_TO_COORDS[dir], target = penguin;
+        for (int count = steps.steps[dir]; count > 0; count--) {
+          target.x += d.x, target.y += d.y;
+          moves.push_back({ penguin, target });
+        }
+      }
+    }
+  }
+
+  // Before searching for anything, keep only the replies after which it is
+  // the turn of a bot, there is nothing to ponder otherwise.
+  wxVector<std::pair<int, BotMove>> replies;
+  for (const BotMove& move : moves) {
+    if (bot->stop->cancelled) return 0;
+    size_t start_entry = game->log_current;
+    this->play_reply(move);
+    bool is_bot_turn = this->is_bot_turn();
+    game_rewind_state_to_log_entry(game, start_entry);
+    if (!is_bot_turn) continue;
+    // The placements are cheap to rate, the tiles the bot itself likes the
+    // most are the likeliest to be picked by the player.
+    int score = game->phase == GAME_PHASE_PLACEMENT ? bot_rate_placement(bot, move.target) : 0;
+    replies.push_back(std::make_pair(score, move));
+  }
+  if (replies.empty()) return 0;
+  std::stable_sort(
+    replies.begin(),
+    replies.end(),
+    [](const std::pair<int, BotMove>& a, const std::pair<int, BotMove>& b) -> bool {
+      return a.first > b.first;
+    }
+  );
+
+  // The likeliest reply is the one the bot would have made itself, so the
+  // answer to it is searched first.
+  BotMove predicted = { { -1, -1 }, { -1, -1 } };
+  bool ok = game->phase == GAME_PHASE_PLACEMENT
+              ? bot_compute_placement(bot, &predicted.target)
+              : bot_compute_move(bot, &predicted.penguin, &predicted.target);
+  if (bot->stop->cancelled) return 0;
+  size_t pondered = 0;
+  if (ok) {
+    this->ponder_reply(predicted);
+    pondered++;
+  }
+
+  for (const auto& reply : replies) {
+    if (bot->stop->cancelled || pondered >= MAX_PONDERED_REPLIES) break;
+    const BotMove& move = reply.second;
+    if (coords_same(move.penguin, predicted.penguin) &&
+        coords_same(move.target, predicted.target)) {
+      continue;
+    }
+    this->ponder_reply(move);
+    pondered++;
+  }
+  return 0;
+}
+
+// Makes the move of the current player, the same way as what
+// GamePanel::update_game_state does after every move.
+void BotPonderThread::play_reply(const BotMove& reply) {
+  Game* game = this->game;
+  if (game->phase == GAME_PHASE_PLACEMENT) {
+    place_penguin(game, reply.target);
+  } else {
+    move_penguin(game, reply.penguin, reply.target);
+  }
+  game_advance_state(game);
+}
+
+bool BotPonderThread::is_bot_turn() {
+  Game* game = this->game;
+  int idx = game->current_player_index;
+  return game_check_player_index(game, idx) && this->player_types.at(idx) == PLAYER_BOT;
+}
+
+// Plays the move of the current player, then searches for the answer of the
+// next player if it is a bot, and rewinds the game back.
+void BotPonderThread::ponder_reply(const BotMove& reply) {
+  Game* game = this->game;
+  size_t start_entry = game->log_current;
+  this->play_reply(reply);
+  if (this->is_bot_turn() && !this->ponder_table->contains(game)) {
+    BotState* bot = this->bot_state;
+    BotPonderTable::Result result = { { -1, -1 }, { -1, -1 } };
+    bool ok = false;
+    if (game->phase == GAME_PHASE_PLACEMENT) {
+      ok = bot_compute_placement(bot, &result.target);
+    } else if (game->phase == GAME_PHASE_MOVEMENT) {
+      ok = bot_compute_move(bot, &result.penguin, &result.target);
+    }
+    if (ok && !bot->stop->cancelled) {
+      this->ponder_table->store(game, result);
+    }
+  }
+
+  game_rewind_state_to_log_entry(game, start_entry);
+}
@@ -3,11 +3,17 @@
 #include "bot.h"
 #include "game.h"
 #include "gui/better_random.hh"
+#include "gui/game_state.hh"
+#include "utils.h"
+#include <cstdint>
 #include <memory>
+#include <unordered_map>
 #include <wx/defs.h>
 #include <wx/thread.h>
+#include <wx/vector.h>
 #include <wx/version.h>
 
+class GameController;
 class BotTurnController;
 
 // The implementation of this class is somewhat based on
@@ -28,16 +34,63 @@ protected:
   wxDECLARE_NO_COPY_CLASS(BotThreadShared);
 };
 
+// The answers of the bots computed in advance by the BotPonderThread while the
+// other players (humans or bots) are thinking, for the positions which might
+// come up on the next turn. Shared between the threads.
+class BotPonderTable {
+public:
+  struct Result {
+    Coords penguin, target;
+  };
+
+  BotPonderTable() {}
+
+  static uint64_t key(const Game* game);
+  bool contains(const Game* game);
+  void store(const Game* game, const Result& result);
+  bool take(const Game* game, Result* out_result);
+
+protected:
+  wxCriticalSection cs{};
+  std::unordered_map<uint64_t, Result> results{};
+
+  wxDECLARE_NO_COPY_CLASS(BotPonderTable);
+};
+
+// A bot player which lives for the whole game, so that its caches (the
+// transposition table, the placement scores) are reused between the turns.
+// Kept by the GamePanel and handed to one BotThread at a time.
+class BotPlayerState {
+public:
+  explicit BotPlayerState(std::shared_ptr<BotParameters> params) : params(params) {}
+
+  BotState* prepare_turn(const Game* game);
+
+  // Shared with the GamePanel (except for the pondering bot), so that all bots
+  // read the same parameters instead of the copies made at the game start.
+  std::shared_ptr<BotParameters> params;
+  std::unique_ptr<Game, decltype(&game_free)> game{ nullptr, game_free };
+  std::unique_ptr<BotState, decltype(&bot_state_free)> bot_state{ nullptr, bot_state_free };
+  BetterRng rng;
+
+protected:
+  wxDECLARE_NO_COPY_CLASS(BotPlayerState);
+};
+
 class BotThread : public wxThread {
 public:
-  BotThread(BotTurnController* controller);
+  BotThread(GameController* controller, std::shared_ptr<BotPlayerState> bot);
   virtual ~BotThread();
   void cancel();
 
+  // Pondering must not slow down the UI or the other bots.
+  bool low_priority = false;
+
   std::shared_ptr<BotThreadShared> shared{ new BotThreadShared() };
 
 protected:
   virtual void OnExit() override;
+  void take_pondered();
 
 #if !wxCHECK_VERSION(3, 1, 6)
   // Stub for when this method is not available.
@@ -46,26 +99,44 @@ protected:
   }
 #endif
 
-  BotTurnController* controller;
-  std::unique_ptr<Game, decltype(&game_free)> game{ nullptr, game_free };
-  std::shared_ptr<BotParameters> bot_params{ nullptr };
-  std::unique_ptr<BotState, decltype(&bot_state_free)> bot_state{ nullptr, bot_state_free };
-  BetterRng rng;
-  volatile bool* cancelled_ptr = nullptr;
+  GameController* controller;
+  std::shared_ptr<BotPonderTable> ponder_table{ nullptr };
+  // Holds the game and the bot_state below.
+  std::shared_ptr<BotPlayerState> bot{ nullptr };
+  Game* game = nullptr;
+  BotState* bot_state = nullptr;
+  BotPonderTable::Result pondered{ { -1, -1 }, { -1, -1 } };
+  bool has_pondered = false;
 };
 
 class BotPlacementThread : public BotThread {
 public:
-  BotPlacementThread(BotTurnController* controller) : BotThread(controller) {}
+  BotPlacementThread(BotTurnController* controller);
 
 protected:
   virtual ExitCode Entry() override;
+  BotTurnController* turn_controller;
 };
 
 class BotMovementThread : public BotThread {
 public:
-  BotMovementThread(BotTurnController* controller) : BotThread(controller) {}
+  BotMovementThread(BotTurnController* controller);
+
+protected:
+  virtual ExitCode Entry() override;
+  BotTurnController* turn_controller;
+};
+
+// Searches for the answers of the next bot player to the possible moves of
+// the current player and puts them into the BotPonderTable.
+class BotPonderThread : public BotThread {
+public:
+  BotPonderThread(GameController* controller, const wxVector<PlayerType>& player_types);
 
 protected:
   virtual ExitCode Entry() override;
+  void play_reply(const BotMove& reply);
+  bool is_bot_turn();
+  void ponder_reply(const BotMove& reply);
+  wxVector<PlayerType> player_types;
 };
@@ -19,6 +19,10 @@
 GameController::GameController(GamePanel* panel)
 : panel(panel), canvas(panel->canvas), game(panel->game.get()), bot_params(panel->bot_params) {}
 
+GameController::~GameController() {
+  this->stop_bot_thread();
+}
+
 void GameController::update_game_state_and_indirectly_delete_this() {
   this->panel->update_game_state();
 }
@@ -39,7 +43,14 @@ void GameController::configure_log_viewer_ui() {
   this->panel->show_current_turn_btn->Disable();
 }
 
-void GameController::on_deactivated(GameController* WXUNUSED(next_controller)) {}
+void GameController::on_deactivated(GameController* WXUNUSED(next_controller)) {
+  this->stop_bot_thread();
+}
+
+BotThread* GameController::create_bot_thread() {
+  return nullptr;
+}
+
 void GameController::paint_overlay(wxDC& WXUNUSED(dc)) {}
 void GameController::on_mouse_down(wxMouseEvent& WXUNUSED(event)) {}
 void GameController::on_mouse_move(wxMouseEvent& WXUNUSED(event)) {}
@@ -79,15 +90,21 @@ BotThread* BotMovementController::create_bot_thread() {
 
 void BotTurnController::on_activated() {
   this->GameController::on_activated();
+  this->executing_bot_turn = true;
   this->start_bot_thread();
+  // The next bot can think about its answers while this one is busy too.
+  this->start_ponder_thread();
 }
 
-void BotTurnController::on_deactivated(GameController* WXUNUSED(next_controller)) {
-  this->stop_bot_thread();
+void BotTurnController::on_deactivated(GameController* next_controller) {
+  this->GameController::on_deactivated(next_controller);
+  this->executing_bot_turn = false;
 }
 
-BotTurnController::~BotTurnController() {
-  this->stop_bot_thread();
+void PlayerTurnController::on_activated() {
+  this->GameController::on_activated();
+  // While the player is thinking, the bot can already think about its answer.
+  this->start_ponder_thread();
 }
 
 void BotTurnController::on_bot_thread_done_work(bool cancelled) {
@@ -99,39 +116,66 @@ void BotTurnController::on_bot_thread_done_work(bool cancelled) {
   }
 }
 
-void BotTurnController::start_bot_thread() {
+void GameController::start_bot_thread() {
   wxASSERT(wxThread::IsMain());
-  this->executing_bot_turn = true;
   BotThread* thread = this->create_bot_thread();
+  if (thread == nullptr) return;
+  this->run_bot_thread(thread, &this->bot_thread);
+}
+
+void GameController::start_ponder_thread() {
+  wxASSERT(wxThread::IsMain());
   {
     wxCriticalSectionLocker enter(this->bot_thread_cs);
-    wxASSERT(this->bot_thread == nullptr);
-    this->bot_thread = thread;
+    // Might still be running if only the bot_thread was restarted.
+    if (this->ponder_thread != nullptr) return;
+  }
+  if (this->panel->ponder_bot == nullptr) return;
+  this->run_bot_thread(new BotPonderThread(this, this->panel->player_types), &this->ponder_thread);
+}
+
+void GameController::run_bot_thread(BotThread* thread, BotThread** slot) {
+  if (thread->low_priority) {
+    // The priority can only be changed between these two calls on the older
+    // versions of wxWidgets.
+    wxThreadError code WX_ATTRIBUTE_UNUSED = thread->Create();
+    wxASSERT(code == wxTHREAD_NO_ERROR);
+    thread->SetPriority(wxPRIORITY_MIN);
+  }
+  {
+    wxCriticalSectionLocker enter(this->bot_thread_cs);
+    wxASSERT(*slot == nullptr);
+    *slot = thread;
   }
   wxThreadError code WX_ATTRIBUTE_UNUSED = thread->Run();
   wxASSERT(code == wxTHREAD_NO_ERROR);
 }
 
-void BotTurnController::stop_bot_thread() {
+void GameController::stop_bot_thread() {
   wxASSERT(wxThread::IsMain());
   // Well, this ain't the best way of doing thread synchronization, but it sure
   // does work.
-  std::shared_ptr<BotThreadShared> shared = nullptr;
+  std::shared_ptr<BotThreadShared> shared[2] = { nullptr, nullptr };
   {
     wxCriticalSectionLocker enter(this->bot_thread_cs);
-    if (this->bot_thread) {
-      this->bot_thread->cancel();
-      shared = this->bot_thread->shared;
-      this->bot_thread = nullptr;
+    BotThread** slots[2] = { &this->bot_thread, &this->ponder_thread };
+    for (int i = 0; i < 2; i++) {
+      if (*slots[i]) {
+        // Both threads are cancelled first, so that they wind down together.
+        (*slots[i])->cancel();
+        shared[i] = (*slots[i])->shared;
+        *slots[i] = nullptr;
+      }
     }
   }
-  if (shared) {
-    shared->wait_for_exit();
+  for (auto& thread_shared : shared) {
+    if (thread_shared) {
+      thread_shared->wait_for_exit();
+    }
   }
-  this->executing_bot_turn = false;
 }
 
-void BotTurnController::unregister_bot_thread(BotThread* thread) {
+void GameController::unregister_bot_thread(BotThread* thread) {
   wxASSERT(wxThread::GetCurrentId() == thread->GetId());
   wxCriticalSectionLocker enter(this->bot_thread_cs);
   // Another bot thread might have just been spun up after cancelling this one,
@@ -139,6 +183,9 @@ void BotTurnController::unregister_bot_thread(BotThread* thread) {
   if (this->bot_thread == thread) {
     this->bot_thread = nullptr;
   }
+  if (this->ponder_thread == thread) {
+    this->ponder_thread = nullptr;
+  }
 }
 
 void LogEntryViewerController::on_activated() {
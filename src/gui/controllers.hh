@@ -15,7 +15,7 @@ class BotThread;
 class GameController : public wxEvtHandler {
 public:
   GameController(GamePanel* panel);
-  virtual ~GameController() {}
+  virtual ~GameController();
 
   void update_game_state_and_indirectly_delete_this();
 
@@ -31,15 +31,30 @@ public:
   virtual void on_mouse_move(wxMouseEvent& event);
   virtual void on_mouse_up(wxMouseEvent& event);
 
+  virtual BotThread* create_bot_thread();
+  void start_bot_thread();
+  void start_ponder_thread();
+  void stop_bot_thread();
+  void unregister_bot_thread(BotThread* thread);
+
   GamePanel* panel;
   CanvasPanel* canvas;
   Game* game;
   std::shared_ptr<BotParameters>& bot_params;
+
+  wxCriticalSection bot_thread_cs;
+  BotThread* bot_thread = nullptr;
+  // Runs alongside the bot_thread, both are protected by the bot_thread_cs.
+  BotThread* ponder_thread = nullptr;
+
+protected:
+  void run_bot_thread(BotThread* thread, BotThread** slot);
 };
 
 class PlayerTurnController : public GameController {
 public:
   PlayerTurnController(GamePanel* panel) : GameController(panel) {}
+  virtual void on_activated() override;
   virtual void paint_overlay(wxDC& dc) override;
 };
 
@@ -66,7 +81,6 @@ public:
 class BotTurnController : public GameController {
 public:
   BotTurnController(GamePanel* panel) : GameController(panel) {}
-  virtual ~BotTurnController();
   virtual void configure_bot_turn_ui() override;
   virtual void on_activated() override;
   virtual void on_deactivated(GameController* next_controller) override;
@@ -74,15 +88,9 @@ public:
   virtual void update_status_bar() override;
   virtual void on_mouse_up(wxMouseEvent& event) override;
 
-  virtual BotThread* create_bot_thread() = 0;
   void on_bot_thread_done_work(bool cancelled);
-  void start_bot_thread();
-  void stop_bot_thread();
-  void unregister_bot_thread(BotThread* thread);
 
   bool executing_bot_turn = false;
-  wxCriticalSection bot_thread_cs;
-  BotThread* bot_thread = nullptr;
 };
 
 class BotPlacementController : public BotTurnController {
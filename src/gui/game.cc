@@ -3,6 +3,7 @@
 #include "bot.h"
 #include "game.h"
 #include "gui/better_random.hh"
+#include "gui/bot_thread.hh"
 #include "gui/canvas.hh"
 #include "gui/controllers.hh"
 #include "gui/game_end_dialog.hh"
@@ -211,10 +212,14 @@ GamePanel::GamePanel(GameFrame* parent, wxWindowID id, NewGameDialog* dialog)
   this->game.reset(game);
   this->player_names.reserve(dialog->get_number_of_players());
   this->player_types.reserve(dialog->get_number_of_players());
+  this->bot_players.reserve(dialog->get_number_of_players());
 
   auto bot_params = new BotParameters;
   init_bot_parameters(bot_params);
+  // Unlike in the autonomous mode, we are free to use the whole CPU here.
+  bot_params->threads_count = 0;
   this->bot_params.reset(bot_params);
+  this->ponder_table.reset(new BotPonderTable());
 
   game_begin_setup(game);
   game_set_penguins_per_player(game, dialog->get_penguins_per_player());
@@ -223,6 +228,17 @@ GamePanel::GamePanel(GameFrame* parent, wxWindowID id, NewGameDialog* dialog)
     game_set_player_name(game, i, dialog->get_player_name(i).c_str());
     this->player_names.push_back(dialog->get_player_name(i));
     this->player_types.push_back(dialog->get_player_type(i));
+    bool is_bot = dialog->get_player_type(i) == PLAYER_BOT;
+    this->bot_players.push_back(
+      is_bot ? std::make_shared<BotPlayerState>(this->bot_params) : nullptr
+    );
+    if (is_bot && this->ponder_bot == nullptr) {
+      // A single thread is enough for the background work, the results are
+      // the same regardless of the number of threads anyway.
+      auto ponder_params = std::make_shared<BotParameters>(*bot_params);
+      ponder_params->threads_count = 1;
+      this->ponder_bot = std::make_shared<BotPlayerState>(ponder_params);
+    }
   }
   setup_board(game, dialog->get_board_width(), dialog->get_board_height());
   BetterRng& rng = wxGetApp().rng;
@@ -23,6 +23,8 @@
 
 class NewGameDialog;
 class GameController;
+class BotPlayerState;
+class BotPonderTable;
 class CanvasPanel;
 class PlayerInfoBox;
 
@@ -68,6 +70,12 @@ public:
   bool game_ended = false;
   std::unique_ptr<Game, decltype(&game_free)> game{ nullptr, game_free };
   std::shared_ptr<BotParameters> bot_params{ nullptr };
+  // Filled in by the bot during the turns of the other players.
+  std::shared_ptr<BotPonderTable> ponder_table{ nullptr };
+  // The bots of the players (null for the humans), kept for the whole game.
+  wxVector<std::shared_ptr<BotPlayerState>> bot_players;
+  // Searches for the answers of the bots in the background, single-threaded.
+  std::shared_ptr<BotPlayerState> ponder_bot{ nullptr };
   wxVector<wxString> player_names;
   wxVector<PlayerType> player_types;
 
@@ -131,7 +131,7 @@ static void update_game_state_display(const Game* game) {
 }
 
 int run_interactive_mode(void) {
-  Rng rng = init_stdlib_rng();
+  Rng rng = init_random_rng();
 
 #ifdef _WIN32
   // Processing of ANSI sequences must be enabled on Windows. See
@@ -0,0 +1,139 @@
+#include "junctions.h"
+#include "board.h"
+#include "bot.h"
+#include "game.h"
+#include "utils.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// @relatesalso Junctions
+/// @brief Constructs an empty #Junctions, the grids are allocated later by
+/// #junctions_analyze.
+Junctions* junctions_new(void) {
+  Junctions* self = malloc(sizeof(*self));
+  self->width = 0;
+  self->height = 0;
+  self->regions = NULL;
+  self->region_fish = NULL;
+  self->regions_count = 0;
+  self->cut_tiles = NULL;
+  self->discovery = NULL;
+  self->low = NULL;
+  self->stack = NULL;
+  self->stack_dirs = NULL;
+  return self;
+}
+
+/// @relatesalso Junctions
+/// @brief Destroys a #Junctions and all of its grids.
+void junctions_free(Junctions* self) {
+  if (self == NULL) return;
+  free_and_clear(self->regions);
+  free_and_clear(self->region_fish);
+  free_and_clear(self->cut_tiles);
+  free_and_clear(self->discovery);
+  free_and_clear(self->low);
+  free_and_clear(self->stack);
+  free_and_clear(self->stack_dirs);
+  free(self);
+}
+
+/// @relatesalso Junctions
+/// @brief Finds the regions and the cut tiles of the current position of the
+/// #Game, (re)allocating the grids to fit its board if necessary.
+///
+/// This is the Tarjan's algorithm for finding the articulation points: the
+/// board is walked with a depth-first search, and for every tile the lowest
+/// discovery time reachable from its subtree without going through its parent
+/// is computed. A tile is a cut tile if some of its children can't reach
+/// above it in this way, or, for the first tile of a region, if it has more
+/// than one child. The recursion is unrolled into an explicit stack since the
+/// path can be as long as the whole board.
+///
+/// @see <https://en.wikipedia.org/wiki/Biconnected_component#Pseudocode>
+void junctions_analyze(Junctions* self, const Game* game) {
+  junctions_analyze_grid(self, game->board_grid, game->board_width, game->board_height);
+}
+
+/// @relatesalso Junctions
+/// @brief The #junctions_analyze of a bare grid of tiles of the size
+/// <tt>w * h</tt>, laid out like #Game::board_grid.
+void junctions_analyze_grid(Junctions* self, const short* grid, int w, int h) {
+  if (self->width != w || self->height != h) {
+    self->width = w, self->height = h;
+    self->regions = realloc(self->regions, sizeof(*self->regions) * w * h);
+    self->cut_tiles = realloc(self->cut_tiles, sizeof(*self->cut_tiles) * w * h);
+    self->discovery = realloc(self->discovery, sizeof(*self->discovery) * w * h);
+    self->low = realloc(self->low, sizeof(*self->low) * w * h);
+    self->stack = realloc(self->stack, sizeof(*self->stack) * w * h);
+    self->stack_dirs = realloc(self->stack_dirs, sizeof(*self->stack_dirs) * w * h);
+    // There can't be more regions than the tiles.
+    self->region_fish = realloc(self->region_fish, sizeof(*self->region_fish) * w * h);
+    bot_count_allocation();
+  }
+  memset(self->cut_tiles, 0, sizeof(*self->cut_tiles) * w * h);
+  memset(self->discovery, 0, sizeof(*self->discovery) * w * h);
+  self->regions_count = 0;
+
+  // The neighbors are visited in the order of the Direction enum.
+  const int offsets[DIRECTION_MAX] = { 1, w, -1, -w };
+  int time = 0;
+  for (int root = 0; root < w * h; root++) {
+    if (!is_fish_tile(grid[root]) || self->discovery[root] != 0) continue;
+    int region = self->regions_count++;
+    self->region_fish[region] = 0;
+
+    int root_children = 0;
+    int depth = 0;
+    self->stack[0] = root, self->stack_dirs[0] = 0;
+    self->discovery[root] = self->low[root] = ++time;
+    while (depth >= 0) {
+      int tile = self->stack[depth];
+      int dir = self->stack_dirs[depth];
+      if (dir < DIRECTION_MAX) {
+        self->stack_dirs[depth] += 1;
+        int x = tile % w, y = tile / w;
+        Coords d = DIRECTION_TO_COORDS[dir];
+        if (!(0 <= x + d.x && x + d.x < w && 0 <= y + d.y && y + d.y < h)) continue;
+        int next = tile + offsets[dir];
+        if (!is_fish_tile(grid[next])) continue;
+        if (self->discovery[next] == 0) {
+          self->discovery[next] = self->low[next] = ++time;
+          depth += 1;
+          self->stack[depth] = next, self->stack_dirs[depth] = 0;
+          if (tile == root) root_children += 1;
+        } else {
+          // The parent is also counted here, which is fine: it can't be lower
+          // than the parent's discovery time, so it doesn't affect the check
+          // of the parent below.
+          self->low[tile] = my_min(self->low[tile], self->discovery[next]);
+        }
+        continue;
+      }
+
+      // All neighbors of the tile are done, return to the parent.
+      self->regions[tile] = region;
+      self->region_fish[region] += get_tile_fish(grid[tile]);
+      depth -= 1;
+      if (depth < 0) break;
+      int parent = self->stack[depth];
+      self->low[parent] = my_min(self->low[parent], self->low[tile]);
+      if (parent != root && self->low[tile] >= self->discovery[parent]) {
+        self->cut_tiles[parent] = true;
+      }
+    }
+    if (root_children > 1) {
+      self->cut_tiles[root] = true;
+    }
+  }
+
+  for (int i = 0; i < w * h; i++) {
+    if (self->discovery[i] == 0) self->regions[i] = -1;
+  }
+}
+
+extern int junctions_region(const Junctions* self, Coords coords);
+extern int junctions_region_fish(const Junctions* self, int region);
+extern bool junctions_is_cut_tile(const Junctions* self, Coords coords);
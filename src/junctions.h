@@ -0,0 +1,88 @@
+#pragma once
+
+/// @file
+/// @brief The analysis of the junctions of the board for the bot
+/// @see bot.h
+
+#include "game.h"
+#include "utils.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief The junctions of a single position: the connected regions of the
+/// fish tiles and their cut tiles.
+///
+/// A cut tile (also known as an articulation point or a cut vertex in the
+/// graph theory) is a tile whose removal splits its region into several
+/// parts. This is exactly the situation the junction checks of the bot are
+/// concerned with: once a penguin moves onto such a tile, it will be cut off
+/// from some of those parts.
+///
+/// All of this is computed in one go by #junctions_analyze, which takes a
+/// single depth-first search of the whole board (the Tarjan's algorithm), so
+/// that afterwards the questions about the junctions can be answered in
+/// constant time for all moves available in the position.
+///
+/// @see <https://en.wikipedia.org/wiki/Biconnected_component>
+typedef struct Junctions {
+  int width;
+  int height;
+  /// @brief The index of the region of every tile (in the same layout as
+  /// #Game::board_grid), negative for the tiles without fish.
+  int* regions;
+  /// The total number of fish in every region.
+  int* region_fish;
+  int regions_count;
+  /// Whether every tile is a cut tile.
+  bool* cut_tiles;
+
+  /// @name Scratch space of the search
+  /// @{
+
+  /// The order in which the tiles were visited, zero if not visited yet.
+  int* discovery;
+  /// The lowest #discovery reachable from the subtree of every tile.
+  int* low;
+  /// The tiles on the path from the root of the search.
+  int* stack;
+  /// The next direction to be checked for every tile on the #stack.
+  unsigned char* stack_dirs;
+
+  /// @}
+} Junctions;
+
+Junctions* junctions_new(void);
+void junctions_free(Junctions* self);
+void junctions_analyze(Junctions* self, const Game* game);
+void junctions_analyze_grid(Junctions* self, const short* grid, int w, int h);
+
+/// @relatesalso Junctions
+/// @brief Returns the index of the region of the tile, negative if the tile
+/// doesn't contain fish or is outside the board.
+inline ALWAYS_INLINE int junctions_region(const Junctions* self, Coords coords) {
+  int x = coords.x, y = coords.y;
+  if (!(0 <= x && x < self->width && 0 <= y && y < self->height)) return -1;
+  return self->regions[x + y * self->width];
+}
+
+/// @relatesalso Junctions
+/// @brief Returns the total number of fish in the region of the given index.
+inline int junctions_region_fish(const Junctions* self, int region) {
+  return self->region_fish[region];
+}
+
+/// @relatesalso Junctions
+/// @brief Checks if taking the tile at @c coords would split its region.
+inline ALWAYS_INLINE bool junctions_is_cut_tile(const Junctions* self, Coords coords) {
+  int x = coords.x, y = coords.y;
+  if (!(0 <= x && x < self->width && 0 <= y && y < self->height)) return false;
+  return self->cut_tiles[x + y * self->width];
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,358 @@
+// The Monte Carlo Tree Search doesn't need any knowledge of the game besides
+// its rules: the moves are evaluated by simply playing the game out until the
+// end (randomly) many times, and the tree of the moves is grown gradually
+// towards the more promising ones. The classic UCT formula decides which
+// branch to explore next, and for more than two players every node is just
+// scored from the point of view of the player who has made its move.
+//
+// See also:
+// <https://www.chessprogramming.org/Monte-Carlo_Tree_Search>
+// <https://www.chessprogramming.org/UCT>
+// <https://en.wikipedia.org/wiki/Monte_Carlo_tree_search>
+
+#include "mcts.h"
+#include "bitboard.h"
+#include "bot.h"
+#include "game.h"
+#include "movement.h"
+#include "position.h"
+#include "threading.h"
+#include "utils.h"
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/// The exploration constant of UCT, the theoretical value is @c sqrt(2).
+static const double MCTS_EXPLORATION = 1.4142135623730951;
+
+/// @brief Applies the move, passes the turn to the next player who can move and
+/// records the step for #mcts_undo_steps.
+/// @returns @c false if the game is over after the move.
+static bool mcts_make_move(BotState* self, BotMove move, int* steps_count) {
+  MctsStep step = { move };
+  self->mcts_steps[(*steps_count)++] = step;
+  bot_make_move(self, move);
+  return search_position_switch_player(self->position) >= 0;
+}
+
+/// @brief Undoes all steps recorded by #mcts_make_move.
+static void mcts_undo_steps(BotState* self, int steps_count) {
+  while (steps_count > 0) {
+    MctsStep step = self->mcts_steps[--steps_count];
+    // The player changes are undone together with the moves.
+    bot_undo_move(self, step.move);
+  }
+}
+
+/// @brief Generates the moves of the current player in the order in which the
+/// children of an #MctsNode are expanded.
+static BotMove* mcts_generate_moves(BotState* self, int* moves_count) {
+  const SearchPosition* position = self->position;
+  int player_idx = position->current_player_index;
+  Coords* penguins = search_position_player_penguins(position, player_idx);
+  return bot_generate_all_moves_list(
+    self, position->penguins_counts[player_idx], penguins, moves_count
+  );
+}
+
+/// @brief A tiny random number generator for the playouts, returns a number
+/// in the range <tt>[0; bound)</tt>. Every thread has its own @c state, the
+/// #Rng is not required to be thread-safe.
+static int mcts_random_below(uint64_t* state, int bound) {
+  *state += 0x9E3779B97F4A7C15;
+  uint32_t x = (uint32_t)splitmix64_mix(*state);
+  return (int)(((uint64_t)x * (uint32_t)bound) >> 32);
+}
+
+/// @brief Picks a random move of the current player for the playouts.
+///
+/// The playouts are only slightly biased: out of two random moves, the one
+/// which collects more fish is taken. Not much, but this makes the results of
+/// the playouts considerably less noisy than the purely random ones.
+static bool mcts_pick_playout_move(BotState* self, BotMove* out_move) {
+  const Bitboard* bitboard = self->bitboard;
+  const SearchPosition* position = self->position;
+  int player_idx = position->current_player_index;
+  const Coords* penguins = search_position_player_penguins(position, player_idx);
+  int penguins_count = position->penguins_counts[player_idx];
+  bot_alloc_buf(self->possible_steps, self->possible_steps_cap, penguins_count);
+  PossibleSteps* penguin_steps = self->possible_steps;
+  int total_steps = 0;
+  for (int i = 0; i < penguins_count; i++) {
+    penguin_steps[i] = bitboard_possible_steps(bitboard, penguins[i]);
+    for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+      total_steps += penguin_steps[i].steps[dir];
+    }
+  }
+  if (total_steps == 0) return false;
+
+  int best_fish = -1;
+  for (int attempt = 0; attempt < 2; attempt++) {
+    int n = mcts_random_below(&self->mcts_random_state, total_steps);
+    for (int i = 0; i < penguins_count; i++) {
+      for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+        int steps = penguin_steps[i].steps[dir];
+        if (n >= steps) {
+          n -= steps;
+          continue;
+        }
+        Coords d = DIRECTION_TO_COORDS[dir], penguin = penguins[i];
+        Coords target = { penguin.x + d.x * (n + 1), penguin.y + d.y * (n + 1) };
+        int fish = bitboard_tile_fish(bitboard, target);
+        if (fish > best_fish) {
+          best_fish = fish;
+          out_move->penguin = penguin, out_move->target = target;
+        }
+        i = penguins_count;
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+/// @brief The result of the game for the player at @c player_idx: 1 for a
+/// win, a share of it for a draw, 0 for a loss (times #MCTS_REWARD_SCALE).
+static int mcts_game_result(const SearchPosition* position, int player_idx) {
+  int max_points = 0, winners = 0;
+  for (int i = 0; i < position->players_count; i++) {
+    int points = position->points[i];
+    if (points > max_points) {
+      max_points = points, winners = 1;
+    } else if (points == max_points) {
+      winners++;
+    }
+  }
+  return position->points[player_idx] == max_points ? MCTS_REWARD_SCALE / winners : 0;
+}
+
+/// @brief Selects the child of the node with the highest UCT value, returns
+/// a negative number if the node has no linked children.
+///
+/// The visits of the playouts which are still in progress count as losses
+/// (this is the so-called virtual loss), which steers the other threads away
+/// from the nodes being explored right now.
+static int mcts_select_child(MctsNode* nodes, int node_idx) {
+  MctsNode* node = &nodes[node_idx];
+  double log_visits = log((double)atomic_load_int(&node->visits));
+  int best_child = -1;
+  double best_value = -1.0;
+  for (int child_idx = atomic_load_int(&node->last_child); child_idx >= 0;) {
+    MctsNode* child = &nodes[child_idx];
+    double visits = (double)atomic_load_int(&child->visits);
+    double reward = (double)atomic_load_int64(&child->reward) / MCTS_REWARD_SCALE;
+    double value = reward / visits + MCTS_EXPLORATION * sqrt(log_visits / visits);
+    if (value >= best_value) {
+      best_value = value, best_child = child_idx;
+    }
+    child_idx = child->prev_sibling;
+  }
+  return best_child;
+}
+
+/// @brief The data shared by the threads of a single #bot_mcts_move call.
+typedef struct MctsJob {
+  MctsNode* nodes;
+  int max_nodes;
+  /// The number of allocated nodes, may exceed #max_nodes when it is full.
+  volatile int nodes_count;
+  int iterations;
+  /// The number of iterations started so far by all threads.
+  volatile int started_iterations;
+} MctsJob;
+
+/// @brief Prepends the node at @c child_idx to the list of the children of
+/// its parent.
+static void mcts_link_child(MctsNode* nodes, int child_idx) {
+  MctsNode* child = &nodes[child_idx];
+  MctsNode* parent = &nodes[child->parent];
+  int head;
+  do {
+    head = atomic_load_int(&parent->last_child);
+    child->prev_sibling = head;
+  } while (!atomic_cas_int(&parent->last_child, head, child_idx));
+}
+
+/// @brief Performs a single iteration of the search (see #bot_mcts_move) on
+/// the #BotState::position of the given state.
+static void mcts_iterate(BotState* self, MctsJob* job) {
+  const SearchPosition* position = self->position;
+  MctsNode* nodes = job->nodes;
+  // Every move takes away a tile, so that's the upper bound on the length of
+  // the game.
+  int tiles_count = position->board_width * position->board_height;
+  bot_alloc_buf(self->mcts_steps, self->mcts_steps_cap, tiles_count);
+  int steps_count = 0;
+  bool game_over = false;
+
+  // Selection and expansion.
+  int node_idx = 0;
+  atomic_fetch_add_int(&nodes[0].visits, 1);
+  while (true) {
+    MctsNode* node = &nodes[node_idx];
+    int moves_count = atomic_load_int(&node->moves_count);
+    if (moves_count < 0) {
+      // Two threads might do this at the same time, but they will come up
+      // with the same number anyway.
+      mcts_generate_moves(self, &moves_count);
+      atomic_store_int(&node->moves_count, moves_count);
+    }
+    if (moves_count == 0) {
+      game_over = true;
+      break;
+    }
+    int expanded = atomic_load_int(&node->children_count);
+    if (expanded < moves_count) {
+      int child_idx = atomic_fetch_add_int(&job->nodes_count, 1);
+      if (child_idx < job->max_nodes) {
+        if (!atomic_cas_int(&node->children_count, expanded, expanded + 1)) {
+          // Another thread has claimed this move, the allocated node is
+          // simply wasted.
+          continue;
+        }
+        int generated_count;
+        BotMove move = mcts_generate_moves(self, &generated_count)[expanded];
+        assert(generated_count == moves_count);
+        // The node starts out with the visit of the current playout.
+        MctsNode child = { move, position->current_player_index, node_idx, -1, -1, -1, 0, 1, 0 };
+        nodes[child_idx] = child;
+        mcts_link_child(nodes, child_idx);
+        game_over = !mcts_make_move(self, move, &steps_count);
+        node_idx = child_idx;
+        break;
+      }
+      // The tree is full, so the search continues with the existing nodes.
+    }
+    // There may be no children to select yet, either because the tree is
+    // full, or because the other threads have claimed all moves of this node
+    // but haven't linked their children yet. Either way the game is played
+    // out from this node.
+    int child_idx = mcts_select_child(nodes, node_idx);
+    if (child_idx < 0) break;
+    node_idx = child_idx;
+    atomic_fetch_add_int(&nodes[node_idx].visits, 1);
+    if (!mcts_make_move(self, nodes[node_idx].move, &steps_count)) {
+      game_over = true;
+      break;
+    }
+  }
+
+  // Simulation.
+  BotMove move = { { -1, -1 }, { -1, -1 } };
+  while (!game_over && mcts_pick_playout_move(self, &move)) {
+    game_over = !mcts_make_move(self, move, &steps_count);
+  }
+
+  // Backpropagation, the visits have already been counted on the way down.
+  for (; node_idx >= 0; node_idx = nodes[node_idx].parent) {
+    MctsNode* node = &nodes[node_idx];
+    if (node->mover >= 0) {
+      atomic_fetch_add_int64(&node->reward, mcts_game_result(position, node->mover));
+    }
+  }
+  mcts_undo_steps(self, steps_count);
+}
+
+/// @brief Runs the iterations of the job on the given state until they run out
+/// or the computation is stopped.
+static void mcts_run_job(BotState* self, MctsJob* job) {
+  while (true) {
+    if (bot_should_stop(self)) break;
+    if (atomic_fetch_add_int(&job->started_iterations, 1) >= job->iterations) break;
+    mcts_iterate(self, job);
+  }
+}
+
+static void mcts_worker_main(void* arg) {
+  BotWorker* worker = arg;
+  MctsJob* job = worker->job;
+  mcts_run_job(worker->state, job);
+}
+
+/// @relatedalso BotState
+/// @brief The implementation of #BOT_MOVEMENT_MCTS, called by
+/// #bot_compute_move.
+///
+/// Every iteration of the search walks down the tree from the root, picking
+/// the children with #mcts_select_child, until it reaches a node which has
+/// unexpanded moves, creates a node for the next such move, and then plays the
+/// game out until the end with #mcts_pick_playout_move. The result of the
+/// playout is added to all nodes on the way. Only one node is created per
+/// iteration, so the tree is allocated upfront in #BotState::mcts_nodes, whose
+/// size is #BotParameters::mcts_iterations. The search is stopped once all
+/// iterations are done or the #BotParameters::time_limit_ms runs out,
+/// whichever comes first, and the most visited move at the root is picked.
+///
+/// With #BotParameters::threads_count above one, the #BotState::workers grow
+/// the same tree together with the calling thread, each one running the
+/// playouts on its own copy of the #Game. No locks are involved: the
+/// statistics of the nodes are updated atomically, and the new nodes are
+/// taken out of the shared array with an atomic counter.
+///
+/// @see <https://www.chessprogramming.org/Parallel_Search#MCTS>
+///
+/// @returns @c true if a move was found, @c false if there were no moves
+/// available for the player or if the computation was cancelled.
+bool bot_mcts_move(BotState* self, Coords* out_penguin, Coords* out_target) {
+  int iterations = my_max(self->params->mcts_iterations, 1);
+  // The root plus a node per iteration.
+  int max_nodes = iterations + 1;
+  bot_alloc_buf(self->mcts_nodes, self->mcts_nodes_cap, max_nodes);
+  MctsNode* nodes = self->mcts_nodes;
+  MctsNode root = { { { -1, -1 }, { -1, -1 } }, -1, -1, -1, -1, -1, 0, 0, 0 };
+  nodes[0] = root;
+
+  MctsJob job;
+  job.nodes = nodes;
+  job.max_nodes = max_nodes;
+  job.nodes_count = 1;
+  job.iterations = iterations;
+  job.started_iterations = 0;
+
+  Rng* rng = self->rng;
+  self->mcts_random_state = (uint64_t)rng->random_range(rng, 0, INT_MAX);
+  // The time limit applies right away, but at least one iteration is done
+  // below to get some move.
+  uint64_t deadline = bot_start_timer(self);
+  for (int i = 0; i < self->workers_count; i++) {
+    BotWorker* worker = &self->workers[i];
+    BotState* state = worker->state;
+    state->mcts_random_state = (uint64_t)rng->random_range(rng, 0, INT_MAX) << 32 | (unsigned)i;
+    state->stop->deadline = deadline;
+    state->stop->timed_out = false;
+    state->stop->cancelled = false;
+    state->stop->clock_countdown = 0;
+    worker->job = &job;
+    if (!thread_spawn(&worker->thread, &mcts_worker_main, worker)) {
+      worker->job = NULL;
+    }
+  }
+
+  atomic_fetch_add_int(&job.started_iterations, 1);
+  mcts_iterate(self, &job);
+  self->stop->deadline = deadline;
+  mcts_run_job(self, &job);
+  self->stop->deadline = 0;
+
+  for (int i = 0; i < self->workers_count; i++) {
+    BotWorker* worker = &self->workers[i];
+    if (worker->job == NULL) continue;
+    thread_join(&worker->thread);
+    worker->job = NULL;
+  }
+  if (self->stop->cancelled) return false;
+
+  int best_child = -1;
+  for (int child_idx = nodes[0].last_child; child_idx >= 0;) {
+    const MctsNode* child = &nodes[child_idx];
+    if (best_child < 0 || child->visits >= nodes[best_child].visits) best_child = child_idx;
+    child_idx = child->prev_sibling;
+  }
+  if (best_child < 0) return false;
+  *out_penguin = nodes[best_child].move.penguin, *out_target = nodes[best_child].move.target;
+  return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+/// @file
+/// @brief The Monte Carlo Tree Search of #BOT_MOVEMENT_MCTS
+/// @see bot.h
+
+#include "bot.h"
+#include "utils.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief The result of a won game as stored in #MctsNode::reward. The rewards
+/// are integers so that they can be added atomically, and the draws divide
+/// this number evenly between up to 8 winners.
+#define MCTS_REWARD_SCALE 840
+
+/// @brief A node of the tree built by #bot_mcts_move.
+///
+/// The nodes are allocated out of #BotState::mcts_nodes, so instead of
+/// pointers they are linked by their indexes in that array.
+///
+/// The tree is shared by all threads of the search (see #bot_mcts_move), so
+/// the fields which change after a node has been added to the tree are only
+/// accessed with the atomic operations.
+typedef struct MctsNode {
+  /// The move which leads from the parent to this node.
+  BotMove move;
+  /// The index of the player who made the #move, negative for the root.
+  int mover;
+  /// The index of the parent node, negative for the root.
+  int parent;
+  /// @brief The most recently expanded child, negative if there are none. The
+  /// children are prepended to the list with a compare-and-swap.
+  int last_child;
+  /// The previous child of the parent, negative for the first one.
+  int prev_sibling;
+  /// @brief The number of moves available in the position of this node, zero
+  /// if the game is over, negative if not computed yet.
+  int moves_count;
+  /// @brief The number of the children expanded so far, which correspond to
+  /// the first moves returned by #bot_generate_all_moves_list. A thread
+  /// claims the next move for expansion by incrementing it with a
+  /// compare-and-swap, so the children may briefly be missing from the list.
+  int children_count;
+  /// @brief The number of playouts which went through this node, including
+  /// the ones still in progress.
+  int visits;
+  /// @brief The sum of the results of the finished playouts for the #mover,
+  /// in the fixed-point units of #MCTS_REWARD_SCALE.
+  int64_t reward;
+} MctsNode;
+
+/// @brief A move applied to the #BotState::position during an iteration of
+/// the search, remembered for undoing it later.
+typedef struct MctsStep {
+  BotMove move;
+} MctsStep;
+
+bool bot_mcts_move(BotState* self, Coords* out_penguin, Coords* out_target);
+
+#ifdef __cplusplus
+}
+#endif
@@ -44,14 +44,10 @@ int movement_switch_player(Game* game) {
 }
 
 /// @relatesalso Game
+/// @brief Checks whether the player at @c player_idx can move any of their
+/// penguins, which is just a look at #Player::mobile_penguins_count.
 bool any_valid_player_move_exists(const Game* game, int player_idx) {
-  Player* player = game_get_player(game, player_idx);
-  for (int i = 0; i < player->penguins_count; i++) {
-    if (count_obstructed_directions(game, player->penguins[i]) < DIRECTION_MAX) {
-      return true;
-    }
-  }
-  return false;
+  return game_get_player(game, player_idx)->mobile_penguins_count > 0;
 }
 
 /// @relatesalso Game
@@ -130,7 +126,7 @@ void move_penguin(Game* game, Coords start, Coords target) {
     entry_data->undo_tile = target_tile;
   }
 
-  *game_find_player_penguin(game, game->current_player_index, start) = target;
+  game_move_player_penguin(game, game->current_player_index, start, target);
   set_tile(game, target, PENGUIN_TILE(player->id));
   set_tile(game, start, WATER_TILE);
   player->points += get_tile_fish(target_tile);
@@ -144,7 +140,7 @@ void undo_move_penguin(Game* game) {
   const GameLogMovement* entry = &game_pop_log_entry(game, GAME_LOG_ENTRY_MOVEMENT)->data.movement;
 
   Player* player = game_get_current_player(game);
-  *game_find_player_penguin(game, game->current_player_index, entry->target) = entry->penguin;
+  game_move_player_penguin(game, game->current_player_index, entry->target, entry->penguin);
   set_tile(game, entry->penguin, PENGUIN_TILE(player->id));
   set_tile(game, entry->target, entry->undo_tile);
   player->points -= get_tile_fish(entry->undo_tile);
@@ -47,33 +47,25 @@ void move_penguin(Game* game, Coords start, Coords target);
 void undo_move_penguin(Game* game);
 
 /// @relatesalso Game
+/// @brief Counts the directions in which the neighbors of the tile aren't fish
+/// tiles (or are outside the board), looks at the #Game::tile_rays.
 inline int count_obstructed_directions(const Game* game, Coords penguin) {
-  assert(is_tile_in_bounds(game, penguin));
+  const short* rays = get_tile_rays(game, penguin);
   int result = 0;
   for (int dir = 0; dir < DIRECTION_MAX; dir++) {
-    Coords neighbor = DIRECTION_TO_COORDS[dir];
-    neighbor.x += penguin.x, neighbor.y += penguin.y;
-    if (!(is_tile_in_bounds(game, neighbor) && is_fish_tile(get_tile(game, neighbor)))) {
-      result += 1;
-    }
+    result += rays[dir] == 0;
   }
   return result;
 }
 
 /// @relatesalso Game
+/// @brief Returns the number of steps a penguin at @c start can make in every
+/// direction, looks at the #Game::tile_rays.
 inline PossibleSteps calculate_penguin_possible_moves(const Game* game, Coords start) {
-  assert(is_tile_in_bounds(game, start));
+  const short* rays = get_tile_rays(game, start);
   PossibleSteps moves;
   for (int dir = 0; dir < DIRECTION_MAX; dir++) {
-    Coords d = DIRECTION_TO_COORDS[dir];
-    Coords target = start;
-    int steps = 0;
-    while (true) {
-      target.x += d.x, target.y += d.y;
-      if (!(is_tile_in_bounds(game, target) && is_fish_tile(get_tile(game, target)))) break;
-      steps++;
-    }
-    moves.steps[dir] = steps;
+    moves.steps[dir] = rays[dir];
   }
   return moves;
 }
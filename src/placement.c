@@ -48,16 +48,10 @@ int placement_switch_player(Game* game) {
 }
 
 /// @relatesalso Game
+/// @brief Checks whether any tile is suitable for a placement, which is just
+/// a look at #Game::placeable_tiles_count.
 bool any_valid_placement_exists(const Game* game) {
-  for (int y = 0; y < game->board_height; y++) {
-    for (int x = 0; x < game->board_width; x++) {
-      Coords coords = { x, y };
-      if (validate_placement_simple(game, coords)) {
-        return true;
-      }
-    }
-  }
-  return false;
+  return game->placeable_tiles_count > 0;
 }
 
 /// @relatesalso Game
@@ -0,0 +1,272 @@
+#include "position.h"
+#include "board.h"
+#include "game.h"
+#include "utils.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// @relatesalso SearchPosition
+/// @brief Constructs an empty #SearchPosition, the arrays are allocated later
+/// by #search_position_load.
+SearchPosition* search_position_new(void) {
+  SearchPosition* self = malloc(sizeof(*self));
+  self->board_width = 0;
+  self->board_height = 0;
+  self->players_count = 0;
+  self->penguins_per_player = 0;
+  self->current_player_index = -1;
+  self->zobrist_key = 0;
+  self->grid = NULL;
+  self->penguin_slots = NULL;
+  self->penguins = NULL;
+  self->penguins_counts = NULL;
+  self->points = NULL;
+  self->fish_neighbors = NULL;
+  self->mobile_penguins_counts = NULL;
+  self->undo_stack = NULL;
+  self->undo_length = 0;
+  self->tiles_cap = 0;
+  self->penguins_cap = 0;
+  self->players_cap = 0;
+  return self;
+}
+
+/// @relatesalso SearchPosition
+/// @brief Destroys a #SearchPosition and all of its arrays.
+void search_position_free(SearchPosition* self) {
+  if (self == NULL) return;
+  free_and_clear(self->grid);
+  free_and_clear(self->penguin_slots);
+  free_and_clear(self->penguins);
+  free_and_clear(self->penguins_counts);
+  free_and_clear(self->points);
+  free_and_clear(self->fish_neighbors);
+  free_and_clear(self->mobile_penguins_counts);
+  free_and_clear(self->undo_stack);
+  free(self);
+}
+
+/// @relatesalso SearchPosition
+/// @brief Copies the current position of the #Game, (re)allocating the arrays
+/// if the board or the number of players or penguins has grown. Clears the
+/// undo stack.
+void search_position_load(SearchPosition* self, const Game* game) {
+  int w = game->board_width, h = game->board_height;
+  int players_count = my_max(game->players_count, 0);
+  int penguins_per_player = my_max(game->penguins_per_player, 0);
+  int tiles_count = w * h, penguins_count = players_count * penguins_per_player;
+  if (tiles_count > self->tiles_cap) {
+    self->tiles_cap = tiles_count;
+    self->grid = realloc(self->grid, sizeof(*self->grid) * tiles_count);
+    self->penguin_slots = realloc(self->penguin_slots, sizeof(*self->penguin_slots) * tiles_count);
+    self->fish_neighbors =
+      realloc(self->fish_neighbors, sizeof(*self->fish_neighbors) * tiles_count);
+    self->undo_stack = realloc(self->undo_stack, sizeof(*self->undo_stack) * tiles_count);
+  }
+  if (penguins_count > self->penguins_cap) {
+    self->penguins_cap = penguins_count;
+    self->penguins = realloc(self->penguins, sizeof(*self->penguins) * penguins_count);
+  }
+  if (players_count > self->players_cap) {
+    self->players_cap = players_count;
+    self->penguins_counts =
+      realloc(self->penguins_counts, sizeof(*self->penguins_counts) * players_count);
+    self->points = realloc(self->points, sizeof(*self->points) * players_count);
+    self->mobile_penguins_counts =
+      realloc(self->mobile_penguins_counts, sizeof(*self->mobile_penguins_counts) * players_count);
+  }
+
+  self->board_width = w, self->board_height = h;
+  self->players_count = players_count;
+  self->penguins_per_player = penguins_per_player;
+  self->current_player_index = game->current_player_index;
+  self->zobrist_key = game->zobrist_key;
+  self->undo_length = 0;
+  memcpy(self->grid, game->board_grid, sizeof(*self->grid) * tiles_count);
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      int count = 0;
+      for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+        Coords neighbor = DIRECTION_TO_COORDS[dir];
+        neighbor.x += x, neighbor.y += y;
+        if ((0 <= neighbor.x && neighbor.x < w && 0 <= neighbor.y && neighbor.y < h) &&
+            is_fish_tile(self->grid[neighbor.x + neighbor.y * w])) {
+          count++;
+        }
+      }
+      self->fish_neighbors[x + y * w] = (unsigned char)count;
+    }
+  }
+  for (int i = 0; i < players_count; i++) {
+    const Player* player = game_get_player(game, i);
+    assert(player->penguins_count <= penguins_per_player);
+    self->penguins_counts[i] = player->penguins_count;
+    self->points[i] = player->points;
+    self->mobile_penguins_counts[i] = 0;
+    for (int j = 0; j < player->penguins_count; j++) {
+      Coords penguin = player->penguins[j];
+      int slot = i * penguins_per_player + j;
+      self->penguins[slot] = penguin;
+      self->penguin_slots[penguin.x + penguin.y * w] = (short)slot;
+      self->mobile_penguins_counts[i] += self->fish_neighbors[penguin.x + penguin.y * w] > 0;
+    }
+  }
+}
+
+/// @relatesalso SearchPosition
+/// @brief Writes the position back to the #Game, which must have the same
+/// board and players as the one the position was loaded from.
+///
+/// The tiles are changed with #set_tile and the current player with
+/// #game_set_current_player, the moves themselves are not logged.
+void search_position_store(const SearchPosition* self, Game* game) {
+  assert(game->board_width == self->board_width && game->board_height == self->board_height);
+  assert(game->players_count == self->players_count);
+  int w = self->board_width;
+  for (int y = 0; y < self->board_height; y++) {
+    for (int x = 0; x < w; x++) {
+      Coords coords = { x, y };
+      short tile = self->grid[x + y * w];
+      if (get_tile(game, coords) != tile) set_tile(game, coords, tile);
+    }
+  }
+  for (int i = 0; i < self->players_count; i++) {
+    Player* player = game_get_player(game, i);
+    assert(player->penguins_count == self->penguins_counts[i]);
+    memcpy(
+      player->penguins,
+      search_position_player_penguins(self, i),
+      sizeof(*player->penguins) * player->penguins_count
+    );
+    player->points = self->points[i];
+  }
+  game_recount_mobile_penguins(game);
+  game_set_current_player(game, self->current_player_index);
+  assert(game->zobrist_key == self->zobrist_key);
+}
+
+/// @relatesalso SearchPosition
+/// @brief Writes a tile and updates the #SearchPosition::zobrist_key.
+static inline void search_position_set_tile(SearchPosition* self, int idx, short value) {
+  short* tile = &self->grid[idx];
+  self->zobrist_key ^= game_zobrist_tile_key(idx, *tile) ^ game_zobrist_tile_key(idx, value);
+  *tile = value;
+}
+
+/// @relatesalso SearchPosition
+/// @brief Writes the current player and updates the
+/// #SearchPosition::zobrist_key.
+static inline void search_position_set_current_player(SearchPosition* self, int idx) {
+  self->zobrist_key ^= game_zobrist_player_key(self->current_player_index);
+  self->zobrist_key ^= game_zobrist_player_key(idx);
+  self->current_player_index = idx;
+}
+
+/// @relatesalso SearchPosition
+/// @brief Updates the #SearchPosition::fish_neighbors around the tile at
+/// @c coords whose fish have just appeared (@c delta is 1) or disappeared
+/// (@c delta is -1), and the #SearchPosition::mobile_penguins_counts of the
+/// adjacent penguins which became unstuck or stuck, except for the one at
+/// @c skip, which is the moved penguin and is accounted for by the caller.
+static inline void search_position_update_fish_neighbors(
+  SearchPosition* self, Coords coords, int delta, int skip
+) {
+  int w = self->board_width, h = self->board_height;
+  for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+    Coords neighbor = DIRECTION_TO_COORDS[dir];
+    neighbor.x += coords.x, neighbor.y += coords.y;
+    if (!(0 <= neighbor.x && neighbor.x < w && 0 <= neighbor.y && neighbor.y < h)) continue;
+    int idx = neighbor.x + neighbor.y * w;
+    unsigned char count = (unsigned char)(self->fish_neighbors[idx] + delta);
+    self->fish_neighbors[idx] = count;
+    // The mobility changes only when the count goes between zero and one.
+    if (count == (delta > 0 ? 1 : 0) && idx != skip && is_penguin_tile(self->grid[idx])) {
+      self->mobile_penguins_counts[self->penguin_slots[idx] / self->penguins_per_player] += delta;
+    }
+  }
+}
+
+/// @relatesalso SearchPosition
+/// @brief Moves the penguin at @c penguin to @c target on behalf of its owner,
+/// who becomes the current player, and pushes an entry onto the undo stack.
+/// Must be paired with #search_position_unmake_move.
+///
+/// Unlike #move_penguin, the move is not validated (the bot generates only the
+/// valid ones anyway).
+void search_position_make_move(SearchPosition* self, Coords penguin, Coords target) {
+  int w = self->board_width;
+  int from = penguin.x + penguin.y * w, to = target.x + target.y * w;
+  short penguin_tile = self->grid[from], target_tile = self->grid[to];
+  assert(is_penguin_tile(penguin_tile) && is_fish_tile(target_tile));
+  assert(self->undo_length < (size_t)self->tiles_cap);
+  SearchUndo* entry = &self->undo_stack[self->undo_length++];
+  entry->penguin = penguin;
+  entry->target = target;
+  entry->target_tile = target_tile;
+  entry->prev_player = self->current_player_index;
+
+  int slot = self->penguin_slots[from];
+  int owner = slot / self->penguins_per_player;
+  self->penguins[slot] = target;
+  self->penguin_slots[to] = (short)slot;
+  search_position_set_tile(self, to, penguin_tile);
+  search_position_set_tile(self, from, WATER_TILE);
+  // The penguin could move from its old tile, otherwise it wouldn't be here.
+  search_position_update_fish_neighbors(self, target, -1, from);
+  self->mobile_penguins_counts[owner] += (self->fish_neighbors[to] > 0) - 1;
+  self->points[owner] += get_tile_fish(target_tile);
+  if (owner != self->current_player_index) {
+    search_position_set_current_player(self, owner);
+  }
+}
+
+/// @relatesalso SearchPosition
+/// @brief Undoes the last #search_position_make_move, together with any
+/// #search_position_switch_player calls made after it.
+void search_position_unmake_move(SearchPosition* self) {
+  assert(self->undo_length > 0);
+  const SearchUndo* entry = &self->undo_stack[--self->undo_length];
+  int w = self->board_width;
+  int from = entry->penguin.x + entry->penguin.y * w;
+  int to = entry->target.x + entry->target.y * w;
+  int slot = self->penguin_slots[to];
+  int owner = slot / self->penguins_per_player;
+  self->mobile_penguins_counts[owner] -= (self->fish_neighbors[to] > 0) - 1;
+  self->penguins[slot] = entry->penguin;
+  self->penguin_slots[from] = (short)slot;
+  search_position_set_tile(self, from, self->grid[to]);
+  search_position_set_tile(self, to, entry->target_tile);
+  search_position_update_fish_neighbors(self, entry->target, 1, from);
+  self->points[owner] -= get_tile_fish(entry->target_tile);
+  if (entry->prev_player != self->current_player_index) {
+    search_position_set_current_player(self, entry->prev_player);
+  }
+}
+
+/// @relatesalso SearchPosition
+/// @brief The #movement_switch_player of the #SearchPosition: passes the turn
+/// to the next player who can move and returns their index, or a negative
+/// number if nobody can move. Undone by #search_position_unmake_move of the
+/// preceding move.
+int search_position_switch_player(SearchPosition* self) {
+  int index = self->current_player_index;
+  for (int checked_players = 0; checked_players < self->players_count; checked_players++) {
+    index = (index + 1) % self->players_count;
+    if (search_position_player_can_move(self, index)) {
+      if (index != self->current_player_index) {
+        search_position_set_current_player(self, index);
+      }
+      return index;
+    }
+  }
+  return -1;
+}
+
+extern short search_position_get_tile(const SearchPosition* self, Coords coords);
+extern Coords* search_position_player_penguins(const SearchPosition* self, int idx);
+extern int search_position_penguin_owner(const SearchPosition* self, Coords coords);
+extern bool search_position_player_can_move(const SearchPosition* self, int player_idx);
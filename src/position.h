@@ -0,0 +1,131 @@
+#pragma once
+
+/// @file
+/// @brief The lightweight copy of the position used by the searches of the bot
+/// @see bot.h
+
+#include "board.h"
+#include "game.h"
+#include "utils.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief An entry of the undo stack of the #SearchPosition, see
+/// #search_position_make_move.
+typedef struct SearchUndo {
+  Coords penguin, target;
+  /// The tile at the target before the move.
+  short target_tile;
+  /// The index of the current player before the move.
+  int prev_player;
+} SearchUndo;
+
+/// @brief The position of the movement phase as seen by the searches of the
+/// bot: the board, the penguins and the scores, plus an undo stack.
+///
+/// The searches apply and undo millions of moves, and doing that with
+/// #move_penguin means paying for everything the #Game has to do for the
+/// rest of the program at every node: the validation asserts, pushing a
+/// #GameLogEntry (which may reallocate the log), looking the penguin up in
+/// the list of the player and marking the tiles as #TILE_DIRTY for the UI.
+/// This struct has only what the bot looks at, in arrays allocated once by
+/// #search_position_load, and its #search_position_make_move and
+/// #search_position_unmake_move do only the necessary work.
+///
+/// The position is converted from the #Game when the search starts, and can be
+/// written back with #search_position_store. The #zobrist_key is maintained in
+/// exactly the same way as #Game::zobrist_key, so the keys of the
+/// transposition tables are the same as if the moves were made on the #Game.
+typedef struct SearchPosition {
+  int board_width;
+  int board_height;
+  int players_count;
+  int penguins_per_player;
+  /// Same as #Game::current_player_index.
+  int current_player_index;
+  /// Same as #Game::zobrist_key.
+  uint64_t zobrist_key;
+
+  /// A copy of #Game::board_grid.
+  short* grid;
+  /// @brief The index of the penguin standing on every tile in #penguins,
+  /// from which the owner of the penguin can be found as well. Only valid for
+  /// the tiles with penguins.
+  short* penguin_slots;
+  /// @brief The penguins of all players, #penguins_per_player slots per
+  /// player, in the same order as in #Player::penguins.
+  Coords* penguins;
+  /// The number of penguins of every player.
+  int* penguins_counts;
+  /// The #Player::points of every player.
+  int* points;
+  /// @brief The number of the fish tiles next to every tile (in the
+  /// #DIRECTION_TO_COORDS directions), so that a penguin can move if and only
+  /// if its tile has any.
+  unsigned char* fish_neighbors;
+  /// @brief The number of penguins of every player which can move, the
+  /// #Player::mobile_penguins_count of the #SearchPosition. Kept up to date by
+  /// #search_position_make_move and #search_position_unmake_move with the
+  /// help of #fish_neighbors, since only the neighbors of the target of a
+  /// move (and the moved penguin itself) can become stuck.
+  int* mobile_penguins_counts;
+
+  /// @brief The undo stack, every move sinks a tile, so the board size is its
+  /// upper bound.
+  SearchUndo* undo_stack;
+  size_t undo_length;
+
+  /// @brief The sizes for which the arrays were allocated, see
+  /// #search_position_load.
+  int tiles_cap, penguins_cap, players_cap;
+} SearchPosition;
+
+SearchPosition* search_position_new(void);
+void search_position_free(SearchPosition* self);
+void search_position_load(SearchPosition* self, const Game* game);
+void search_position_store(const SearchPosition* self, Game* game);
+void search_position_make_move(SearchPosition* self, Coords penguin, Coords target);
+void search_position_unmake_move(SearchPosition* self);
+int search_position_switch_player(SearchPosition* self);
+
+/// @relatesalso SearchPosition
+/// @brief The #get_tile of the #SearchPosition.
+inline ALWAYS_INLINE short search_position_get_tile(const SearchPosition* self, Coords coords) {
+  assert(0 <= coords.x && coords.x < self->board_width);
+  assert(0 <= coords.y && coords.y < self->board_height);
+  return self->grid[coords.x + coords.y * self->board_width];
+}
+
+/// @relatesalso SearchPosition
+/// @brief Returns the list of the penguins of the player at @c idx, its length
+/// is in #SearchPosition::penguins_counts.
+inline Coords* search_position_player_penguins(const SearchPosition* self, int idx) {
+  assert(0 <= idx && idx < self->players_count);
+  return &self->penguins[idx * self->penguins_per_player];
+}
+
+/// @relatesalso SearchPosition
+/// @brief Returns the index of the owner of the penguin at @c coords, there
+/// must be one.
+inline int search_position_penguin_owner(const SearchPosition* self, Coords coords) {
+  assert(is_penguin_tile(search_position_get_tile(self, coords)));
+  return self->penguin_slots[coords.x + coords.y * self->board_width] / self->penguins_per_player;
+}
+
+/// @relatesalso SearchPosition
+/// @brief The #any_valid_player_move_exists of the #SearchPosition, which is
+/// just a look at #SearchPosition::mobile_penguins_counts.
+inline bool search_position_player_can_move(const SearchPosition* self, int player_idx) {
+  assert(0 <= player_idx && player_idx < self->players_count);
+  return self->mobile_penguins_counts[player_idx] > 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,512 @@
+#include "regions.h"
+#include "board.h"
+#include "bot.h"
+#include "position.h"
+#include "utils.h"
+#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// @relatesalso RegionMap
+/// @brief Constructs an empty #RegionMap, the grids are allocated later by
+/// #region_map_load.
+RegionMap* region_map_new(void) {
+  RegionMap* self = malloc(sizeof(*self));
+  self->width = 0;
+  self->height = 0;
+  self->players_count = 0;
+  self->labels = NULL;
+  self->tile_fish = NULL;
+  self->regions = NULL;
+  self->regions_count = 0;
+  self->regions_cap = 0;
+  self->penguins = NULL;
+  self->changes = NULL;
+  self->changes_count = 0;
+  self->changes_cap = 0;
+  self->fill_queue = NULL;
+  self->fill_marks = NULL;
+  self->fill_stamp = 0;
+  return self;
+}
+
+/// @relatesalso RegionMap
+/// @brief Destroys a #RegionMap and all of its grids.
+void region_map_free(RegionMap* self) {
+  if (self == NULL) return;
+  free_and_clear(self->labels);
+  free_and_clear(self->tile_fish);
+  free_and_clear(self->regions);
+  free_and_clear(self->penguins);
+  free_and_clear(self->changes);
+  free_and_clear(self->fill_queue);
+  free_and_clear(self->fill_marks);
+  free(self);
+}
+
+/// @relatesalso RegionMap
+/// @brief Appends an entry to the journal of changes.
+static void region_map_record(
+  RegionMap* self, RegionMapChangeType type, int index, int value, int value2
+) {
+  if (self->changes_count >= self->changes_cap) {
+    self->changes_cap = my_max(self->changes_cap * 2, 64);
+    self->changes = realloc(self->changes, sizeof(*self->changes) * self->changes_cap);
+    bot_count_allocation();
+  }
+  RegionMapChange* change = &self->changes[self->changes_count++];
+  change->type = type;
+  change->index = index;
+  change->value = value;
+  change->value2 = value2;
+}
+
+/// @relatesalso RegionMap
+/// @brief Changes the label of a tile, recording the change in the journal.
+static void region_map_set_label(RegionMap* self, int idx, int label) {
+  region_map_record(self, REGION_CHANGE_LABEL, idx, self->labels[idx], 0);
+  self->labels[idx] = label;
+}
+
+/// @relatesalso RegionMap
+/// @brief Records the current state of a region in the journal before it is
+/// changed.
+static void region_map_save_region(RegionMap* self, int region) {
+  const Region* data = &self->regions[region];
+  region_map_record(self, REGION_CHANGE_REGION, region, data->fish, data->tiles);
+}
+
+/// @relatesalso RegionMap
+/// @brief Changes the number of penguins of a player in a region, recording
+/// the change in the journal.
+static void region_map_add_penguins(RegionMap* self, int region, int player_idx, int delta) {
+  int idx = region * self->players_count + player_idx;
+  region_map_record(self, REGION_CHANGE_PENGUINS, idx, self->penguins[idx], 0);
+  self->penguins[idx] += delta;
+}
+
+/// @relatesalso RegionMap
+/// @brief Creates a new empty region and returns its index.
+static int region_map_add_region(RegionMap* self) {
+  int players_count = self->players_count;
+  if ((size_t)self->regions_count >= self->regions_cap) {
+    self->regions_cap = my_max(self->regions_cap * 2, 16);
+    self->regions = realloc(self->regions, sizeof(*self->regions) * self->regions_cap);
+    self->penguins = realloc(
+      self->penguins, sizeof(*self->penguins) * self->regions_cap * my_max(players_count, 1)
+    );
+    bot_count_allocation();
+  }
+  int region = self->regions_count++;
+  self->regions[region].fish = 0;
+  self->regions[region].tiles = 0;
+  for (int i = 0; i < players_count; i++) {
+    self->penguins[region * players_count + i] = 0;
+  }
+  return region;
+}
+
+/// @relatesalso RegionMap
+/// @brief Collects the distinct regions adjacent to the tile at @c coords.
+/// @returns The number of the regions written to @c regions.
+static int region_map_adjacent_regions(
+  const RegionMap* self, Coords coords, int regions[DIRECTION_MAX]
+) {
+  int count = 0;
+  for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+    Coords neighbor = DIRECTION_TO_COORDS[dir];
+    neighbor.x += coords.x, neighbor.y += coords.y;
+    int label = region_map_label(self, neighbor);
+    if (label < 0) continue;
+    int i = 0;
+    while (i < count && regions[i] != label) i++;
+    if (i == count) regions[count++] = label;
+  }
+  return count;
+}
+
+/// @relatesalso RegionMap
+/// @brief Checks if the tile at @c coords is on the board.
+static inline bool region_map_in_bounds(const RegionMap* self, Coords coords) {
+  return 0 <= coords.x && coords.x < self->width && 0 <= coords.y && coords.y < self->height;
+}
+
+/// @relatesalso RegionMap
+/// @brief (Re)allocates the grids to fit the board of the given
+/// #SearchPosition and labels all regions from scratch. Clears the journal.
+///
+/// The lists are reserved for @c max_moves moves to be applied with
+/// #region_map_move_penguin on top of this position, so that applying them
+/// doesn't allocate anything. Every move can add at most
+/// <tt>DIRECTION_MAX - 1</tt> regions, and journal at most a change of every
+/// tile (when the region is split) plus a few changes for every penguin.
+void region_map_load(RegionMap* self, const SearchPosition* position, int max_moves) {
+  int w = position->board_width, h = position->board_height;
+  int players_count = my_max(position->players_count, 0);
+  if (self->width != w || self->height != h) {
+    self->labels = realloc(self->labels, sizeof(*self->labels) * w * h);
+    self->tile_fish = realloc(self->tile_fish, sizeof(*self->tile_fish) * w * h);
+    self->fill_queue =
+      realloc(self->fill_queue, sizeof(*self->fill_queue) * w * h * DIRECTION_MAX);
+    self->fill_marks = realloc(self->fill_marks, sizeof(*self->fill_marks) * w * h);
+    bot_count_allocation();
+  }
+  max_moves = my_max(max_moves, 0);
+  // There can't be more regions than the fish tiles.
+  size_t regions_cap = (size_t)w * h + (size_t)max_moves * (DIRECTION_MAX - 1);
+  if (self->players_count != players_count || self->regions_cap < regions_cap) {
+    self->regions_cap = my_max(self->regions_cap, regions_cap);
+    self->regions = realloc(self->regions, sizeof(*self->regions) * self->regions_cap);
+    self->penguins = realloc(
+      self->penguins, sizeof(*self->penguins) * self->regions_cap * my_max(players_count, 1)
+    );
+    bot_count_allocation();
+  }
+  size_t penguins_count = (size_t)players_count * my_max(position->penguins_per_player, 0);
+  size_t changes_cap = (size_t)max_moves * ((size_t)w * h + penguins_count * 5 + 16);
+  if (self->changes_cap < changes_cap) {
+    self->changes_cap = changes_cap;
+    self->changes = realloc(self->changes, sizeof(*self->changes) * self->changes_cap);
+    bot_count_allocation();
+  }
+  self->width = w, self->height = h;
+  self->players_count = players_count;
+  self->regions_count = 0;
+  self->changes_count = 0;
+  self->fill_stamp = 0;
+  memset(self->fill_marks, 0, sizeof(*self->fill_marks) * w * h);
+
+  for (int i = 0; i < w * h; i++) {
+    self->tile_fish[i] = get_tile_fish(position->grid[i]);
+    self->labels[i] = -1;
+  }
+
+  // The regions are labeled with a plain breadth-first search, the queue of
+  // the fills is reused for that.
+  int* queue = self->fill_queue;
+  for (int start = 0; start < w * h; start++) {
+    if (self->tile_fish[start] == 0 || self->labels[start] >= 0) continue;
+    int region = region_map_add_region(self);
+    int head = 0, tail = 0;
+    queue[tail++] = start;
+    self->labels[start] = region;
+    while (head < tail) {
+      int idx = queue[head++];
+      self->regions[region].fish += self->tile_fish[idx];
+      self->regions[region].tiles += 1;
+      Coords coords = { idx % w, idx / w };
+      for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+        Coords neighbor = DIRECTION_TO_COORDS[dir];
+        neighbor.x += coords.x, neighbor.y += coords.y;
+        if (!region_map_in_bounds(self, neighbor)) continue;
+        int neighbor_idx = neighbor.x + neighbor.y * w;
+        if (self->tile_fish[neighbor_idx] != 0 && self->labels[neighbor_idx] < 0) {
+          self->labels[neighbor_idx] = region;
+          queue[tail++] = neighbor_idx;
+        }
+      }
+    }
+  }
+
+  for (int player_idx = 0; player_idx < players_count; player_idx++) {
+    const Coords* penguins = search_position_player_penguins(position, player_idx);
+    for (int i = 0; i < position->penguins_counts[player_idx]; i++) {
+      int adjacent[DIRECTION_MAX];
+      int count = region_map_adjacent_regions(self, penguins[i], adjacent);
+      for (int j = 0; j < count; j++) {
+        self->penguins[adjacent[j] * players_count + player_idx] += 1;
+      }
+    }
+  }
+}
+
+/// @relatesalso RegionMap
+/// @brief Moves the penguins adjacent to the tile at @c idx, which has just
+/// been separated from the old @c region into a new one, to the new regions
+/// (those with indexes starting at @c first_new), and out of the old region if
+/// they are no longer adjacent to it. The penguin at @c ignored (the one which
+/// is being moved) is left alone.
+static void region_map_split_penguins(
+  RegionMap* self,
+  const SearchPosition* position,
+  int idx,
+  int region,
+  int first_new,
+  Coords ignored
+) {
+  Coords coords = { idx % self->width, idx / self->width };
+  for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+    Coords penguin = DIRECTION_TO_COORDS[dir];
+    penguin.x += coords.x, penguin.y += coords.y;
+    if (!region_map_in_bounds(self, penguin) || coords_same(penguin, ignored)) continue;
+    if (!is_penguin_tile(search_position_get_tile(position, penguin))) continue;
+    // Every penguin must be processed only once, so only from the first of its
+    // neighbors which is in one of the new regions.
+    int first_dir;
+    for (first_dir = 0; first_dir < DIRECTION_MAX; first_dir++) {
+      Coords other = DIRECTION_TO_COORDS[first_dir];
+      other.x += penguin.x, other.y += penguin.y;
+      if (region_map_label(self, other) >= first_new) break;
+    }
+    // The opposite directions differ by 2, see Direction.
+    if ((first_dir + 2) % DIRECTION_MAX != dir) continue;
+
+    int player_idx = search_position_penguin_owner(position, penguin);
+    int adjacent[DIRECTION_MAX];
+    int count = region_map_adjacent_regions(self, penguin, adjacent);
+    bool still_in_region = false;
+    for (int i = 0; i < count; i++) {
+      if (adjacent[i] >= first_new) {
+        region_map_add_penguins(self, adjacent[i], player_idx, 1);
+      } else if (adjacent[i] == region) {
+        still_in_region = true;
+      }
+    }
+    if (!still_in_region) {
+      region_map_add_penguins(self, region, player_idx, -1);
+    }
+  }
+}
+
+/// @relatesalso RegionMap
+/// @brief Checks if the @c region has fallen apart after the tile at @c
+/// coords was taken out of it, and if so, moves the separated parts into new
+/// regions.
+///
+/// The flood fills are started from every side of the tile at once and
+/// advance by one tile at a time in turns, the fills which run into each other
+/// are merged. Once all fills but one have nowhere left to go, the tiles
+/// visited by the stuck ones are the separated parts, while the rest of the
+/// tiles stay in the old region. Thanks to this only the smaller parts get
+/// visited -- unless the region doesn't actually split and the fills have to
+/// go around to meet each other, which is the cost of not walking the whole
+/// region.
+static void region_map_split(
+  RegionMap* self, const SearchPosition* position, Coords coords, int region
+) {
+  int w = self->width, h = self->height;
+
+  // First, a cheap check: if the sides of the tile are connected through its
+  // corners, the region has definitely stayed whole. The neighbors are walked around in a circle,
+  // and the sides belonging to a continuous run of fish tiles are connected.
+  bool is_fish[NEIGHBOR_MAX];
+  int gap = -1;
+  for (int dir = 0; dir < NEIGHBOR_MAX; dir++) {
+    Coords neighbor = NEIGHBOR_TO_COORDS[dir];
+    neighbor.x += coords.x, neighbor.y += coords.y;
+    is_fish[dir] = region_map_label(self, neighbor) >= 0;
+    if (!is_fish[dir]) gap = dir;
+  }
+  if (gap < 0) return;
+
+  int seeds[DIRECTION_MAX];
+  int fills_count = 0;
+  bool run_seeded = false;
+  for (int i = 1; i <= NEIGHBOR_MAX; i++) {
+    int dir = (gap + i) % NEIGHBOR_MAX;
+    if (!is_fish[dir]) {
+      run_seeded = false;
+    } else if (dir % 2 == 0 && !run_seeded) {
+      // The sides have even indexes, see Neighbor.
+      Coords neighbor = NEIGHBOR_TO_COORDS[dir];
+      neighbor.x += coords.x, neighbor.y += coords.y;
+      seeds[fills_count++] = neighbor.x + neighbor.y * w;
+      run_seeded = true;
+    }
+  }
+  if (fills_count <= 1) return;
+
+  self->fill_stamp += 1;
+  if (self->fill_stamp > UINT_MAX / DIRECTION_MAX) {
+    memset(self->fill_marks, 0, sizeof(*self->fill_marks) * w * h);
+    self->fill_stamp = 1;
+  }
+  unsigned stamp = self->fill_stamp * DIRECTION_MAX;
+  int* queues[DIRECTION_MAX];
+  int heads[DIRECTION_MAX], tails[DIRECTION_MAX], parents[DIRECTION_MAX];
+  for (int i = 0; i < fills_count; i++) {
+    queues[i] = &self->fill_queue[i * w * h];
+    queues[i][0] = seeds[i];
+    heads[i] = 0, tails[i] = 1;
+    parents[i] = i;
+    self->fill_marks[seeds[i]] = stamp + i;
+  }
+
+  int roots_count, active_roots_count;
+  bool is_active[DIRECTION_MAX];
+  while (true) {
+    for (int i = 0; i < fills_count; i++) {
+      is_active[i] = false;
+    }
+    for (int i = 0; i < fills_count; i++) {
+      int root = i;
+      while (parents[root] != root) root = parents[root];
+      if (heads[i] < tails[i]) is_active[root] = true;
+    }
+    roots_count = active_roots_count = 0;
+    for (int i = 0; i < fills_count; i++) {
+      if (parents[i] != i) continue;
+      roots_count += 1;
+      if (is_active[i]) active_roots_count += 1;
+    }
+    // All fills have met, so the region is still in one piece.
+    if (roots_count <= 1) return;
+    if (active_roots_count <= 1) break;
+
+    for (int i = 0; i < fills_count; i++) {
+      if (heads[i] >= tails[i]) continue;
+      int idx = queues[i][heads[i]++];
+      Coords current = { idx % w, idx / w };
+      for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+        Coords neighbor = DIRECTION_TO_COORDS[dir];
+        neighbor.x += current.x, neighbor.y += current.y;
+        if (region_map_label(self, neighbor) != region) continue;
+        int neighbor_idx = neighbor.x + neighbor.y * w;
+        unsigned mark = self->fill_marks[neighbor_idx];
+        if (mark - stamp < DIRECTION_MAX) {
+          int other = (int)(mark - stamp), root = i;
+          while (parents[other] != other) other = parents[other];
+          while (parents[root] != root) root = parents[root];
+          if (other != root) parents[other] = root;
+        } else {
+          self->fill_marks[neighbor_idx] = stamp + i;
+          queues[i][tails[i]++] = neighbor_idx;
+        }
+      }
+    }
+  }
+
+  // The parts which are still being filled are larger than the stuck ones,
+  // so keeping them in the old region means less relabeling. If every fill
+  // got stuck, the largest one is kept.
+  int kept_root = -1, kept_tiles = -1;
+  for (int i = 0; i < fills_count; i++) {
+    if (parents[i] != i) continue;
+    int tiles = 0;
+    for (int j = 0; j < fills_count; j++) {
+      int root = j;
+      while (parents[root] != root) root = parents[root];
+      if (root == i) tiles += tails[j];
+    }
+    if (is_active[i]) tiles = INT_MAX;
+    if (tiles > kept_tiles) kept_root = i, kept_tiles = tiles;
+  }
+
+  int first_new = self->regions_count;
+  int new_regions[DIRECTION_MAX];
+  for (int i = 0; i < fills_count; i++) {
+    new_regions[i] = -1;
+    if (parents[i] != i || i == kept_root) continue;
+    int new_region = region_map_add_region(self);
+    new_regions[i] = new_region;
+    Region* data = &self->regions[new_region];
+    for (int j = 0; j < fills_count; j++) {
+      int root = j;
+      while (parents[root] != root) root = parents[root];
+      if (root != i) continue;
+      for (int k = 0; k < tails[j]; k++) {
+        int idx = queues[j][k];
+        region_map_set_label(self, idx, new_region);
+        data->fish += self->tile_fish[idx];
+        data->tiles += 1;
+      }
+    }
+    self->regions[region].fish -= data->fish;
+    self->regions[region].tiles -= data->tiles;
+  }
+
+  // The penguins can be sorted out only once all new regions have been labeled.
+  for (int j = 0; j < fills_count; j++) {
+    int root = j;
+    while (parents[root] != root) root = parents[root];
+    if (new_regions[root] < 0) continue;
+    for (int k = 0; k < tails[j]; k++) {
+      region_map_split_penguins(self, position, queues[j][k], region, first_new, coords);
+    }
+  }
+}
+
+/// @relatesalso RegionMap
+/// @brief Updates the map after a penguin has been moved from @c start to @c
+/// target with #search_position_make_move, must be paired with
+/// #region_map_undo_move.
+///
+/// The taken tile is removed from its region, which may split the region
+/// into several parts (see #region_map_split), and the penguin is moved from
+/// the regions surrounding its old tile to the ones surrounding the new one.
+///
+/// @returns @c true if the region of the target has been split, i.e. the
+/// target was a cut tile (see #Junctions) of the position before the move.
+bool region_map_move_penguin(
+  RegionMap* self, const SearchPosition* position, Coords start, Coords target
+) {
+  int player_idx = search_position_penguin_owner(position, target);
+  region_map_record(self, REGION_CHANGE_MOVE, -1, self->regions_count, 0);
+
+  int adjacent[DIRECTION_MAX];
+  int count = region_map_adjacent_regions(self, start, adjacent);
+  for (int i = 0; i < count; i++) {
+    region_map_add_penguins(self, adjacent[i], player_idx, -1);
+  }
+
+  int idx = target.x + target.y * self->width;
+  int region = self->labels[idx];
+  assert(region >= 0);
+  region_map_save_region(self, region);
+  self->regions[region].fish -= self->tile_fish[idx];
+  self->regions[region].tiles -= 1;
+  region_map_set_label(self, idx, -1);
+  int first_new = self->regions_count;
+  region_map_split(self, position, target, region);
+  bool split = self->regions_count != first_new;
+
+  // The penguins which were touching the region only through the taken tile
+  // have been left out of it (those touching the separated parts have been
+  // dealt with by the split already).
+  for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+    Coords penguin = DIRECTION_TO_COORDS[dir];
+    penguin.x += target.x, penguin.y += target.y;
+    if (!region_map_in_bounds(self, penguin)) continue;
+    if (!is_penguin_tile(search_position_get_tile(position, penguin))) continue;
+    count = region_map_adjacent_regions(self, penguin, adjacent);
+    bool still_in_region = false;
+    for (int i = 0; i < count; i++) {
+      if (adjacent[i] == region || adjacent[i] >= first_new) still_in_region = true;
+    }
+    if (!still_in_region) {
+      int other_player_idx = search_position_penguin_owner(position, penguin);
+      region_map_add_penguins(self, region, other_player_idx, -1);
+    }
+  }
+
+  count = region_map_adjacent_regions(self, target, adjacent);
+  for (int i = 0; i < count; i++) {
+    region_map_add_penguins(self, adjacent[i], player_idx, 1);
+  }
+  return split;
+}
+
+/// @relatesalso RegionMap
+/// @brief Undoes the last move applied with #region_map_move_penguin.
+void region_map_undo_move(RegionMap* self) {
+  while (self->changes_count > 0) {
+    const RegionMapChange* change = &self->changes[--self->changes_count];
+    switch (change->type) {
+      case REGION_CHANGE_MOVE: self->regions_count = change->value; return;
+      case REGION_CHANGE_LABEL: self->labels[change->index] = change->value; break;
+      case REGION_CHANGE_REGION:
+        self->regions[change->index].fish = change->value;
+        self->regions[change->index].tiles = change->value2;
+        break;
+      case REGION_CHANGE_PENGUINS: self->penguins[change->index] = change->value; break;
+    }
+  }
+  assert(!"There is no move to undo");
+}
+
+extern int region_map_label(const RegionMap* self, Coords coords);
+extern int region_map_fish(const RegionMap* self, int region);
+extern int region_map_penguins(const RegionMap* self, int region, int player_idx);
@@ -0,0 +1,136 @@
+#pragma once
+
+/// @file
+/// @brief The incrementally maintained map of the connected regions of the board
+/// @see bot.h
+
+#include "game.h"
+#include "position.h"
+#include "utils.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief A connected group of fish tiles, see #RegionMap.
+typedef struct Region {
+  /// The total number of fish in the region.
+  int fish;
+  /// The number of tiles in the region.
+  int tiles;
+} Region;
+
+/// Values of #RegionMapChange::type.
+typedef enum RegionMapChangeType {
+  /// Marks the start of a move, #RegionMapChange::value is the #RegionMap::regions_count.
+  REGION_CHANGE_MOVE,
+  /// A change of an element of #RegionMap::labels.
+  REGION_CHANGE_LABEL,
+  /// @brief A change of an element of #RegionMap::regions, the old
+  /// #Region::fish and #Region::tiles are stored in #RegionMapChange::value and
+  /// #RegionMapChange::value2.
+  REGION_CHANGE_REGION,
+  /// A change of an element of #RegionMap::penguins.
+  REGION_CHANGE_PENGUINS,
+} RegionMapChangeType;
+
+/// @brief An entry of #RegionMap::changes, remembers the old value of
+/// something for #region_map_undo_move.
+typedef struct RegionMapChange {
+  RegionMapChangeType type;
+  /// The index of the changed element.
+  int index;
+  int value;
+  int value2;
+} RegionMapChange;
+
+/// @brief Splits the fish tiles of the board into the regions connected by
+/// the sides of the tiles (i.e. the areas which could be filled by
+/// #flood_fill), and keeps track of the number of fish and of the penguins in
+/// each one.
+///
+/// Just like the #Bitboard, this is a mirror of the #SearchPosition maintained
+/// by the bot: it is loaded once with #region_map_load, and afterwards every
+/// move is applied with #region_map_move_penguin and undone with
+/// #region_map_undo_move. The moves can only ever remove tiles from the
+/// regions, so a region can only shrink or fall apart, and whether it has
+/// fallen apart is checked only around the tile which was taken (see
+/// #region_map_move_penguin). The changes are recorded in a journal, which
+/// makes undoing the moves trivial.
+///
+/// A penguin is counted as a member of all regions adjacent to its tile.
+typedef struct RegionMap {
+  int width;
+  int height;
+  int players_count;
+  /// @brief The index of the region of every tile (in the same layout as
+  /// #Game::board_grid), negative for the tiles without fish.
+  int* labels;
+  /// @brief The number of fish on every tile at the time of loading. Since
+  /// the fish are never put back onto the tiles, this doesn't have to change.
+  short* tile_fish;
+  /// The list of regions, some of which may be empty.
+  Region* regions;
+  int regions_count;
+  size_t regions_cap;
+  /// @brief The number of penguins of each player in each region, the counts
+  /// of the region @c i start at the index <tt>i * players_count</tt>.
+  int* penguins;
+  /// The journal of the changes, see #RegionMapChange.
+  RegionMapChange* changes;
+  size_t changes_count;
+  size_t changes_cap;
+
+  /// @name Scratch space of #region_map_move_penguin
+  /// @{
+
+  /// The queues of the fills started in different directions, one board-sized
+  /// segment per direction.
+  int* fill_queue;
+  /// The fill which has visited the tile, combined with #fill_stamp.
+  unsigned* fill_marks;
+  /// Distinguishes the marks of the current fill from the stale ones.
+  unsigned fill_stamp;
+
+  /// @}
+} RegionMap;
+
+RegionMap* region_map_new(void);
+void region_map_free(RegionMap* self);
+void region_map_load(RegionMap* self, const SearchPosition* position, int max_moves);
+bool region_map_move_penguin(
+  RegionMap* self, const SearchPosition* position, Coords start, Coords target
+);
+void region_map_undo_move(RegionMap* self);
+
+/// @relatesalso RegionMap
+/// @brief Returns the index of the region of the tile, negative if the tile
+/// doesn't contain fish or is outside the board.
+inline ALWAYS_INLINE int region_map_label(const RegionMap* self, Coords coords) {
+  int x = coords.x, y = coords.y;
+  if (!(0 <= x && x < self->width && 0 <= y && y < self->height)) return -1;
+  return self->labels[x + y * self->width];
+}
+
+/// @relatesalso RegionMap
+/// @brief Returns the total number of fish in the region of the given index.
+inline int region_map_fish(const RegionMap* self, int region) {
+  assert(0 <= region && region < self->regions_count);
+  return self->regions[region].fish;
+}
+
+/// @relatesalso RegionMap
+/// @brief Returns the number of penguins of the player at @c player_idx
+/// adjacent to the region of the given index.
+inline int region_map_penguins(const RegionMap* self, int region, int player_idx) {
+  assert(0 <= region && region < self->regions_count);
+  assert(0 <= player_idx && player_idx < self->players_count);
+  return self->penguins[region * self->players_count + player_idx];
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,424 @@
+// The adversarial search is the textbook minimax with alpha-beta pruning,
+// generalized to more than two players in the three usual ways. Unlike the
+// recursion of the standard "smart" algorithm, which only plays out the moves
+// of a single penguin, here all players take turns, so the bot can see the
+// opponents coming to block it.
+//
+// See also:
+// <https://www.chessprogramming.org/Alpha-Beta>
+// <https://www.chessprogramming.org/Paranoid_Search>
+// <https://www.chessprogramming.org/Max-n>
+// <https://www.chessprogramming.org/Best_Reply_Search>
+
+#include "search.h"
+#include "bitboard.h"
+#include "board.h"
+#include "bot.h"
+#include "game.h"
+#include "movement.h"
+#include "position.h"
+#include "threading.h"
+#include "transposition.h"
+#include "utils.h"
+#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/// @brief The parameters of a single search, shared by all of its nodes.
+typedef struct SearchContext {
+  /// The base #BotState, only checked with #bot_should_stop.
+  BotState* root;
+  BotAdversarialMode mode;
+  /// The index of the player the bot is searching for.
+  int me;
+  /// Mixed into the keys of the #BotState::transposition_table.
+  uint64_t salt;
+} SearchContext;
+
+/// @relatedalso BotState
+/// @brief The static evaluation of the position from the point of view of the
+/// player at @c player_idx, used at the leaves of the search tree.
+///
+/// Consists of the collected fish and, to a lesser extent, the fish the
+/// penguins can reach in a single move, so that between two equally
+/// profitable moves the one which doesn't corner the bot is preferred, and
+/// cornering the opponents is rewarded.
+int bot_evaluate_player(BotState* self, int player_idx) {
+  const SearchPosition* position = self->position;
+  const Coords* penguins = search_position_player_penguins(position, player_idx);
+  int mobility = 0;
+  for (int i = 0; i < position->penguins_counts[player_idx]; i++) {
+    Coords penguin = penguins[i];
+    PossibleSteps moves = bitboard_possible_steps(self->bitboard, penguin);
+    for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+      Coords d = DIRECTION_TO_COORDS[dir], target = penguin;
+      for (int steps = moves.steps[dir]; steps > 0; steps--) {
+        target.x += d.x, target.y += d.y;
+        mobility += bitboard_tile_fish(self->bitboard, target);
+      }
+    }
+  }
+  return 10 * position->points[player_idx] + mobility;
+}
+
+/// @brief The utility of the paranoid and Best-Reply searches: the bot's own
+/// evaluation minus the one of the strongest opponent.
+static int search_paranoid_utility(const SearchContext* ctx, BotState* node) {
+  int mine = bot_evaluate_player(node, ctx->me);
+  int strongest_opponent = INT_MIN;
+  for (int i = 0; i < node->position->players_count; i++) {
+    if (i == ctx->me) continue;
+    strongest_opponent = my_max(strongest_opponent, bot_evaluate_player(node, i));
+  }
+  return strongest_opponent == INT_MIN ? mine : mine - strongest_opponent;
+}
+
+/// @brief Computes the key of the #BotState::transposition_table for the
+/// current position.
+static uint64_t search_key(
+  const SearchContext* ctx, const BotState* node, int depth, bool max_layer
+) {
+  const SearchPosition* position = node->position;
+  uint64_t key = position->zobrist_key;
+  key ^= splitmix64_mix(ctx->salt ^ ((uint64_t)depth << 1 | max_layer));
+  // The scores aren't a part of the Zobrist key, but the evaluation depends on
+  // them, and the same board can be reached with the fish divided differently.
+  for (int i = 0; i < position->players_count; i++) {
+    uint64_t points = (uint32_t)position->points[i];
+    key ^= splitmix64_mix(ctx->salt + ((uint64_t)i << 32 | points));
+  }
+  return key;
+}
+
+/// @brief Generates the moves of the player at @c player_idx, or of all
+/// opponents of the bot if @c player_idx is negative, ordered so that the
+/// moves onto the tiles with more fish come first (the order of moves is what
+/// makes alpha-beta pruning effective).
+static BotMove* search_generate_moves(
+  const SearchContext* ctx, BotState* node, int player_idx, int* moves_count
+) {
+  const SearchPosition* position = node->position;
+  int max_penguins = position->players_count * position->penguins_per_player;
+  bot_alloc_buf(node->tile_coords, node->tile_coords_cap, max_penguins);
+  int penguins_count = 0;
+  for (int i = 0; i < position->players_count; i++) {
+    if (player_idx >= 0 ? i != player_idx : i == ctx->me) continue;
+    const Coords* penguins = search_position_player_penguins(position, i);
+    for (int j = 0; j < position->penguins_counts[i]; j++) {
+      node->tile_coords[penguins_count++] = penguins[j];
+    }
+  }
+
+  BotMove* moves =
+    bot_generate_all_moves_list(node, penguins_count, node->tile_coords, moves_count);
+  bot_alloc_buf(node->move_scores, node->move_scores_cap, *moves_count);
+  int* fish = node->move_scores;
+  // A stable insertion sort, the lists are short.
+  for (int i = 0; i < *moves_count; i++) {
+    BotMove move = moves[i];
+    int move_fish = bitboard_tile_fish(node->bitboard, move.target);
+    int j = i;
+    for (; j > 0 && fish[j - 1] < move_fish; j--) {
+      moves[j] = moves[j - 1], fish[j] = fish[j - 1];
+    }
+    moves[j] = move, fish[j] = move_fish;
+  }
+  return moves;
+}
+
+/// @brief Applies the move and passes the turn to the next player who can move
+/// (the way #game_advance_state does it). Returns the index of that player, or
+/// a negative number if the game is over. Undone by #bot_undo_move.
+static int search_make_move(BotState* node, BotMove move) {
+  bot_make_move(node, move);
+  return search_position_switch_player(node->position);
+}
+
+/// @brief The paranoid alpha-beta search. The bot is the maximizing player,
+/// all other players are minimizing.
+static int search_paranoid(
+  const SearchContext* ctx, BotState* node, int depth, int alpha, int beta, BotMove* out_best
+) {
+  if (bot_should_stop(ctx->root)) return 0;
+  if (depth == 0) return search_paranoid_utility(ctx, node);
+
+  int player_idx = node->position->current_player_index;
+  bool maximizing = player_idx == ctx->me;
+  TranspositionTable* table = node->transposition_table;
+  int best_score = 0;
+  if (table != NULL && out_best == NULL) {
+    uint64_t key = search_key(ctx, node, depth, maximizing);
+    if (transposition_table_probe(table, key, &best_score)) return best_score;
+  }
+
+  int moves_count = 0;
+  BotMove* moves = search_generate_moves(ctx, node, player_idx, &moves_count);
+  assert(moves_count > 0);
+  BotState* sub = bot_enter_substate(node);
+  int initial_alpha = alpha, initial_beta = beta;
+  best_score = maximizing ? INT_MIN : INT_MAX;
+  for (int i = 0; i < moves_count; i++) {
+    BotMove move = moves[i];
+    int score = search_make_move(node, move) < 0
+                  ? search_paranoid_utility(ctx, node)
+                  : search_paranoid(ctx, sub, depth - 1, alpha, beta, NULL);
+    bot_undo_move(node, move);
+    if (bot_should_stop(ctx->root)) return 0;
+
+    if (maximizing ? score > best_score : score < best_score) {
+      best_score = score;
+      if (out_best != NULL) *out_best = move;
+    }
+    if (maximizing) {
+      alpha = my_max(alpha, score);
+    } else {
+      beta = my_min(beta, score);
+    }
+    if (alpha >= beta) break;
+  }
+
+  // Only the exact scores are cached, the ones outside of the window are
+  // merely bounds.
+  if (table != NULL && initial_alpha < best_score && best_score < initial_beta) {
+    transposition_table_store(table, search_key(ctx, node, depth, maximizing), depth, best_score);
+  }
+  return best_score;
+}
+
+/// @brief The Best-Reply Search. The layers of the tree alternate between the
+/// moves of the bot (the maximizing ones) and the moves of all opponents
+/// taken together (the minimizing ones).
+static int search_best_reply(
+  const SearchContext* ctx,
+  BotState* node,
+  int depth,
+  int alpha,
+  int beta,
+  bool max_layer,
+  BotMove* out_best
+) {
+  if (bot_should_stop(ctx->root)) return 0;
+  if (depth == 0) return search_paranoid_utility(ctx, node);
+
+  TranspositionTable* table = node->transposition_table;
+  int best_score = 0;
+  if (table != NULL && out_best == NULL) {
+    uint64_t key = search_key(ctx, node, depth, max_layer);
+    if (transposition_table_probe(table, key, &best_score)) return best_score;
+  }
+
+  int moves_count = 0;
+  BotMove* moves = search_generate_moves(ctx, node, max_layer ? ctx->me : -1, &moves_count);
+  if (moves_count == 0) {
+    // This side has to skip the turn, the game is over if the other side
+    // can't move either.
+    search_generate_moves(ctx, node, max_layer ? -1 : ctx->me, &moves_count);
+    if (moves_count == 0) return search_paranoid_utility(ctx, node);
+    return search_best_reply(ctx, node, depth - 1, alpha, beta, !max_layer, NULL);
+  }
+
+  BotState* sub = bot_enter_substate(node);
+  int initial_alpha = alpha, initial_beta = beta;
+  best_score = max_layer ? INT_MIN : INT_MAX;
+  for (int i = 0; i < moves_count; i++) {
+    BotMove move = moves[i];
+    // The move is made on behalf of the owner of the penguin.
+    bot_make_move(node, move);
+    int score = search_best_reply(ctx, sub, depth - 1, alpha, beta, !max_layer, NULL);
+    bot_undo_move(node, move);
+    if (bot_should_stop(ctx->root)) return 0;
+
+    if (max_layer ? score > best_score : score < best_score) {
+      best_score = score;
+      if (out_best != NULL) *out_best = move;
+    }
+    if (max_layer) {
+      alpha = my_max(alpha, score);
+    } else {
+      beta = my_min(beta, score);
+    }
+    if (alpha >= beta) break;
+  }
+
+  if (table != NULL && initial_alpha < best_score && best_score < initial_beta) {
+    transposition_table_store(table, search_key(ctx, node, depth, max_layer), depth, best_score);
+  }
+  return best_score;
+}
+
+/// @brief The max-n search: every player picks the move which maximizes their
+/// own evaluation. The evaluations of all players are written to @c
+/// out_values. There is no pruning, so this search is considerably slower.
+static void search_max_n(
+  const SearchContext* ctx, BotState* node, int depth, int* out_values, BotMove* out_best
+) {
+  const SearchPosition* position = node->position;
+  int players_count = position->players_count;
+  if (bot_should_stop(ctx->root)) return;
+  if (depth == 0) {
+    for (int i = 0; i < players_count; i++) {
+      out_values[i] = bot_evaluate_player(node, i);
+    }
+    return;
+  }
+
+  int player_idx = position->current_player_index;
+  int moves_count = 0;
+  BotMove* moves = search_generate_moves(ctx, node, player_idx, &moves_count);
+  assert(moves_count > 0);
+  BotState* sub = bot_enter_substate(node);
+  // The first half of the buffer receives the evaluations of the children, the
+  // second half is used as the out_values of the base state.
+  bot_alloc_buf(node->search_values, node->search_values_cap, 2 * players_count);
+  int* child_values = node->search_values;
+  for (int i = 0; i < moves_count; i++) {
+    BotMove move = moves[i];
+    if (search_make_move(node, move) < 0) {
+      search_max_n(ctx, node, 0, child_values, NULL);
+    } else {
+      search_max_n(ctx, sub, depth - 1, child_values, NULL);
+    }
+    bot_undo_move(node, move);
+    if (bot_should_stop(ctx->root)) return;
+
+    if (i == 0 || child_values[player_idx] > out_values[player_idx]) {
+      for (int j = 0; j < players_count; j++) {
+        out_values[j] = child_values[j];
+      }
+      if (out_best != NULL) *out_best = move;
+    }
+  }
+}
+
+/// @brief Runs the search of the selected mode from the root @c node.
+static void search_root(const SearchContext* ctx, BotState* node, int depth, BotMove* out_best) {
+  int players_count = node->position->players_count;
+  switch (ctx->mode) {
+    case BOT_ADVERSARIAL_PARANOID: {
+      search_paranoid(ctx, node, depth, INT_MIN, INT_MAX, out_best);
+      break;
+    }
+    case BOT_ADVERSARIAL_BEST_REPLY: {
+      search_best_reply(ctx, node, depth, INT_MIN, INT_MAX, true, out_best);
+      break;
+    }
+    case BOT_ADVERSARIAL_MAX_N: {
+      bot_alloc_buf(node->search_values, node->search_values_cap, 2 * players_count);
+      int* values = node->search_values + players_count;
+      search_max_n(ctx, node, depth, values, out_best);
+      break;
+    }
+  }
+}
+
+/// @brief The job of the helper threads of the Lazy SMP search.
+typedef struct SearchHelperJob {
+  /// The context of the main thread.
+  const SearchContext* ctx;
+  /// The state of the main thread, which owns the #BotState::workers.
+  const BotState* base;
+  int first_depth, last_depth;
+} SearchHelperJob;
+
+/// @brief The entry point of the helper threads, see #bot_search_move.
+static void search_helper_main(void* arg) {
+  BotWorker* worker = arg;
+  const SearchHelperJob* job = worker->job;
+  SearchContext ctx = *job->ctx;
+  ctx.root = worker->state;
+  // Half of the helpers are searching one level deeper than the main thread.
+  int offset = (int)(worker - job->base->workers) % 2;
+  for (int depth = job->first_depth + offset; depth <= job->last_depth; depth++) {
+    BotMove unused;
+    search_root(&ctx, worker->state, depth, &unused);
+    if (bot_should_stop(worker->state)) break;
+  }
+}
+
+/// @relatedalso BotState
+/// @brief The implementation of #BOT_MOVEMENT_ADVERSARIAL, called by
+/// #bot_compute_move.
+///
+/// Searches the game tree #BotParameters::search_depth moves (of all players)
+/// ahead with the algorithm selected by #BotParameters::adversarial_mode (or
+/// less, if it runs out of #BotParameters::time_limit_ms). The moves are
+/// applied to the #BotState::position with #bot_make_move and the turns are
+/// passed with #search_position_switch_player, just like in the real game, and
+/// everything is undone afterwards. The scores of the positions are cached in
+/// the #BotState::transposition_table (except in the max-n mode, which
+/// evaluates every player separately), which is where it really shines:
+/// different orders of the moves of different penguins lead to the same
+/// positions.
+///
+/// With #BotParameters::threads_count above one, the search runs in the Lazy
+/// SMP fashion: the #BotState::workers search the same position in the
+/// background, half of them one level deeper, and the transposition table
+/// shared by all threads lets the main thread skip the subtrees which the
+/// helpers have already evaluated. Since only the exact scores are cached,
+/// the chosen move is the same as it would be on a single thread.
+///
+/// @see <https://www.chessprogramming.org/Lazy_SMP>
+///
+/// @returns @c true if a move was found, @c false if there were no moves
+/// available for the player or if the computation was cancelled.
+bool bot_search_move(BotState* self, Coords* out_penguin, Coords* out_target) {
+  const BotParameters* params = self->params;
+  SearchContext ctx;
+  ctx.root = self;
+  ctx.mode = params->adversarial_mode;
+  ctx.me = self->position->current_player_index;
+  uint64_t mode = (uint64_t)ctx.mode, me = (uint64_t)ctx.me;
+  ctx.salt = splitmix64_mix(self->transposition_salt ^ (mode << 48 | me << 32));
+
+  // With a time limit, the search is repeated with increasing depth, and the
+  // best move of the deepest completed iteration is kept.
+  uint64_t deadline = bot_start_timer(self);
+  int max_depth = my_max(params->search_depth, 1);
+  int first_depth = deadline != 0 ? 1 : max_depth;
+
+  // The helpers are useless without the shared table and in the max-n mode,
+  // which doesn't use it.
+  SearchHelperJob helper_job;
+  helper_job.ctx = &ctx;
+  helper_job.base = self;
+  helper_job.first_depth = first_depth;
+  helper_job.last_depth = max_depth + 1;
+  if (self->transposition_table != NULL && ctx.mode != BOT_ADVERSARIAL_MAX_N) {
+    for (int i = 0; i < self->workers_count; i++) {
+      BotWorker* worker = &self->workers[i];
+      worker->state->stop->deadline = 0;
+      worker->state->stop->timed_out = false;
+      worker->state->stop->cancelled = false;
+      worker->job = &helper_job;
+      if (!thread_spawn(&worker->thread, &search_helper_main, worker)) {
+        worker->job = NULL;
+      }
+    }
+  }
+
+  BotMove best = { { -1, -1 }, { -1, -1 } };
+  for (int depth = first_depth; depth <= max_depth; depth++) {
+    BotMove iteration_best = best;
+    search_root(&ctx, self, depth, &iteration_best);
+    if (self->stop->cancelled || self->stop->timed_out) break;
+    best = iteration_best;
+    self->stop->deadline = deadline;
+  }
+  self->stop->deadline = 0;
+
+  // The main thread is done, whatever the helpers were doing is irrelevant now.
+  for (int i = 0; i < self->workers_count; i++) {
+    BotWorker* worker = &self->workers[i];
+    if (worker->job == NULL) continue;
+    bot_cancel(worker->state);
+    thread_join(&worker->thread);
+    worker->job = NULL;
+  }
+
+  if (self->stop->cancelled || best.penguin.x < 0) return false;
+  *out_penguin = best.penguin, *out_target = best.target;
+  return true;
+}
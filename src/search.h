@@ -0,0 +1,20 @@
+#pragma once
+
+/// @file
+/// @brief The adversarial game-tree search of #BOT_MOVEMENT_ADVERSARIAL
+/// @see bot.h
+
+#include "bot.h"
+#include "utils.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool bot_search_move(BotState* self, Coords* out_penguin, Coords* out_target);
+int bot_evaluate_player(BotState* self, int player_idx);
+
+#ifdef __cplusplus
+}
+#endif
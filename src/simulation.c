@@ -0,0 +1,204 @@
+#include "simulation.h"
+#include "board.h"
+#include "bot.h"
+#include "game.h"
+#include "movement.h"
+#include "placement.h"
+#include "threading.h"
+#include "utils.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct SimulationWorker {
+  Thread thread;
+  const SimulationParams* params;
+  volatile int* next_game;
+  /// #SimulationParams::games_count rounded up to whole seat rotations.
+  int games_count;
+  /// The local totals, merged into the #SimulationStats at the end.
+  SimulationPlayerStats* players;
+  int64_t moves_count;
+} SimulationWorker;
+
+/// @brief Sets up a game with a freshly generated board, the players are
+/// named after their seats.
+static Game* simulation_new_game(const SimulationParams* params, Rng* rng) {
+  Game* game = game_new();
+  game->log_disabled = true;
+  game_begin_setup(game);
+  game_set_players_count(game, params->players_count);
+  game_set_penguins_per_player(game, params->penguins_per_player);
+  for (int i = 0; i < params->players_count; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "P%d", i + 1);
+    game_set_player_name(game, i, name);
+  }
+  setup_board(game, params->board_width, params->board_height);
+  switch (params->board_type) {
+    case SIMULATION_BOARD_ISLAND: generate_board_island(game, rng); break;
+    case SIMULATION_BOARD_RANDOM: generate_board_random(game, rng); break;
+  }
+  game_end_setup(game);
+  return game;
+}
+
+/// @brief Plays a whole game, the player at the seat @c i is controlled by
+/// the bot <tt>seat_bots[i]</tt>.
+static void simulation_play_game(
+  SimulationWorker* self, Game* game, const int* seat_bots, Rng* rng
+) {
+  const SimulationParams* params = self->params;
+  int players_count = params->players_count;
+  BotState** bots = malloc(sizeof(*bots) * players_count);
+  for (int i = 0; i < players_count; i++) {
+    bots[i] = bot_state_new(&params->players[seat_bots[i]], game, rng);
+  }
+
+  placement_begin(game);
+  while (placement_switch_player(game) >= 0) {
+    int seat = game->current_player_index;
+    SimulationPlayerStats* stats = &self->players[seat_bots[seat]];
+    Coords target;
+    uint64_t start_time = get_monotonic_time_us();
+    bool ok = bot_compute_placement(bots[seat], &target);
+    stats->bot_time_us += get_monotonic_time_us() - start_time;
+    if (!ok) break;
+    place_penguin(game, target);
+    stats->moves_count += 1;
+    self->moves_count += 1;
+  }
+  placement_end(game);
+
+  movement_begin(game);
+  while (movement_switch_player(game) >= 0) {
+    int seat = game->current_player_index;
+    SimulationPlayerStats* stats = &self->players[seat_bots[seat]];
+    Coords penguin, target;
+    uint64_t start_time = get_monotonic_time_us();
+    bool ok = bot_compute_move(bots[seat], &penguin, &target);
+    stats->bot_time_us += get_monotonic_time_us() - start_time;
+    if (!ok) break;
+    move_penguin(game, penguin, target);
+    stats->moves_count += 1;
+    self->moves_count += 1;
+  }
+  movement_end(game);
+  game_end(game);
+
+  int best_points = 0, best_count = 0;
+  for (int i = 0; i < players_count; i++) {
+    int points = game_get_player(game, i)->points;
+    if (best_count == 0 || points > best_points) {
+      best_points = points, best_count = 1;
+    } else if (points == best_points) {
+      best_count += 1;
+    }
+  }
+  for (int i = 0; i < players_count; i++) {
+    SimulationPlayerStats* stats = &self->players[seat_bots[i]];
+    int points = game_get_player(game, i)->points;
+    stats->points += points;
+    if (points == best_points) {
+      if (best_count == 1) {
+        stats->wins += 1;
+      } else {
+        stats->draws += 1;
+      }
+    }
+    bot_state_free(bots[i]);
+  }
+  free(bots);
+}
+
+static void simulation_worker_main(void* arg) {
+  SimulationWorker* self = arg;
+  const SimulationParams* params = self->params;
+  int players_count = params->players_count;
+  int* seat_bots = malloc(sizeof(*seat_bots) * players_count);
+  int game_idx;
+  while ((game_idx = atomic_fetch_add_int(self->next_game, 1)) < self->games_count) {
+    // Every board is played once in each rotation of the seats, so that the
+    // luck of the seating evens out between the bots.
+    for (int i = 0; i < players_count; i++) {
+      seat_bots[i] = (i + game_idx) % players_count;
+    }
+    Rng rng = init_rng(params->seed + (uint64_t)(game_idx / players_count));
+    Game* game = simulation_new_game(params, &rng);
+    simulation_play_game(self, game, seat_bots, &rng);
+    game_free(game);
+  }
+  free(seat_bots);
+}
+
+/// @relatesalso SimulationStats
+/// @brief Plays #SimulationParams::games_count games between the bots on
+/// randomly generated boards, spread over a pool of threads, and collects
+/// the statistics of the bots. The number of games is rounded up to a
+/// multiple of #SimulationParams::players_count, see
+/// #SimulationParams::players, the actual one is in
+/// #SimulationStats::games_count.
+///
+/// Everything happens in memory, which makes this orders of magnitude faster
+/// than driving the autonomous mode through the board files, and makes the
+/// parameter sweeps and the comparisons of the strategies practical. The
+/// threads are distributed in the same way as in #placement_book_build, and
+/// the calling thread takes part in the work.
+SimulationStats* run_simulation(const SimulationParams* params) {
+  assert(params->games_count >= 0);
+  assert(params->players_count > 0);
+  assert(params->board_width > 0 && params->board_height > 0);
+  int players_count = params->players_count;
+  int games_count = (params->games_count + players_count - 1) / players_count * players_count;
+  int threads_count = params->threads_count > 0 ? params->threads_count : get_cpu_count();
+  threads_count = my_max(1, my_min(threads_count, games_count));
+
+  uint64_t start_time = get_monotonic_time_us();
+  volatile int next_game = 0;
+  SimulationWorker* workers = malloc(sizeof(*workers) * threads_count);
+  for (int i = 0; i < threads_count; i++) {
+    SimulationWorker* worker = &workers[i];
+    worker->params = params;
+    worker->next_game = &next_game;
+    worker->games_count = games_count;
+    worker->players = calloc(players_count, sizeof(*worker->players));
+    worker->moves_count = 0;
+  }
+  int spawned = 1;
+  while (spawned < threads_count &&
+         thread_spawn(&workers[spawned].thread, &simulation_worker_main, &workers[spawned])) {
+    spawned++;
+  }
+  simulation_worker_main(&workers[0]);
+
+  SimulationStats* stats = malloc(sizeof(*stats));
+  stats->games_count = games_count;
+  stats->moves_count = 0;
+  stats->players = calloc(players_count, sizeof(*stats->players));
+  for (int i = 0; i < threads_count; i++) {
+    SimulationWorker* worker = &workers[i];
+    if (0 < i && i < spawned) thread_join(&worker->thread);
+    stats->moves_count += worker->moves_count;
+    for (int j = 0; j < players_count; j++) {
+      SimulationPlayerStats *total = &stats->players[j], *local = &worker->players[j];
+      total->wins += local->wins;
+      total->draws += local->draws;
+      total->points += local->points;
+      total->moves_count += local->moves_count;
+      total->bot_time_us += local->bot_time_us;
+    }
+    free(worker->players);
+  }
+  free(workers);
+  stats->elapsed_us = get_monotonic_time_us() - start_time;
+  return stats;
+}
+
+/// @relatesalso SimulationStats
+void simulation_stats_free(SimulationStats* self) {
+  if (self == NULL) return;
+  free_and_clear(self->players);
+  free(self);
+}
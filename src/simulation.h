@@ -0,0 +1,79 @@
+#pragma once
+
+/// @file
+/// @brief Self-play of the bot for measuring its speed and strength
+/// @see bot.h
+
+#include "bot.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// The generators of the boards for #SimulationParams::board_type.
+typedef enum SimulationBoardType {
+  SIMULATION_BOARD_ISLAND, ///< See #generate_board_island
+  SIMULATION_BOARD_RANDOM, ///< See #generate_board_random
+} SimulationBoardType;
+
+/// @brief The settings of #run_simulation.
+typedef struct SimulationParams {
+  /// @brief The number of games to play, rounded up to a multiple of
+  /// #players_count by #run_simulation.
+  int games_count;
+  /// @brief The number of threads playing the games, or zero to use all CPUs.
+  /// Every thread plays whole games, so the bots themselves should better be
+  /// single-threaded (see #BotParameters::threads_count).
+  int threads_count;
+  int board_width;
+  int board_height;
+  SimulationBoardType board_type;
+  int penguins_per_player;
+  /// The number of the players in every game, the length of #players.
+  int players_count;
+  /// @brief The settings of the bot of every player. Every board is played
+  /// #players_count times in a row, with the seats rotated between the games,
+  /// so that all bots get to play every seat on every board and the results
+  /// don't depend on the luck of the seating.
+  const BotParameters* players;
+  /// @brief The game at the index @c i is played with the #Rng created by
+  /// <tt>#init_rng(seed + i / players_count)</tt>, so that the same seed
+  /// produces the same games regardless of the number of threads (unless the
+  /// bots are limited by time, see #BotParameters::time_limit_ms).
+  uint64_t seed;
+} SimulationParams;
+
+/// @brief The results of a single bot of the #SimulationParams::players.
+typedef struct SimulationPlayerStats {
+  /// The games in which the bot has scored strictly more than the others.
+  int wins;
+  /// The games in which the bot has shared the highest score with others.
+  int draws;
+  /// The sum of the scores of the bot over all games.
+  int64_t points;
+  /// The number of the placements and the movements made by the bot.
+  int64_t moves_count;
+  /// @brief The total time spent in #bot_compute_placement and
+  /// #bot_compute_move, in microseconds.
+  uint64_t bot_time_us;
+} SimulationPlayerStats;
+
+/// @brief The results of #run_simulation.
+typedef struct SimulationStats {
+  int games_count;
+  /// The moves made by all players in all games.
+  int64_t moves_count;
+  /// The wall-clock time of the whole simulation.
+  uint64_t elapsed_us;
+  /// The statistics of every bot, same length as #SimulationParams::players.
+  SimulationPlayerStats* players;
+} SimulationStats;
+
+SimulationStats* run_simulation(const SimulationParams* params);
+void simulation_stats_free(SimulationStats* self);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,165 @@
+#include "arguments.h"
+#include "bot.h"
+#include "simulation.h"
+#include "utils.h"
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_PLAYERS 9
+
+static void print_simulator_usage(const char* prog_name) {
+  fprintf(stderr, "Usage:\n");
+  fprintf(
+    stderr,
+    "%s [games=N] [threads=N] [board=<island|random>] [width=N] [height=N] [penguins=N] "
+    "[players=N] [seed=N] [bot-*=...] [player [bot-*=...]]...\n",
+    prog_name
+  );
+  fprintf(stderr, "\n");
+  fprintf(stderr, "The bot-* options before the first 'player' apply to all players, the ones\n");
+  fprintf(stderr, "after it only to that player. Without any 'player' arguments 'players=N'\n");
+  fprintf(stderr, "identical bots are created (2 by default).\n");
+  fprintf(stderr, "\n");
+  fprintf(stderr, "Every board is played once per rotation of the seats, so 'games=N' is\n");
+  fprintf(stderr, "rounded up to a multiple of the number of players.\n");
+}
+
+int main(int argc, char* argv[]) {
+  const char* prog_name = argc > 0 ? argv[0] : "penguins-sim";
+  SimulationParams params;
+  params.games_count = 100;
+  params.threads_count = 0;
+  params.board_width = 20;
+  params.board_height = 20;
+  params.board_type = SIMULATION_BOARD_ISLAND;
+  params.penguins_per_player = 3;
+  params.players_count = 2;
+  params.seed = generate_random_seed();
+  BotParameters defaults;
+  init_bot_parameters(&defaults);
+  BotParameters players[MAX_PLAYERS];
+  int explicit_players = 0;
+
+  bool ok = true;
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* arg_value = arg;
+    long num = 0;
+    BotParameters* bot = explicit_players > 0 ? &players[explicit_players - 1] : &defaults;
+    if (strcmp(arg, "help") == 0) {
+      print_simulator_usage(prog_name);
+      return EXIT_SUCCESS;
+    } else if (strcmp(arg, "player") == 0) {
+      if (explicit_players < MAX_PLAYERS) {
+        players[explicit_players++] = defaults;
+      } else {
+        fprintf(stderr, "Too many players, at most %d are supported\n", MAX_PLAYERS);
+        ok = false;
+      }
+    } else if (parse_bot_argument(bot, arg, &ok)) {
+      // Handled.
+    } else if ((arg_value = strip_prefix(arg, "games="))) {
+      if (parse_number(arg_value, &num) && num > 0) {
+        params.games_count = (int)num;
+      } else {
+        fprintf(stderr, "Invalid value for the 'games' option: '%s'\n", arg_value);
+        ok = false;
+      }
+    } else if ((arg_value = strip_prefix(arg, "threads="))) {
+      if (parse_number(arg_value, &num) && num >= 0) {
+        params.threads_count = (int)num;
+      } else {
+        fprintf(stderr, "Invalid value for the 'threads' option: '%s'\n", arg_value);
+        ok = false;
+      }
+    } else if ((arg_value = strip_prefix(arg, "board="))) {
+      if (strcmp(arg_value, "island") == 0) {
+        params.board_type = SIMULATION_BOARD_ISLAND;
+      } else if (strcmp(arg_value, "random") == 0) {
+        params.board_type = SIMULATION_BOARD_RANDOM;
+      } else {
+        fprintf(stderr, "Invalid value for the 'board' option: '%s'\n", arg_value);
+        ok = false;
+      }
+    } else if ((arg_value = strip_prefix(arg, "width="))) {
+      if (parse_number(arg_value, &num) && num > 0) {
+        params.board_width = (int)num;
+      } else {
+        fprintf(stderr, "Invalid value for the 'width' option: '%s'\n", arg_value);
+        ok = false;
+      }
+    } else if ((arg_value = strip_prefix(arg, "height="))) {
+      if (parse_number(arg_value, &num) && num > 0) {
+        params.board_height = (int)num;
+      } else {
+        fprintf(stderr, "Invalid value for the 'height' option: '%s'\n", arg_value);
+        ok = false;
+      }
+    } else if ((arg_value = strip_prefix(arg, "penguins="))) {
+      if (parse_number(arg_value, &num) && num > 0) {
+        params.penguins_per_player = (int)num;
+      } else {
+        fprintf(stderr, "Invalid value for the 'penguins' option: '%s'\n", arg_value);
+        ok = false;
+      }
+    } else if ((arg_value = strip_prefix(arg, "seed="))) {
+      if (parse_number(arg_value, &num) && num >= 0) {
+        params.seed = (uint64_t)num;
+      } else {
+        fprintf(stderr, "Invalid value for the 'seed' option: '%s'\n", arg_value);
+        ok = false;
+      }
+    } else if ((arg_value = strip_prefix(arg, "players="))) {
+      if (parse_number(arg_value, &num) && num > 0 && num <= MAX_PLAYERS) {
+        params.players_count = (int)num;
+      } else {
+        fprintf(stderr, "Invalid value for the 'players' option: '%s'\n", arg_value);
+        ok = false;
+      }
+    } else {
+      fprintf(stderr, "Unexpected argument: '%s'\n", arg);
+      ok = false;
+    }
+  }
+  if (!ok) {
+    print_simulator_usage(prog_name);
+    return EXIT_FAILURE;
+  }
+
+  if (explicit_players > 0) {
+    params.players_count = explicit_players;
+  } else {
+    for (int i = 0; i < params.players_count; i++) {
+      players[i] = defaults;
+    }
+  }
+  params.players = players;
+
+  SimulationStats* stats = run_simulation(&params);
+  double elapsed_secs = (double)stats->elapsed_us / 1e6;
+  printf("seed:       %" PRIu64 "\n", params.seed);
+  printf("games:      %d in %.3f s\n", stats->games_count, elapsed_secs);
+  printf("games/sec:  %.2f\n", (double)stats->games_count / elapsed_secs);
+  printf("moves/sec:  %.1f\n", (double)stats->moves_count / elapsed_secs);
+  printf("\n");
+  printf("player      wins    draws   win rate  avg points  avg bot time/move\n");
+  for (int i = 0; i < params.players_count; i++) {
+    const SimulationPlayerStats* player = &stats->players[i];
+    double games = my_max(stats->games_count, 1);
+    double moves = (double)my_max(player->moves_count, 1);
+    printf(
+      "%-10d  %-6d  %-6d  %7.2f%%  %10.2f  %14.3f ms\n",
+      i + 1,
+      player->wins,
+      player->draws,
+      100.0 * player->wins / games,
+      (double)player->points / games,
+      (double)player->bot_time_us / 1e3 / moves
+    );
+  }
+  simulation_stats_free(stats);
+  return EXIT_SUCCESS;
+}
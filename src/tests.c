@@ -1,13 +1,25 @@
 // NOTE: Refer to <https://github.com/nemequ/munit/blob/master/example.c> for
 // information on using our testing library.
 
+#include "bitboard.h"
 #include "board.h"
+#include "book.h"
+#include "bot.h"
+#include "endgame.h"
 #include "game.h"
+#include "junctions.h"
 #include "movement.h"
 #include "placement.h"
+#include "position.h"
+#include "regions.h"
+#include "simulation.h"
+#include "threading.h"
+#include "transposition.h"
 #include "utils.h"
+#include <limits.h>
 #include <munit.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 static MunitResult test_game_clone(const MunitParameter* params, void* data) {
   UNUSED(params), UNUSED(data);
@@ -21,6 +33,9 @@ static MunitResult test_game_clone(const MunitParameter* params, void* data) {
   game_set_penguins_per_player(game, 2);
   Game* clone = game_clone(game);
   game_free(game);
+  // The penguins lists of the clone have the full capacity.
+  game_add_player_penguin(clone, 0, (Coords){ 1, 1 });
+  game_add_player_penguin(clone, 0, (Coords){ 2, 2 });
   game_free(clone);
   return MUNIT_OK;
 }
@@ -171,6 +186,1401 @@ test_move_penguin_and_calculate_points(const MunitParameter* params, void* data)
   return MUNIT_OK;
 }
 
+static MunitResult test_bitboard_matches_game(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Game* game = game_new();
+  // Wide enough for the rows to span two words of the bitboard.
+  enum { WIDTH = 70, HEIGHT = 4 };
+  char board[WIDTH * HEIGHT + 1];
+  for (int i = 0; i < WIDTH * HEIGHT; i++) {
+    int x = i % WIDTH, y = i / WIDTH;
+    board[i] = (x * 7 + y * 3) % 11 == 0 ? '~' : (char)('1' + (x + y) % 3);
+  }
+  board[WIDTH * HEIGHT] = '\0';
+  board[63] = 'A', board[WIDTH + 64] = 'B', board[2 * WIDTH] = 'A', board[3 * WIDTH - 1] = 'B';
+  setup_test_game(game, /*players*/ 2, /*penguins*/ 2, WIDTH, HEIGHT, board);
+
+  Bitboard* bitboard = bitboard_new();
+  bitboard_load_game(bitboard, game);
+  for (int y = 0; y < HEIGHT; y++) {
+    for (int x = 0; x < WIDTH; x++) {
+      Coords coords = { x, y };
+      short tile = get_tile(game, coords);
+      munit_assert_int(bitboard_tile_fish(bitboard, coords), ==, get_tile_fish(tile));
+      munit_assert_int(
+        bitboard_count_obstructed(bitboard, coords), ==, count_obstructed_directions(game, coords)
+      );
+      PossibleSteps expected = calculate_penguin_possible_moves(game, coords);
+      PossibleSteps actual = bitboard_possible_steps(bitboard, coords);
+      for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+        munit_assert_int(actual.steps[dir], ==, expected.steps[dir]);
+      }
+      unsigned penguins = bitboard_neighbors_mask(bitboard, bitboard->penguins, coords);
+      for (int dir = 0; dir < NEIGHBOR_MAX; dir++) {
+        Coords neighbor = NEIGHBOR_TO_COORDS[dir];
+        neighbor.x += x, neighbor.y += y;
+        bool expected_penguin =
+          is_tile_in_bounds(game, neighbor) && is_penguin_tile(get_tile(game, neighbor));
+        munit_assert_int(test_bit(penguins, 1u << dir) != 0, ==, expected_penguin);
+      }
+    }
+  }
+  bitboard_free(bitboard);
+  game_free(game);
+  return MUNIT_OK;
+}
+
+struct TestFloodFillCtx {
+  Game* game;
+  short* grid;
+  short marker_value;
+  int fish_count;
+  FillSpan* stack;
+};
+
+static bool test_flood_fill_check(int x, int y, void* data) {
+  struct TestFloodFillCtx* ctx = data;
+  Coords coords = { x, y };
+  if (!is_tile_in_bounds(ctx->game, coords)) return false;
+  if (ctx->grid[x + y * ctx->game->board_width] != 0) return false;
+  return is_fish_tile(get_tile(ctx->game, coords));
+}
+
+static void test_flood_fill_mark(int x, int y, void* data) {
+  struct TestFloodFillCtx* ctx = data;
+  ctx->fish_count += get_tile_fish(get_tile(ctx->game, (Coords){ x, y }));
+  ctx->grid[x + y * ctx->game->board_width] = ctx->marker_value;
+}
+
+static FillSpan* test_flood_fill_alloc_stack(size_t capacity, void* data) {
+  struct TestFloodFillCtx* ctx = data;
+  ctx->stack = realloc(ctx->stack, sizeof(*ctx->stack) * capacity);
+  return ctx->stack;
+}
+
+static MunitResult test_bitboard_flood_fill(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Game* game = game_new();
+  // Wide enough for the regions to cross the boundaries of the words.
+  enum { WIDTH = 70, HEIGHT = 6 };
+  char board[WIDTH * HEIGHT + 1];
+  for (int i = 0; i < WIDTH * HEIGHT; i++) {
+    int x = i % WIDTH, y = i / WIDTH;
+    board[i] = (x * 5 + y * 3) % 4 == 0 || x % 13 == 6 ? '~' : (char)('1' + (x * y) % 3);
+  }
+  board[WIDTH * HEIGHT] = '\0';
+  board[WIDTH * 2 + 1] = 'A', board[WIDTH * 4 + 65] = 'B';
+  setup_test_game(game, /*players*/ 2, /*penguins*/ 1, WIDTH, HEIGHT, board);
+
+  BotParameters bot_params;
+  init_bot_parameters(&bot_params);
+  Rng rng = init_random_rng();
+  BotState* actual = bot_state_new(&bot_params, game, &rng);
+  actual->bitboard = bitboard_new();
+  bitboard_load_game(actual->bitboard, game);
+  short* actual_grid =
+    bot_flood_fill_reset_grid(actual, &actual->fill_grid1, &actual->fill_grid1_cap);
+  // The expected results are produced by the generic span filling algorithm.
+  short* expected_grid = calloc(WIDTH * HEIGHT, sizeof(*expected_grid));
+  struct TestFloodFillCtx ctx = { game, expected_grid, 0, 0, NULL };
+  // Every region gets its own marker, the tiles of the regions which were
+  // already filled must be skipped.
+  short marker = 1;
+  int regions_count = 0;
+  for (int y = 0; y < HEIGHT; y++) {
+    for (int x = 0; x < WIDTH; x++) {
+      Coords coords = { x, y };
+      ctx.marker_value = marker, ctx.fish_count = 0;
+      flood_fill(
+        x, y, test_flood_fill_check, test_flood_fill_mark, test_flood_fill_alloc_stack, &ctx
+      );
+      int fish = ctx.fish_count;
+      munit_assert_int(bot_flood_fill_count_fish(actual, actual_grid, coords, marker), ==, fish);
+      if (fish > 0) marker++, regions_count++;
+    }
+  }
+  munit_assert_int(regions_count, >, 1);
+  munit_assert_memory_equal(sizeof(*actual_grid) * WIDTH * HEIGHT, actual_grid, expected_grid);
+
+  free(ctx.stack);
+  free(expected_grid);
+  bot_state_free(actual);
+  game_free(game);
+  return MUNIT_OK;
+}
+
+enum { FLOOD_FILL_BENCH_WIDTH = 64, FLOOD_FILL_BENCH_HEIGHT = 48, FLOOD_FILL_BENCH_ROUNDS = 20 };
+
+static Game* setup_flood_fill_benchmark(void) {
+  Game* game = game_new();
+  enum { WIDTH = FLOOD_FILL_BENCH_WIDTH, HEIGHT = FLOOD_FILL_BENCH_HEIGHT };
+  char board[WIDTH * HEIGHT + 1];
+  unsigned random = 12345;
+  for (int i = 0; i < WIDTH * HEIGHT; i++) {
+    random = random * 1103515245 + 12345;
+    unsigned value = (random >> 16) % 8;
+    board[i] = value < 2 ? '~' : (char)('1' + value % 3);
+  }
+  board[WIDTH * HEIGHT] = '\0';
+  board[0] = 'A', board[WIDTH * HEIGHT - 1] = 'B';
+  setup_test_game(game, /*players*/ 2, /*penguins*/ 1, WIDTH, HEIGHT, board);
+  return game;
+}
+
+/// Fills the whole board region by region, either with #flood_fill and the
+/// callbacks above or with #bot_flood_fill_count_fish.
+static int run_flood_fill_benchmark(Game* game, BotState* bot, short* grid) {
+  int w = game->board_width, h = game->board_height;
+  int total_fish = 0;
+  struct TestFloodFillCtx ctx = { game, grid, 1, 0, NULL };
+  for (int i = 0; i < w * h; i++) grid[i] = 0;
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      int fish;
+      if (bot != NULL) {
+        fish = bot_flood_fill_count_fish(bot, grid, (Coords){ x, y }, ctx.marker_value);
+      } else {
+        ctx.fish_count = 0;
+        flood_fill(
+          x, y, test_flood_fill_check, test_flood_fill_mark, test_flood_fill_alloc_stack, &ctx
+        );
+        fish = ctx.fish_count;
+      }
+      if (fish > 0) ctx.marker_value++;
+      total_fish += fish;
+    }
+  }
+  free(ctx.stack);
+  return total_fish;
+}
+
+static MunitResult test_specialized_flood_fill(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Game* game = setup_flood_fill_benchmark();
+  BotParameters bot_params;
+  init_bot_parameters(&bot_params);
+  Rng rng = init_random_rng();
+  // Without the bitboard the specialized span filling algorithm is used.
+  BotState* bot = bot_state_new(&bot_params, game, &rng);
+  enum { SIZE = FLOOD_FILL_BENCH_WIDTH * FLOOD_FILL_BENCH_HEIGHT };
+  short* expected_grid = malloc(sizeof(*expected_grid) * SIZE);
+  short* actual_grid = malloc(sizeof(*actual_grid) * SIZE);
+  int expected_fish = run_flood_fill_benchmark(game, NULL, expected_grid);
+  munit_assert_int(run_flood_fill_benchmark(game, bot, actual_grid), ==, expected_fish);
+  munit_assert_memory_equal(sizeof(*actual_grid) * SIZE, actual_grid, expected_grid);
+  free(expected_grid);
+  free(actual_grid);
+  bot_state_free(bot);
+  game_free(game);
+  return MUNIT_OK;
+}
+
+// The following two tests do the same work with the generic and with the
+// specialized flood fill, compare their timings reported by munit.
+
+static MunitResult bench_generic_flood_fill(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Game* game = setup_flood_fill_benchmark();
+  short* grid = malloc(sizeof(*grid) * game->board_width * game->board_height);
+  for (int i = 0; i < FLOOD_FILL_BENCH_ROUNDS; i++) {
+    munit_assert_int(run_flood_fill_benchmark(game, NULL, grid), >, 0);
+  }
+  free(grid);
+  game_free(game);
+  return MUNIT_OK;
+}
+
+static MunitResult bench_specialized_flood_fill(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Game* game = setup_flood_fill_benchmark();
+  BotParameters bot_params;
+  init_bot_parameters(&bot_params);
+  Rng rng = init_random_rng();
+  BotState* bot = bot_state_new(&bot_params, game, &rng);
+  short* grid = malloc(sizeof(*grid) * game->board_width * game->board_height);
+  for (int i = 0; i < FLOOD_FILL_BENCH_ROUNDS; i++) {
+    munit_assert_int(run_flood_fill_benchmark(game, bot, grid), >, 0);
+  }
+  free(grid);
+  bot_state_free(bot);
+  game_free(game);
+  return MUNIT_OK;
+}
+
+static void assert_same_regions(const RegionMap* actual, const RegionMap* expected) {
+  // The indexes of the regions may be different, but they must describe the
+  // same groups of tiles.
+  int* mapping = malloc(sizeof(*mapping) * expected->regions_count);
+  int* reverse_mapping = malloc(sizeof(*reverse_mapping) * actual->regions_count);
+  for (int i = 0; i < expected->regions_count; i++) mapping[i] = -1;
+  for (int i = 0; i < actual->regions_count; i++) reverse_mapping[i] = -1;
+  for (int i = 0; i < expected->width * expected->height; i++) {
+    int label = actual->labels[i], expected_label = expected->labels[i];
+    munit_assert_int(label < 0, ==, expected_label < 0);
+    if (expected_label < 0) continue;
+    if (mapping[expected_label] < 0) {
+      munit_assert_int(reverse_mapping[label], <, 0);
+      mapping[expected_label] = label, reverse_mapping[label] = expected_label;
+      munit_assert_int(actual->regions[label].fish, ==, expected->regions[expected_label].fish);
+      munit_assert_int(actual->regions[label].tiles, ==, expected->regions[expected_label].tiles);
+      for (int player_idx = 0; player_idx < expected->players_count; player_idx++) {
+        munit_assert_int(
+          region_map_penguins(actual, label, player_idx),
+          ==,
+          region_map_penguins(expected, expected_label, player_idx)
+        );
+      }
+    }
+    munit_assert_int(mapping[expected_label], ==, label);
+  }
+  free(mapping);
+  free(reverse_mapping);
+}
+
+static MunitResult test_region_map_is_incremental(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Game* game = game_new();
+  enum { WIDTH = 12, HEIGHT = 9 };
+  char board[WIDTH * HEIGHT + 1];
+  for (int i = 0; i < WIDTH * HEIGHT; i++) {
+    int x = i % WIDTH, y = i / WIDTH;
+    board[i] = (x * 5 + y * 3) % 7 == 0 ? '~' : (char)('1' + (x * y) % 3);
+  }
+  board[WIDTH * HEIGHT] = '\0';
+  board[1] = 'A', board[WIDTH * 4 + 6] = 'A', board[WIDTH * 8 + 2] = 'A';
+  board[WIDTH + 10] = 'B', board[WIDTH * 5 + 1] = 'B', board[WIDTH * 7 + 9] = 'B';
+  setup_test_game(game, /*players*/ 2, /*penguins*/ 3, WIDTH, HEIGHT, board);
+  movement_begin(game);
+  game_set_current_player(game, 0);
+
+  SearchPosition* position = search_position_new();
+  search_position_load(position, game);
+  RegionMap* regions = region_map_new();
+  region_map_load(regions, position, WIDTH * HEIGHT);
+  RegionMap* expected = region_map_new();
+  Junctions* junctions = junctions_new();
+  int prev_players[WIDTH * HEIGHT];
+  int steps_count = 0, splits_count = 0;
+  unsigned random = 12345;
+
+  // Play the game out with pseudo-random moves...
+  while (true) {
+    int player_idx = -1;
+    for (int i = 0; i < position->players_count && player_idx < 0; i++) {
+      int idx = (steps_count + i) % position->players_count;
+      if (search_position_player_can_move(position, idx)) player_idx = idx;
+    }
+    if (player_idx < 0) break;
+    const Coords* penguins = search_position_player_penguins(position, player_idx);
+    int moves_count = 0;
+    PossibleSteps moves[3];
+    for (int i = 0; i < position->penguins_counts[player_idx]; i++) {
+      moves[i] = calculate_penguin_possible_moves(game, penguins[i]);
+      for (int dir = 0; dir < DIRECTION_MAX; dir++) moves_count += moves[i].steps[dir];
+    }
+    random = random * 1103515245 + 12345;
+    int picked = (int)((random >> 16) % (unsigned)moves_count);
+    Coords start = { -1, -1 }, target = { -1, -1 };
+    for (int i = 0; i < position->penguins_counts[player_idx]; i++) {
+      for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+        if (picked >= 0 && picked < moves[i].steps[dir]) {
+          start = target = penguins[i];
+          target.x += DIRECTION_TO_COORDS[dir].x * (picked + 1);
+          target.y += DIRECTION_TO_COORDS[dir].y * (picked + 1);
+        }
+        picked -= moves[i].steps[dir];
+      }
+    }
+    // The split must be found exactly for the cut tiles of the position.
+    junctions_analyze(junctions, game);
+    bool is_cut_tile = junctions_is_cut_tile(junctions, target);
+    prev_players[steps_count] = game->current_player_index;
+    game_set_current_player(game, player_idx);
+    move_penguin(game, start, target);
+    search_position_make_move(position, start, target);
+    bool splits = region_map_move_penguin(regions, position, start, target);
+    munit_assert_int(splits, ==, is_cut_tile);
+    splits_count += splits;
+    steps_count++;
+    region_map_load(expected, position, 0);
+    assert_same_regions(regions, expected);
+  }
+  munit_assert_int(steps_count, >, 10);
+  munit_assert_int(splits_count, >, 0);
+
+  // ...and then back to the start.
+  while (steps_count > 0) {
+    steps_count--;
+    undo_move_penguin(game);
+    if (game->current_player_index != prev_players[steps_count]) {
+      game_undo_set_current_player(game);
+    }
+    search_position_unmake_move(position);
+    region_map_undo_move(regions);
+    region_map_load(expected, position, 0);
+    assert_same_regions(regions, expected);
+  }
+
+  junctions_free(junctions);
+  region_map_free(regions);
+  region_map_free(expected);
+  search_position_free(position);
+  game_free(game);
+  return MUNIT_OK;
+}
+
+// Labels the regions of the fish tiles connected by the sides with a plain
+// depth-first search, used as the reference for the junctions below.
+static int label_fish_regions(const Game* game, int* labels, int* region_fish) {
+  int w = game->board_width, h = game->board_height;
+  int* stack = malloc(sizeof(*stack) * w * h);
+  int regions_count = 0;
+  for (int i = 0; i < w * h; i++) labels[i] = -1;
+  for (int start = 0; start < w * h; start++) {
+    if (get_tile_fish(game->board_grid[start]) == 0 || labels[start] >= 0) continue;
+    int region = regions_count++;
+    region_fish[region] = 0;
+    int stack_len = 0;
+    stack[stack_len++] = start;
+    labels[start] = region;
+    while (stack_len > 0) {
+      int idx = stack[--stack_len];
+      region_fish[region] += get_tile_fish(game->board_grid[idx]);
+      for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+        Coords neighbor = DIRECTION_TO_COORDS[dir];
+        neighbor.x += idx % w, neighbor.y += idx / w;
+        if (!is_tile_in_bounds(game, neighbor)) continue;
+        int neighbor_idx = neighbor.x + neighbor.y * w;
+        if (get_tile_fish(game->board_grid[neighbor_idx]) == 0) continue;
+        if (labels[neighbor_idx] >= 0) continue;
+        labels[neighbor_idx] = region;
+        stack[stack_len++] = neighbor_idx;
+      }
+    }
+  }
+  free(stack);
+  return regions_count;
+}
+
+static MunitResult test_junctions_find_cut_tiles(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Game* game = game_new();
+  enum { WIDTH = 12, HEIGHT = 9 };
+  char board[WIDTH * HEIGHT + 1];
+  for (int i = 0; i < WIDTH * HEIGHT; i++) {
+    int x = i % WIDTH, y = i / WIDTH;
+    board[i] = (x * 5 + y * 3) % 4 == 0 ? '~' : (char)('1' + (x * y) % 3);
+  }
+  board[WIDTH * HEIGHT] = '\0';
+  board[WIDTH * 2 + 1] = 'A', board[WIDTH * 6 + 9] = 'B';
+  setup_test_game(game, /*players*/ 2, /*penguins*/ 1, WIDTH, HEIGHT, board);
+
+  Junctions* junctions = junctions_new();
+  junctions_analyze(junctions, game);
+  int* expected_labels = malloc(sizeof(*expected_labels) * WIDTH * HEIGHT);
+  int* expected_fish = malloc(sizeof(*expected_fish) * WIDTH * HEIGHT);
+  label_fish_regions(game, expected_labels, expected_fish);
+  int* labels_without_tile = malloc(sizeof(*labels_without_tile) * WIDTH * HEIGHT);
+  int* fish_without_tile = malloc(sizeof(*fish_without_tile) * WIDTH * HEIGHT);
+  int cut_tiles_count = 0;
+  for (int y = 0; y < HEIGHT; y++) {
+    for (int x = 0; x < WIDTH; x++) {
+      Coords coords = { x, y };
+      int region = junctions_region(junctions, coords);
+      int expected_region = expected_labels[x + y * WIDTH];
+      munit_assert_int(region < 0, ==, expected_region < 0);
+      if (region < 0) continue;
+      munit_assert_int(
+        junctions_region_fish(junctions, region), ==, expected_fish[expected_region]
+      );
+
+      // Check the cut tiles by brute force: remove the tile and see if its
+      // neighbors end up in different regions.
+      short tile = get_tile(game, coords);
+      set_tile(game, coords, WATER_TILE);
+      label_fish_regions(game, labels_without_tile, fish_without_tile);
+      bool splits = false;
+      int first_label = -1;
+      for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+        Coords neighbor = DIRECTION_TO_COORDS[dir];
+        neighbor.x += x, neighbor.y += y;
+        if (!is_tile_in_bounds(game, neighbor)) continue;
+        int label = labels_without_tile[neighbor.x + neighbor.y * WIDTH];
+        if (label < 0) continue;
+        if (first_label >= 0 && label != first_label) splits = true;
+        first_label = label;
+      }
+      set_tile(game, coords, tile);
+      munit_assert_int(junctions_is_cut_tile(junctions, coords), ==, splits);
+      cut_tiles_count += splits;
+    }
+  }
+  munit_assert_int(cut_tiles_count, >, 0);
+
+  free(expected_labels);
+  free(expected_fish);
+  free(labels_without_tile);
+  free(fish_without_tile);
+  junctions_free(junctions);
+  game_free(game);
+  return MUNIT_OK;
+}
+
+static void assert_same_placement_scores(BotState* bot) {
+  Game* game = bot->game;
+  Coords* tiles = malloc(sizeof(*tiles) * game->board_width * game->board_height);
+  int tiles_count = 0;
+  for (int y = 0; y < game->board_height; y++) {
+    for (int x = 0; x < game->board_width; x++) {
+      Coords coords = { x, y };
+      if (validate_placement_simple(game, coords)) tiles[tiles_count++] = coords;
+    }
+  }
+  munit_assert_int(tiles_count, >, 0);
+  bot_alloc_buf(bot->tile_scores, bot->tile_scores_cap, tiles_count);
+  munit_assert_true(bot_rate_all_placements(bot, tiles_count, tiles));
+  for (int i = 0; i < tiles_count; i++) {
+    munit_assert_int(bot->tile_scores[i], ==, bot_rate_placement(bot, tiles[i]));
+  }
+  free(tiles);
+}
+
+static MunitResult test_rate_all_placements(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Game* game = game_new();
+  enum { WIDTH = 13, HEIGHT = 9 };
+  char board[WIDTH * HEIGHT + 1];
+  for (int i = 0; i < WIDTH * HEIGHT; i++) {
+    int x = i % WIDTH, y = i / WIDTH;
+    board[i] = (x * 5 + y * 3) % 7 == 0 ? '~' : (char)('1' + (x * y + x) % 4);
+  }
+  board[WIDTH * HEIGHT] = '\0';
+  board[WIDTH + 2] = 'A', board[WIDTH * 6 + 9] = 'B', board[WIDTH * 8 + 12] = 'B';
+  setup_test_game(game, /*players*/ 2, /*penguins*/ 2, WIDTH, HEIGHT, board);
+  game_set_current_player(game, 0);
+
+  BotParameters bot_params;
+  init_bot_parameters(&bot_params);
+  Rng rng = init_random_rng();
+  BotState* bot = bot_state_new(&bot_params, game, &rng);
+  BotPlacementStrategy strategies[] = { BOT_PLACEMENT_SMART, BOT_PLACEMENT_MOST_FISH };
+  for (int i = 0; i < 2; i++) {
+    bot_params.placement_strategy = strategies[i];
+    for (int area = 0; area <= 10; area++) {
+      bot->placement_scan_area = area;
+      assert_same_placement_scores(bot);
+    }
+  }
+
+  // The scores are kept between the calls and updated as the board changes.
+  bot_params.placement_strategy = BOT_PLACEMENT_SMART;
+  bot_params.placement_scan_area = bot->placement_scan_area = 3;
+  for (int turn = 0; turn < 6; turn++) {
+    Coords target;
+    munit_assert_true(bot_compute_placement(bot, &target));
+    set_tile(game, target, PENGUIN_TILE(game_get_player(game, turn % 2)->id));
+    assert_same_placement_scores(bot);
+    munit_assert_int(bot->placement_scores_area, ==, 3);
+  }
+  // This changes the kinds of all penguin tiles.
+  game_set_current_player(game, 1);
+  assert_same_placement_scores(bot);
+
+  bot_state_free(bot);
+  game_free(game);
+  return MUNIT_OK;
+}
+
+static MunitResult test_placement_book_merge(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  // The new entries come first, then the old ones with the same keys.
+  enum { NEW_COUNT = 50, COUNT = NEW_COUNT * 3 };
+  PlacementBookEntry entries[COUNT];
+  for (int i = 0; i < COUNT; i++) {
+    entries[i].key = (uint64_t)(i % NEW_COUNT) * 7919;
+    entries[i].x = i / NEW_COUNT, entries[i].y = i;
+  }
+  size_t count = placement_book_sort_entries(entries, COUNT);
+  munit_assert_size(count, ==, NEW_COUNT);
+  for (size_t i = 0; i < count; i++) {
+    if (i > 0) munit_assert_uint64(entries[i - 1].key, <, entries[i].key);
+    munit_assert_int(entries[i].x, ==, 0);
+    munit_assert_uint64(entries[i].key, ==, (uint64_t)entries[i].y * 7919);
+  }
+  return MUNIT_OK;
+}
+
+static MunitResult test_placement_book(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  enum { WIDTH = 11, HEIGHT = 7 };
+  // The second board is the first one rotated clockwise.
+  char board[WIDTH * HEIGHT + 1], rotated_board[WIDTH * HEIGHT + 1];
+  for (int i = 0; i < WIDTH * HEIGHT; i++) {
+    int x = i % WIDTH, y = i / WIDTH;
+    char tile = (x * 3 + y * 5) % 8 == 0 ? '~' : (char)('1' + (x * y + y) % 3);
+    board[i] = tile;
+    rotated_board[(HEIGHT - 1 - y) + HEIGHT * x] = tile;
+  }
+  board[WIDTH * HEIGHT] = rotated_board[WIDTH * HEIGHT] = '\0';
+  Game* game = game_new();
+  setup_test_game(game, /*players*/ 2, /*penguins*/ 2, WIDTH, HEIGHT, board);
+  Game* rotated_game = game_new();
+  setup_test_game(rotated_game, /*players*/ 2, /*penguins*/ 2, HEIGHT, WIDTH, rotated_board);
+  BotParameters bot_params;
+  init_bot_parameters(&bot_params);
+  bot_params.placement_scan_area = 3;
+
+  PlacementBookEntry* entries;
+  size_t count = placement_book_build(&game, 1, &bot_params, 2, &entries);
+  munit_assert_size(count, ==, 4);
+  const char* path = "test-placement-book.bin";
+  munit_assert_true(placement_book_write(path, entries, count));
+  free(entries);
+  PlacementBook* book = placement_book_open(path);
+  munit_assert_not_null(book);
+  munit_assert_size(book->entries_count, ==, count);
+
+  Rng rng = init_random_rng();
+  BotState* bot = bot_state_new(&bot_params, game, &rng);
+  placement_begin(game);
+  placement_begin(rotated_game);
+  while (placement_switch_player(game) >= 0) {
+    munit_assert_int(placement_switch_player(rotated_game), >=, 0);
+    uint64_t key = placement_book_key(game, &bot_params, NULL);
+    munit_assert_uint64(key, ==, placement_book_key(rotated_game, &bot_params, NULL));
+    Coords expected, target, rotated_target;
+    munit_assert_true(bot_compute_placement(bot, &expected));
+    munit_assert_true(placement_book_lookup(book, game, &bot_params, &target));
+    munit_assert_int(target.x, ==, expected.x);
+    munit_assert_int(target.y, ==, expected.y);
+    munit_assert_true(placement_book_lookup(book, rotated_game, &bot_params, &rotated_target));
+    munit_assert_int(rotated_target.x, ==, HEIGHT - 1 - expected.y);
+    munit_assert_int(rotated_target.y, ==, expected.x);
+
+    // The placements chosen with other parameters can't be taken from the book.
+    BotParameters other_params = bot_params;
+    other_params.placement_scan_area = 4;
+    munit_assert_false(placement_book_lookup(book, game, &other_params, &target));
+
+    place_penguin(game, expected);
+    place_penguin(rotated_game, rotated_target);
+  }
+
+  bot_state_free(bot);
+  placement_book_free(book);
+  remove(path);
+  game_free(game);
+  game_free(rotated_game);
+  return MUNIT_OK;
+}
+
+static MunitResult test_zobrist_key_is_incremental(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Game* game = game_new();
+  const char* board = "1A2~"
+                      "3~1B"
+                      "2132";
+  setup_test_game(game, /*players*/ 2, /*penguins*/ 2, /*width*/ 4, /*height*/ 3, board);
+  munit_assert_uint64(game->zobrist_key, ==, game_compute_zobrist_key(game));
+  uint64_t initial_key = game->zobrist_key;
+
+  placement_begin(game);
+  game_set_current_player(game, 0);
+  munit_assert_uint64(game->zobrist_key, !=, initial_key);
+  place_penguin(game, (Coords){ 1, 2 });
+  munit_assert_uint64(game->zobrist_key, ==, game_compute_zobrist_key(game));
+  undo_place_penguin(game);
+  game_set_current_player(game, 1);
+  place_penguin(game, (Coords){ 2, 1 });
+  placement_end(game);
+
+  movement_begin(game);
+  game_set_current_player(game, 0);
+  uint64_t before_move_key = game->zobrist_key;
+  move_penguin(game, (Coords){ 1, 0 }, (Coords){ 0, 0 });
+  munit_assert_uint64(game->zobrist_key, ==, game_compute_zobrist_key(game));
+  munit_assert_uint64(game->zobrist_key, !=, before_move_key);
+  undo_move_penguin(game);
+  munit_assert_uint64(game->zobrist_key, ==, before_move_key);
+
+  game_rewind_state_to_log_entry(game, 0);
+  munit_assert_uint64(game->zobrist_key, ==, game_compute_zobrist_key(game));
+  game_free(game);
+  return MUNIT_OK;
+}
+
+// Checks the #Game::tile_rays by walking the board tile by tile.
+static void assert_tile_rays_are_correct(const Game* game) {
+  for (int y = 0; y < game->board_height; y++) {
+    for (int x = 0; x < game->board_width; x++) {
+      Coords coords = { x, y };
+      const short* rays = get_tile_rays(game, coords);
+      for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+        Coords d = DIRECTION_TO_COORDS[dir], target = coords;
+        int expected = 0;
+        while (true) {
+          target.x += d.x, target.y += d.y;
+          if (!(is_tile_in_bounds(game, target) && is_fish_tile(get_tile(game, target)))) break;
+          expected++;
+        }
+        munit_assert_int(rays[dir], ==, expected);
+      }
+    }
+  }
+}
+
+static MunitResult test_tile_rays_are_incremental(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Game* game = game_new();
+  const char* board = "1A21~3"
+                      "3~1B12"
+                      "213223"
+                      "1~3121";
+  setup_test_game(game, /*players*/ 2, /*penguins*/ 2, /*width*/ 6, /*height*/ 4, board);
+  assert_tile_rays_are_correct(game);
+
+  placement_begin(game);
+  game_set_current_player(game, 0);
+  place_penguin(game, (Coords){ 0, 3 });
+  assert_tile_rays_are_correct(game);
+  game_set_current_player(game, 1);
+  place_penguin(game, (Coords){ 5, 3 });
+  assert_tile_rays_are_correct(game);
+  placement_end(game);
+
+  movement_begin(game);
+  game_set_current_player(game, 0);
+  move_penguin(game, (Coords){ 0, 3 }, (Coords){ 0, 1 });
+  assert_tile_rays_are_correct(game);
+  game_set_current_player(game, 1);
+  move_penguin(game, (Coords){ 5, 3 }, (Coords){ 2, 3 });
+  assert_tile_rays_are_correct(game);
+  Game* clone = game_clone(game);
+  assert_tile_rays_are_correct(clone);
+  undo_move_penguin(game);
+  assert_tile_rays_are_correct(game);
+
+  game_rewind_state_to_log_entry(game, 0);
+  assert_tile_rays_are_correct(game);
+  game_free(clone);
+  game_free(game);
+  return MUNIT_OK;
+}
+
+// Checks #Game::placeable_tiles_count and #Player::mobile_penguins_count by
+// scanning the board and the penguins.
+static void assert_turn_counters_are_correct(const Game* game) {
+  int placeable_tiles = 0;
+  for (int y = 0; y < game->board_height; y++) {
+    for (int x = 0; x < game->board_width; x++) {
+      placeable_tiles += validate_placement_simple(game, (Coords){ x, y });
+    }
+  }
+  munit_assert_int(game->placeable_tiles_count, ==, placeable_tiles);
+  for (int i = 0; i < game->players_count; i++) {
+    const Player* player = game_get_player(game, i);
+    int mobile_penguins = 0;
+    for (int j = 0; j < player->penguins_count; j++) {
+      PossibleSteps steps = calculate_penguin_possible_moves(game, player->penguins[j]);
+      bool mobile = false;
+      for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+        if (steps.steps[dir] != 0) mobile = true;
+      }
+      mobile_penguins += mobile;
+    }
+    munit_assert_int(player->mobile_penguins_count, ==, mobile_penguins);
+  }
+}
+
+static MunitResult test_turn_counters_are_incremental(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Game* game = game_new();
+  const char* board = "B1~2"
+                      "~1~3"
+                      "121A"
+                      "~~3~";
+  setup_test_game(game, /*players*/ 2, /*penguins*/ 3, /*width*/ 4, /*height*/ 4, board);
+  assert_turn_counters_are_correct(game);
+  munit_assert_int(game->placeable_tiles_count, ==, 4);
+  munit_assert_true(any_valid_player_move_exists(game, 0));
+  munit_assert_true(any_valid_player_move_exists(game, 1));
+
+  placement_begin(game);
+  munit_assert_int(placement_switch_player(game), ==, 0);
+  place_penguin(game, (Coords){ 1, 0 });
+  assert_turn_counters_are_correct(game);
+  // The second penguin of B got stuck.
+  munit_assert_int(game_get_player(game, 1)->mobile_penguins_count, ==, 0);
+  munit_assert_int(placement_switch_player(game), ==, 1);
+  place_penguin(game, (Coords){ 1, 1 });
+  assert_turn_counters_are_correct(game);
+  munit_assert_int(placement_switch_player(game), ==, 0);
+  place_penguin(game, (Coords){ 0, 2 });
+  assert_turn_counters_are_correct(game);
+  munit_assert_int(game->placeable_tiles_count, ==, 1);
+  undo_place_penguin(game);
+  assert_turn_counters_are_correct(game);
+  place_penguin(game, (Coords){ 2, 2 });
+  assert_turn_counters_are_correct(game);
+  munit_assert_int(placement_switch_player(game), ==, 1);
+  place_penguin(game, (Coords){ 0, 2 });
+  assert_turn_counters_are_correct(game);
+  munit_assert_int(game->placeable_tiles_count, ==, 0);
+  munit_assert_int(placement_switch_player(game), ==, PLACEMENT_NO_MORE_FREE_TILES);
+  placement_end(game);
+
+  movement_begin(game);
+  munit_assert_int(movement_switch_player(game), ==, 0);
+  move_penguin(game, (Coords){ 2, 2 }, (Coords){ 2, 3 });
+  assert_turn_counters_are_correct(game);
+  munit_assert_int(movement_switch_player(game), ==, 1);
+  move_penguin(game, (Coords){ 1, 1 }, (Coords){ 1, 2 });
+  assert_turn_counters_are_correct(game);
+  undo_move_penguin(game);
+  assert_turn_counters_are_correct(game);
+
+  game_rewind_state_to_log_entry(game, 0);
+  assert_turn_counters_are_correct(game);
+  Game* clone = game_clone(game);
+  assert_turn_counters_are_correct(clone);
+  game_free(clone);
+  game_free(game);
+  return MUNIT_OK;
+}
+
+static MunitResult test_search_position(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Game* game = game_new();
+  setup_test_game(
+    game,
+    /*players*/ 3,
+    /*penguins*/ 2,
+    /*width*/ 8,
+    /*height*/ 6,
+    "A1231213"
+    "21322B11"
+    "1312C232"
+    "31B12131"
+    "1C12131A"
+    "22131213"
+  );
+  movement_begin(game);
+  game_set_current_player(game, 0);
+  Game* initial = game_clone(game);
+  Game* copy = game_clone(game);
+  SearchPosition* position = search_position_new();
+  search_position_load(position, game);
+  munit_assert_uint64(position->zobrist_key, ==, game->zobrist_key);
+
+  // The game is played out on both, with the moves picked deterministically.
+  int moves_count = 0;
+  while (true) {
+    const Player* player = game_get_current_player(game);
+    BotMove move = { { -1, -1 }, { -1, -1 } };
+    for (int i = 0; i < player->penguins_count && move.penguin.x < 0; i++) {
+      PossibleSteps steps = calculate_penguin_possible_moves(game, player->penguins[i]);
+      for (int dir = 0; dir < DIRECTION_MAX; dir++) {
+        int dir_steps = steps.steps[(dir + moves_count) % DIRECTION_MAX];
+        if (dir_steps == 0) continue;
+        Coords d = DIRECTION_TO_COORDS[(dir + moves_count) % DIRECTION_MAX];
+        int n = moves_count % dir_steps + 1;
+        move.penguin = player->penguins[i];
+        move.target = (Coords){ move.penguin.x + d.x * n, move.penguin.y + d.y * n };
+        break;
+      }
+    }
+    munit_assert_int(move.penguin.x, >=, 0);
+    move_penguin(game, move.penguin, move.target);
+    search_position_make_move(position, move.penguin, move.target);
+    moves_count++;
+    int next_player = movement_switch_player(game);
+    munit_assert_int(search_position_switch_player(position), ==, next_player);
+    munit_assert_uint64(position->zobrist_key, ==, game->zobrist_key);
+    munit_assert_memory_equal(sizeof(short) * 8 * 6, position->grid, game->board_grid);
+    for (int i = 0; i < game->players_count; i++) {
+      const Player* player = game_get_player(game, i);
+      munit_assert_int(position->points[i], ==, player->points);
+      munit_assert_int(position->mobile_penguins_counts[i], ==, player->mobile_penguins_count);
+    }
+    if (next_player < 0) break;
+  }
+  munit_assert_int(moves_count, >, 5);
+
+  search_position_store(position, copy);
+  munit_assert_uint64(copy->zobrist_key, ==, game->zobrist_key);
+  munit_assert_memory_equal(sizeof(short) * 8 * 6, copy->board_grid, game->board_grid);
+  for (int i = 0; i < game->players_count; i++) {
+    const Player *expected = game_get_player(game, i), *actual = game_get_player(copy, i);
+    munit_assert_int(actual->points, ==, expected->points);
+    munit_assert_memory_equal(
+      sizeof(Coords) * expected->penguins_count, actual->penguins, expected->penguins
+    );
+  }
+
+  // And everything is undone, including the changes of the current player.
+  while (moves_count-- > 0) {
+    search_position_unmake_move(position);
+  }
+  munit_assert_uint64(position->zobrist_key, ==, initial->zobrist_key);
+  munit_assert_int(position->current_player_index, ==, initial->current_player_index);
+  munit_assert_memory_equal(sizeof(short) * 8 * 6, position->grid, initial->board_grid);
+  for (int i = 0; i < initial->players_count; i++) {
+    const Player* player = game_get_player(initial, i);
+    munit_assert_int(position->points[i], ==, player->points);
+    munit_assert_int(position->mobile_penguins_counts[i], ==, player->mobile_penguins_count);
+    munit_assert_memory_equal(
+      sizeof(Coords) * player->penguins_count,
+      search_position_player_penguins(position, i),
+      player->penguins
+    );
+  }
+  game_free(initial);
+  game_free(copy);
+  game_free(game);
+  search_position_free(position);
+  return MUNIT_OK;
+}
+
+static MunitResult test_transposition_table_replacement(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  TranspositionTable* table = transposition_table_new(100);
+  munit_assert_size(transposition_table_size(table), ==, 64);
+  uint64_t key1 = 5, key2 = 5 + 64 * 3; // Both land in the same slot
+  int score = 0;
+  munit_assert_false(transposition_table_probe(table, key1, &score));
+
+  transposition_table_store(table, key1, /*depth*/ 3, /*score*/ 42);
+  munit_assert_true(transposition_table_probe(table, key1, &score));
+  munit_assert_int(score, ==, 42);
+  // A shallower entry doesn't replace a deeper one...
+  transposition_table_store(table, key2, /*depth*/ 1, /*score*/ 7);
+  munit_assert_false(transposition_table_probe(table, key2, &score));
+  // ...unless the deeper one is from an older search.
+  transposition_table_next_generation(table);
+  munit_assert_true(transposition_table_probe(table, key1, &score));
+  transposition_table_store(table, key2, /*depth*/ 1, /*score*/ 7);
+  munit_assert_true(transposition_table_probe(table, key2, &score));
+  munit_assert_int(score, ==, 7);
+  munit_assert_false(transposition_table_probe(table, key1, &score));
+
+  transposition_table_free(table);
+  return MUNIT_OK;
+}
+
+static MunitResult test_adversarial_search(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Game* game = game_new();
+  const char* board = "3A1~B1"
+                      "1~1~12";
+  setup_test_game(game, /*players*/ 2, /*penguins*/ 1, /*width*/ 6, /*height*/ 2, board);
+  movement_begin(game);
+  game_set_current_player(game, 0);
+  uint64_t key = game->zobrist_key;
+  size_t log_current = game->log_current;
+
+  BotParameters bot_params;
+  init_bot_parameters(&bot_params);
+  bot_params.movement_strategy = BOT_MOVEMENT_ADVERSARIAL;
+  Rng rng = init_random_rng();
+  BotState* bot = bot_state_new(&bot_params, game, &rng);
+  BotAdversarialMode modes[] = {
+    BOT_ADVERSARIAL_PARANOID, BOT_ADVERSARIAL_MAX_N, BOT_ADVERSARIAL_BEST_REPLY
+  };
+  for (int i = 0; i < 3; i++) {
+    bot_params.adversarial_mode = modes[i];
+    Coords penguin, target;
+    munit_assert_true(bot_compute_move(bot, &penguin, &target));
+    munit_assert_int(target.x, ==, 0);
+    munit_assert_int(target.y, ==, 0);
+    // The game must be returned to the original state.
+    munit_assert_uint64(game->zobrist_key, ==, key);
+    munit_assert_size(game->log_current, ==, log_current);
+    munit_assert_int(game->current_player_index, ==, 0);
+  }
+  bot_state_free(bot);
+  game_free(game);
+  return MUNIT_OK;
+}
+
+// Creates a board which is far too large to be searched exhaustively, with the
+// movement phase started.
+static Game* setup_huge_test_game(void) {
+  Game* game = game_new();
+  char board[16 * 16 + 1];
+  for (int i = 0; i < 16 * 16; i++) {
+    board[i] = (char)('1' + i % 3);
+  }
+  board[16 * 16] = '\0';
+  board[3 + 3 * 16] = 'A', board[12 + 12 * 16] = 'A';
+  board[12 + 3 * 16] = 'B', board[3 + 12 * 16] = 'B';
+  setup_test_game(game, /*players*/ 2, /*penguins*/ 2, /*width*/ 16, /*height*/ 16, board);
+  movement_begin(game);
+  game_set_current_player(game, 0);
+  return game;
+}
+
+static MunitResult test_bot_time_limit(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Game* game = setup_huge_test_game();
+  uint64_t key = game->zobrist_key;
+
+  BotParameters bot_params;
+  init_bot_parameters(&bot_params);
+  bot_params.time_limit_ms = 20;
+  bot_params.recursion_limit = 1000;
+  bot_params.search_depth = 1000;
+  Rng rng = init_random_rng();
+  BotState* bot = bot_state_new(&bot_params, game, &rng);
+  BotMovementStrategy strategies[] = { BOT_MOVEMENT_SMART, BOT_MOVEMENT_ADVERSARIAL };
+  for (int i = 0; i < 2; i++) {
+    bot_params.movement_strategy = strategies[i];
+    uint64_t start_time = get_monotonic_time_ms();
+    Coords penguin, target;
+    munit_assert_true(bot_compute_move(bot, &penguin, &target));
+    // Some slack is left for slow machines.
+    munit_assert_uint64(get_monotonic_time_ms() - start_time, <, 1000);
+    munit_assert_int(validate_movement(game, penguin, target, NULL), ==, MOVEMENT_VALID);
+    munit_assert_uint64(game->zobrist_key, ==, key);
+  }
+  bot_state_free(bot);
+  game_free(game);
+  return MUNIT_OK;
+}
+
+typedef struct TestBotCanceller {
+  Thread thread;
+  BotState* bot;
+  uint64_t cancel_time;
+} TestBotCanceller;
+
+static void test_cancel_bot_later(void* arg) {
+  TestBotCanceller* self = arg;
+  while (get_monotonic_time_ms() < self->cancel_time) {
+    // Spin until the time comes.
+  }
+  bot_cancel(self->bot);
+}
+
+static MunitResult test_bot_cancellation(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Game* game = setup_huge_test_game();
+  uint64_t key = game->zobrist_key;
+
+  BotParameters bot_params;
+  init_bot_parameters(&bot_params);
+  // Without a time limit every strategy would run for ages, even the very
+  // first move at the root can't be evaluated to the end.
+  bot_params.recursion_limit = 1000;
+  bot_params.search_depth = 1000;
+  bot_params.mcts_iterations = 100000000;
+  bot_params.threads_count = 2;
+  Rng rng = init_random_rng();
+  BotMovementStrategy strategies[] = {
+    BOT_MOVEMENT_SMART,
+    BOT_MOVEMENT_ADVERSARIAL,
+    BOT_MOVEMENT_MCTS,
+  };
+  for (int i = 0; i < 3; i++) {
+    bot_params.movement_strategy = strategies[i];
+    BotState* bot = bot_state_new(&bot_params, game, &rng);
+    TestBotCanceller canceller;
+    canceller.bot = bot;
+    canceller.cancel_time = get_monotonic_time_ms() + 20;
+    munit_assert_true(thread_spawn(&canceller.thread, &test_cancel_bot_later, &canceller));
+    Coords penguin, target;
+    munit_assert_false(bot_compute_move(bot, &penguin, &target));
+    // Some slack is left for slow machines.
+    munit_assert_uint64(get_monotonic_time_ms() - canceller.cancel_time, <, 1000);
+    thread_join(&canceller.thread);
+    munit_assert_uint64(game->zobrist_key, ==, key);
+    bot_state_free(bot);
+  }
+
+  // The deadline is noticed deep in the recursion as well, not just between
+  // the moves at the root. A shallow search prepares the state of the bot.
+  bot_params.movement_strategy = BOT_MOVEMENT_SMART;
+  bot_params.threads_count = 1;
+  bot_params.recursion_limit = 1;
+  // Otherwise the move would be found in the table.
+  bot_params.transposition_table_size = 0;
+  BotState* bot = bot_state_new(&bot_params, game, &rng);
+  Coords penguin, target;
+  munit_assert_true(bot_compute_move(bot, &penguin, &target));
+  bot->recursion_limit = 1000;
+  uint64_t deadline = get_monotonic_time_ms() + 20;
+  bot->stop->deadline = deadline;
+  BotMove move = { { 3, 3 }, { 3, 4 } };
+  bot_rate_move(bot, move);
+  munit_assert_uint64(get_monotonic_time_ms() - deadline, <, 1000);
+  munit_assert_true(bot->stop->timed_out);
+  munit_assert_uint64(game->zobrist_key, ==, key);
+  bot_state_free(bot);
+
+  game_free(game);
+  return MUNIT_OK;
+}
+
+static MunitResult test_bot_search_stack(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+#ifdef NDEBUG
+  // The allocations are counted only in the debug builds.
+  return MUNIT_SKIP;
+#else
+  BotParameters bot_params;
+  init_bot_parameters(&bot_params);
+  bot_params.search_depth = 4;
+  bot_params.mcts_iterations = 2000;
+  Rng rng = init_random_rng();
+  BotMovementStrategy strategies[] = {
+    BOT_MOVEMENT_SMART,
+    BOT_MOVEMENT_ADVERSARIAL,
+    BOT_MOVEMENT_MCTS,
+  };
+  // The workers of the parallel search must not allocate anything on the
+  // following turns either.
+  int threads_counts[] = { 1, 3 };
+  for (int i = 0; i < 6; i++) {
+    bot_params.movement_strategy = strategies[i % 3];
+    bot_params.threads_count = threads_counts[i / 3];
+    Game* game = game_new();
+    setup_test_game(
+      game,
+      /*players*/ 2,
+      /*penguins*/ 2,
+      /*width*/ 8,
+      /*height*/ 6,
+      "A1231213"
+      "21322B11"
+      "13121232"
+      "31B12131"
+      "1212131A"
+      "22131213"
+    );
+    movement_begin(game);
+    BotState* bot = bot_state_new(&bot_params, game, &rng);
+    game_set_current_player(game, 0);
+    Coords penguin, target;
+    munit_assert_true(bot_compute_move(bot, &penguin, &target));
+    munit_assert_not_null(bot->search_stack);
+    // Every level of the recursion is a frame of the arena, the MCTS has none.
+    int depth = 0;
+    for (BotState* sub = bot->substate; sub != NULL; sub = sub->substate) {
+      munit_assert_true(sub->in_search_stack);
+      munit_assert_int(sub->depth, ==, ++depth);
+    }
+    munit_assert_int(depth, ==, bot->search_stack->frames_count);
+
+    // Once the stack has been prepared, the following turns are computed
+    // without any allocations, even though the positions are different.
+    move_penguin(game, penguin, target);
+    int64_t allocations = bot_debug_allocations;
+    for (int player = 1; player >= 0; player--) {
+      game_set_current_player(game, player);
+      munit_assert_true(bot_compute_move(bot, &penguin, &target));
+    }
+    munit_assert_int64(bot_debug_allocations, ==, allocations);
+    bot_state_free(bot);
+    game_free(game);
+  }
+  return MUNIT_OK;
+#endif
+}
+
+static MunitResult test_bot_threads(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Game* game = game_new();
+  const char* board = "1A2311"
+                      "~32~1B"
+                      "2121~3"
+                      "B13A21";
+  setup_test_game(game, /*players*/ 2, /*penguins*/ 2, /*width*/ 6, /*height*/ 4, board);
+  movement_begin(game);
+  game_set_current_player(game, 0);
+
+  BotParameters bot_params;
+  init_bot_parameters(&bot_params);
+  Rng rng = init_random_rng();
+  Coords expected_penguin, expected_target;
+  BotState* bot = bot_state_new(&bot_params, game, &rng);
+  munit_assert_true(bot_compute_move(bot, &expected_penguin, &expected_target));
+  bot_state_free(bot);
+
+  // The chosen move must not depend on the number of threads.
+  for (int threads = 2; threads <= 4; threads++) {
+    bot_params.threads_count = threads;
+    bot = bot_state_new(&bot_params, game, &rng);
+    Coords penguin, target;
+    munit_assert_true(bot_compute_move(bot, &penguin, &target));
+    munit_assert_true(coords_same(penguin, expected_penguin));
+    munit_assert_true(coords_same(target, expected_target));
+    bot_state_free(bot);
+  }
+  game_free(game);
+  return MUNIT_OK;
+}
+
+// Computes the turn of the current player the way the GUI does it: the bot is
+// kept for the whole game, but gets a fresh copy of the game every turn.
+static bool compute_turn_with_copy(BotState* bot, Game** copy, const Game* game, BotMove* move) {
+  game_free(*copy);
+  *copy = game_clone(game);
+  bot_state_set_game(bot, *copy);
+  if (game->phase == GAME_PHASE_PLACEMENT) {
+    return bot_compute_placement(bot, &move->target);
+  } else {
+    return bot_compute_move(bot, &move->penguin, &move->target);
+  }
+}
+
+static MunitResult test_bot_state_reuse(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  char board[8 * 8 + 1];
+  for (int i = 0; i < 8 * 8; i++) {
+    board[i] = (char)('1' + i % 3);
+  }
+  board[8 * 8] = '\0';
+
+  BotParameters bot_params;
+  init_bot_parameters(&bot_params);
+  bot_params.recursion_limit = 2;
+  bot_params.threads_count = 1;
+  size_t table_size = bot_params.transposition_table_size;
+  for (int pass = 0; pass < 2; pass++) {
+    // Without the table, the reused bots must play exactly like fresh ones.
+    bool compare = pass == 0;
+    bot_params.transposition_table_size = compare ? 0 : table_size;
+    Game* game = game_new();
+    setup_test_game(game, /*players*/ 2, /*penguins*/ 2, /*width*/ 8, /*height*/ 8, board);
+    Rng rng = init_rng(42), fresh_rng = init_rng(42);
+    Game* copies[2] = { game_clone(game), game_clone(game) };
+    BotState* bots[2];
+    for (int i = 0; i < 2; i++) {
+      bots[i] = bot_state_new(&bot_params, copies[i], &rng);
+    }
+    // The tables are created on the first move of the bots.
+    TranspositionTable* tables[2] = { NULL, NULL };
+
+    placement_begin(game);
+    int turns = 0;
+    while (true) {
+      if (game->phase == GAME_PHASE_PLACEMENT && placement_switch_player(game) < 0) {
+        placement_end(game);
+        movement_begin(game);
+      }
+      if (game->phase == GAME_PHASE_MOVEMENT && movement_switch_player(game) < 0) break;
+      BotState* bot = bots[game->current_player_index];
+      BotMove move = { { -1, -1 }, { -1, -1 } };
+      Game** copy = &copies[game->current_player_index];
+      munit_assert_true(compute_turn_with_copy(bot, copy, game, &move));
+      if (game->phase == GAME_PHASE_MOVEMENT) {
+        TranspositionTable** table = &tables[game->current_player_index];
+        if (*table == NULL) *table = bot->transposition_table;
+        // The caches survive between the turns.
+        munit_assert_true(bot->transposition_table == *table);
+      }
+      if (compare) {
+        Game* fresh_copy = NULL;
+        BotState* fresh_bot = bot_state_new(&bot_params, game, &fresh_rng);
+        BotMove fresh_move = { { -1, -1 }, { -1, -1 } };
+        munit_assert_true(compute_turn_with_copy(fresh_bot, &fresh_copy, game, &fresh_move));
+        munit_assert_true(coords_same(move.target, fresh_move.target));
+        munit_assert_true(coords_same(move.penguin, fresh_move.penguin));
+        bot_state_free(fresh_bot);
+        game_free(fresh_copy);
+      }
+      if (game->phase == GAME_PHASE_PLACEMENT) {
+        munit_assert_int(validate_placement(game, move.target), ==, PLACEMENT_VALID);
+        place_penguin(game, move.target);
+      } else {
+        munit_assert_int(
+          validate_movement(game, move.penguin, move.target, NULL), ==, MOVEMENT_VALID
+        );
+        move_penguin(game, move.penguin, move.target);
+      }
+      turns++;
+    }
+    movement_end(game);
+    munit_assert_int(turns, >, 2 * 2);
+    for (int i = 0; i < 2; i++) {
+      munit_assert_true(compare == (tables[i] == NULL));
+      bot_state_free(bots[i]);
+      game_free(copies[i]);
+    }
+    game_free(game);
+  }
+  return MUNIT_OK;
+}
+
+static MunitResult test_mcts_search(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Game* game = game_new();
+  const char* board = "1A2311"
+                      "~32~1B"
+                      "2121~3"
+                      "B13A21";
+  setup_test_game(game, /*players*/ 2, /*penguins*/ 2, /*width*/ 6, /*height*/ 4, board);
+  movement_begin(game);
+  game_set_current_player(game, 0);
+  uint64_t key = game->zobrist_key;
+  size_t log_current = game->log_current;
+
+  BotParameters bot_params;
+  init_bot_parameters(&bot_params);
+  bot_params.movement_strategy = BOT_MOVEMENT_MCTS;
+  bot_params.mcts_iterations = 2000;
+  Rng rng = init_random_rng();
+  for (int threads = 1; threads <= 3; threads += 2) {
+    bot_params.threads_count = threads;
+    BotState* bot = bot_state_new(&bot_params, game, &rng);
+    Coords penguin, target;
+    munit_assert_true(bot_compute_move(bot, &penguin, &target));
+    munit_assert_int(validate_movement(game, penguin, target, NULL), ==, MOVEMENT_VALID);
+    // All playouts must have been undone.
+    munit_assert_uint64(game->zobrist_key, ==, key);
+    munit_assert_size(game->log_current, ==, log_current);
+    munit_assert_int(game->current_player_index, ==, 0);
+    bot_state_free(bot);
+  }
+  game_free(game);
+  return MUNIT_OK;
+}
+
+static MunitResult test_mcts_single_move(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Game* game = game_new();
+  // The only move of A is to the right, and the tree is mostly a chain of
+  // nodes with one or two moves, which the threads are racing to expand.
+  const char* board = "A1~3"
+                      "~22~"
+                      "B~13"
+                      "2~~2";
+  setup_test_game(game, /*players*/ 2, /*penguins*/ 1, /*width*/ 4, /*height*/ 4, board);
+  movement_begin(game);
+  game_set_current_player(game, 0);
+
+  BotParameters bot_params;
+  init_bot_parameters(&bot_params);
+  bot_params.movement_strategy = BOT_MOVEMENT_MCTS;
+  bot_params.mcts_iterations = 20000;
+  bot_params.endgame_tile_limit = 0;
+  bot_params.threads_count = 8;
+  Rng rng = init_random_rng();
+  BotState* bot = bot_state_new(&bot_params, game, &rng);
+  for (int i = 0; i < 5; i++) {
+    Coords penguin, target;
+    munit_assert_true(bot_compute_move(bot, &penguin, &target));
+    munit_assert_true(coords_same(penguin, (Coords){ 0, 0 }));
+    munit_assert_int(validate_movement(game, penguin, target, NULL), ==, MOVEMENT_VALID);
+  }
+  bot_state_free(bot);
+  game_free(game);
+  return MUNIT_OK;
+}
+
+static MunitResult test_endgame_solver(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Game* game = game_new();
+  // Jumping straight to the 3 gives less fish than collecting the 1s first.
+  const char* board = "A1113~"
+                      "~~~1~~"
+                      "~~~~~B";
+  setup_test_game(game, /*players*/ 2, /*penguins*/ 1, /*width*/ 6, /*height*/ 3, board);
+  movement_begin(game);
+  game_set_current_player(game, 0);
+
+  BotParameters bot_params;
+  init_bot_parameters(&bot_params);
+  Rng rng = init_random_rng();
+  BotState* bot = bot_state_new(&bot_params, game, &rng);
+  // The solver relies on the bitboard loaded by bot_compute_move.
+  bot->bitboard = bitboard_new();
+  bitboard_load_game(bot->bitboard, game);
+  Coords penguin, target;
+  munit_assert_true(bot_solve_endgame(bot, &penguin, &target));
+  munit_assert_true(coords_same(penguin, (Coords){ 0, 0 }));
+  munit_assert_true(coords_same(target, (Coords){ 1, 0 }));
+
+  // Once an opponent can reach the region, it isn't solvable anymore.
+  set_tile(game, (Coords){ 5, 2 }, WATER_TILE);
+  set_tile(game, (Coords){ 5, 0 }, PENGUIN_TILE(game_get_player(game, 1)->id));
+  game_move_player_penguin(game, 1, game_get_player(game, 1)->penguins[0], (Coords){ 5, 0 });
+  bitboard_load_game(bot->bitboard, game);
+  munit_assert_false(bot_solve_endgame(bot, &penguin, &target));
+  bot_state_free(bot);
+  game_free(game);
+  return MUNIT_OK;
+}
+
+static MunitResult test_simulation(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  BotParameters players[3];
+  for (int i = 0; i < 3; i++) {
+    init_bot_parameters(&players[i]);
+    players[i].placement_strategy = BOT_PLACEMENT_RANDOM;
+    players[i].movement_strategy = BOT_MOVEMENT_RANDOM;
+  }
+  players[0].placement_strategy = BOT_PLACEMENT_MOST_FISH;
+  players[0].movement_strategy = BOT_MOVEMENT_SMART;
+  players[0].recursion_limit = 1;
+
+  SimulationParams sim;
+  // Rounded up to two rotations of the seats.
+  sim.games_count = 5;
+  sim.threads_count = 2;
+  sim.board_width = 8;
+  sim.board_height = 8;
+  sim.board_type = SIMULATION_BOARD_RANDOM;
+  sim.penguins_per_player = 2;
+  sim.players_count = 3;
+  sim.players = players;
+  sim.seed = 42;
+  SimulationStats* stats = run_simulation(&sim);
+
+  munit_assert_int(stats->games_count, ==, 6);
+  int wins = 0, draws = 0;
+  int64_t moves_count = 0;
+  for (int i = 0; i < 3; i++) {
+    const SimulationPlayerStats* player = &stats->players[i];
+    wins += player->wins, draws += player->draws;
+    moves_count += player->moves_count;
+    munit_assert_int64(player->moves_count, >, 0);
+  }
+  // Every game has either a single winner or at least two players sharing
+  // the first place.
+  munit_assert_int(wins, <=, stats->games_count);
+  munit_assert_int(wins + draws / 2, >=, stats->games_count);
+  munit_assert_int64(stats->moves_count, ==, moves_count);
+  simulation_stats_free(stats);
+  return MUNIT_OK;
+}
+
+static MunitResult test_rng(const MunitParameter* params, void* data) {
+  UNUSED(params), UNUSED(data);
+  Rng rng = init_rng(1234), same_rng = init_rng(1234), other_rng = init_rng(1235);
+  bool differs = false;
+  int counts[7] = { 0 };
+  for (int i = 0; i < 7000; i++) {
+    int value = rng.random_range(&rng, -3, 3);
+    munit_assert_int(value, ==, same_rng.random_range(&same_rng, -3, 3));
+    if (value != other_rng.random_range(&other_rng, -3, 3)) differs = true;
+    munit_assert_int(value, >=, -3);
+    munit_assert_int(value, <=, 3);
+    counts[value + 3] += 1;
+  }
+  munit_assert_true(differs);
+  // Every value is generated, and roughly equally often.
+  for (int i = 0; i < 7; i++) {
+    munit_assert_int(counts[i], >, 800);
+    munit_assert_int(counts[i], <, 1200);
+  }
+  munit_assert_int(rng.random_range(&rng, 5, 5), ==, 5);
+  // The full range of int doesn't overflow.
+  rng.random_range(&rng, INT_MIN, INT_MAX);
+  munit_assert_int(rng.random_range(&rng, INT_MAX - 1, INT_MAX), >=, INT_MAX - 1);
+  munit_assert_int(rng.random_range(&rng, INT_MIN, INT_MIN + 1), <=, INT_MIN + 1);
+  return MUNIT_OK;
+}
+
 static MunitTest board_suite_tests[] = {
   {
     .name = "/cloning the Game produces a deep copy",
@@ -240,6 +1650,214 @@ static MunitTest board_suite_tests[] = {
     .options = MUNIT_TEST_OPTION_NONE,
     .parameters = NULL,
   },
+  {
+    .name = "/the bitboard representation agrees with the board of the game",
+    .test = test_bitboard_matches_game,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the bit-parallel flood fill agrees with the span filling algorithm",
+    .test = test_bitboard_flood_fill,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the specialized span fill agrees with the generic one",
+    .test = test_specialized_flood_fill,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/benchmark: the generic span fill",
+    .test = bench_generic_flood_fill,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/benchmark: the specialized span fill",
+    .test = bench_specialized_flood_fill,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the region map stays in sync with the board during the moves and undos",
+    .test = test_region_map_is_incremental,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the junction analysis finds the tiles which split the regions",
+    .test = test_junctions_find_cut_tiles,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/all placements are rated at once and incrementally the same way as one by one",
+    .test = test_rate_all_placements,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the placements are looked up in the opening book in any orientation of the board",
+    .test = test_placement_book,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the first of the book entries with the same key is kept",
+    .test = test_placement_book_merge,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the zobrist key is kept up to date incrementally",
+    .test = test_zobrist_key_is_incremental,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the lengths of the rays are kept up to date incrementally",
+    .test = test_tile_rays_are_incremental,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the placeable tiles and the mobile penguins are counted incrementally",
+    .test = test_turn_counters_are_incremental,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the search position makes and unmakes the moves like the game",
+    .test = test_search_position,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the transposition table prefers deeper and newer entries",
+    .test = test_transposition_table_replacement,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the adversarial search finds the best move and restores the game",
+    .test = test_adversarial_search,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the bot stops searching when its time runs out",
+    .test = test_bot_time_limit,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the bot can be cancelled from another thread at any depth of the search",
+    .test = test_bot_cancellation,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the searches of the bot don't allocate memory once the stack is prepared",
+    .test = test_bot_search_stack,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the bot picks the same move on any number of threads",
+    .test = test_bot_threads,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/a bot state can be reused across the turns of a whole game",
+    .test = test_bot_state_reuse,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the Monte Carlo Tree Search picks a valid move on any number of threads",
+    .test = test_mcts_search,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the Monte Carlo Tree Search survives racing for a single move on 8 threads",
+    .test = test_mcts_single_move,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the endgame solver finds the longest path through an isolated region",
+    .test = test_endgame_solver,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the simulator plays whole games between the bots",
+    .test = test_simulation,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
+  {
+    .name = "/the random number generator is reproducible and uniform",
+    .test = test_rng,
+    .setup = NULL,
+    .tear_down = NULL,
+    .options = MUNIT_TEST_OPTION_NONE,
+    .parameters = NULL,
+  },
   // Marker of the end of the array, don't touch.
   { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
 };
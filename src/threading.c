@@ -0,0 +1,76 @@
+#include "threading.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+static DWORD WINAPI thread_trampoline(LPVOID arg) {
+  Thread* self = arg;
+  self->func(self->arg);
+  return 0;
+}
+#else
+static void* thread_trampoline(void* arg) {
+  Thread* self = arg;
+  self->func(self->arg);
+  return NULL;
+}
+#endif
+
+/// @relatesalso Thread
+/// @brief Starts a new thread which calls <tt>func(arg)</tt>. The #Thread
+/// struct must stay alive (and not be moved) until #thread_join is called.
+/// @returns @c false if the OS failed to create the thread.
+bool thread_spawn(Thread* self, void (*func)(void* arg), void* arg) {
+  self->func = func;
+  self->arg = arg;
+#ifdef _WIN32
+  self->handle = CreateThread(NULL, 0, &thread_trampoline, self, 0, NULL);
+  return self->handle != NULL;
+#else
+  return pthread_create(&self->handle, NULL, &thread_trampoline, self) == 0;
+#endif
+}
+
+/// @relatesalso Thread
+/// @brief Waits for a thread started by #thread_spawn to finish and releases
+/// its resources.
+void thread_join(Thread* self) {
+#ifdef _WIN32
+  WaitForSingleObject(self->handle, INFINITE);
+  CloseHandle(self->handle);
+  self->handle = NULL;
+#else
+  pthread_join(self->handle, NULL);
+#endif
+}
+
+/// @brief Returns the number of logical processors available in the system,
+/// at least 1.
+int get_cpu_count(void) {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  int count = (int)info.dwNumberOfProcessors;
+#else
+  int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  return count > 0 ? count : 1;
+}
+
+extern int atomic_fetch_add_int(volatile int* ptr, int value);
+extern int atomic_load_int(const volatile int* ptr);
+extern void atomic_store_int(volatile int* ptr, int value);
+extern bool atomic_cas_int(volatile int* ptr, int expected, int desired);
+extern int64_t atomic_fetch_add_int64(volatile int64_t* ptr, int64_t value);
+extern int64_t atomic_load_int64(const volatile int64_t* ptr);
+extern uint64_t atomic_load_u64_relaxed(const volatile uint64_t* ptr);
+extern void atomic_store_u64_relaxed(volatile uint64_t* ptr, uint64_t value);
@@ -0,0 +1,151 @@
+#pragma once
+
+/// @file
+/// @brief A minimal portable wrapper around the OS threads and atomics
+///
+/// The C99 standard has no notion of threads whatsoever (C11 has @c
+/// \<threads.h\> and @c \<stdatomic.h\>, but MSVC has been taking its time to
+/// support them), so the bot uses this small abstraction over pthreads and
+/// the Win32 API, plus the compiler builtins for the atomic operations.
+
+#include "utils.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief A handle of a thread started by #thread_spawn.
+typedef struct Thread {
+#ifdef _WIN32
+  /// A @c HANDLE, @c windows.h is not included here to not pollute everything.
+  void* handle;
+#else
+  pthread_t handle;
+#endif
+  /// The entry point of the thread.
+  void (*func)(void* arg);
+  /// The argument for #func.
+  void* arg;
+} Thread;
+
+bool thread_spawn(Thread* self, void (*func)(void* arg), void* arg);
+void thread_join(Thread* self);
+int get_cpu_count(void);
+
+/// @name Atomics
+/// @brief Atomic operations, sequentially-consistent unless noted otherwise.
+/// @{
+
+/// @brief Atomically adds @c value to the integer at @c ptr.
+/// @returns The previous value.
+inline ALWAYS_INLINE int atomic_fetch_add_int(volatile int* ptr, int value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST);
+#elif defined(_MSC_VER)
+  return (int)_InterlockedExchangeAdd((volatile long*)ptr, (long)value);
+#else
+#error "Atomics are not implemented for this compiler"
+#endif
+}
+
+/// @brief Atomically loads an integer.
+inline ALWAYS_INLINE int atomic_load_int(const volatile int* ptr) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+#elif defined(_MSC_VER)
+  return (int)_InterlockedOr((volatile long*)ptr, 0);
+#else
+#error "Atomics are not implemented for this compiler"
+#endif
+}
+
+/// @brief Atomically stores an integer.
+inline ALWAYS_INLINE void atomic_store_int(volatile int* ptr, int value) {
+#if defined(__GNUC__) || defined(__clang__)
+  __atomic_store_n(ptr, value, __ATOMIC_SEQ_CST);
+#elif defined(_MSC_VER)
+  _InterlockedExchange((volatile long*)ptr, (long)value);
+#else
+#error "Atomics are not implemented for this compiler"
+#endif
+}
+
+/// @brief Atomically replaces the integer at @c ptr with @c desired if it is
+/// equal to @c expected (the compare-and-swap operation).
+/// @returns @c true if the value was replaced.
+inline ALWAYS_INLINE bool atomic_cas_int(volatile int* ptr, int expected, int desired) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __atomic_compare_exchange_n(
+    ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST
+  );
+#elif defined(_MSC_VER)
+  return _InterlockedCompareExchange((volatile long*)ptr, (long)desired, (long)expected) ==
+         (long)expected;
+#else
+#error "Atomics are not implemented for this compiler"
+#endif
+}
+
+/// @brief Atomically adds @c value to the 64-bit integer at @c ptr.
+/// @returns The previous value.
+inline ALWAYS_INLINE int64_t atomic_fetch_add_int64(volatile int64_t* ptr, int64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST);
+#elif defined(_MSC_VER)
+  return (int64_t)_InterlockedExchangeAdd64((volatile __int64*)ptr, (__int64)value);
+#else
+#error "Atomics are not implemented for this compiler"
+#endif
+}
+
+/// @brief Atomically loads a 64-bit integer.
+inline ALWAYS_INLINE int64_t atomic_load_int64(const volatile int64_t* ptr) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+#elif defined(_MSC_VER)
+  return (int64_t)_InterlockedCompareExchange64((volatile __int64*)ptr, 0, 0);
+#else
+#error "Atomics are not implemented for this compiler"
+#endif
+}
+
+/// @brief Atomically loads a 64-bit value without any ordering guarantees
+/// (that is, with the relaxed memory order).
+inline ALWAYS_INLINE uint64_t atomic_load_u64_relaxed(const volatile uint64_t* ptr) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __atomic_load_n(ptr, __ATOMIC_RELAXED);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  // Aligned 64-bit accesses are atomic on x86-64 anyway.
+  return *ptr;
+#elif defined(_MSC_VER)
+  return (uint64_t)_InterlockedCompareExchange64((volatile __int64*)ptr, 0, 0);
+#else
+#error "Atomics are not implemented for this compiler"
+#endif
+}
+
+/// @brief Atomically stores a 64-bit value with the relaxed memory order, see
+/// #atomic_load_u64_relaxed.
+inline ALWAYS_INLINE void atomic_store_u64_relaxed(volatile uint64_t* ptr, uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  __atomic_store_n(ptr, value, __ATOMIC_RELAXED);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  *ptr = value;
+#elif defined(_MSC_VER)
+  _InterlockedExchange64((volatile __int64*)ptr, (__int64)value);
+#else
+#error "Atomics are not implemented for this compiler"
+#endif
+}
+
+/// @}
+
+#ifdef __cplusplus
+}
+#endif
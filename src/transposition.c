@@ -0,0 +1,56 @@
+#include "transposition.h"
+#include "utils.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/// @relatesalso TranspositionTable
+/// @brief Constructs an empty #TranspositionTable. The @c size (the number of
+/// entries, must be positive) is rounded down to a power of two.
+TranspositionTable* transposition_table_new(size_t size) {
+  assert(size > 0);
+  size_t rounded_size = 1;
+  while (rounded_size <= size / 2) rounded_size *= 2;
+  TranspositionTable* self = malloc(sizeof(*self));
+  self->mask = rounded_size - 1;
+  self->entries = malloc(sizeof(*self->entries) * rounded_size);
+  self->generation = 0;
+  transposition_table_clear(self);
+  return self;
+}
+
+/// @relatesalso TranspositionTable
+/// @brief Destroys a #TranspositionTable.
+void transposition_table_free(TranspositionTable* self) {
+  if (self == NULL) return;
+  free_and_clear(self->entries);
+  free(self);
+}
+
+/// @relatesalso TranspositionTable
+/// @brief Empties all entries of the table.
+void transposition_table_clear(TranspositionTable* self) {
+  for (size_t i = 0; i <= self->mask; i++) {
+    TranspositionEntry* entry = &self->entries[i];
+    entry->checked_key = 0;
+    entry->data = 0;
+  }
+}
+
+/// @relatesalso TranspositionTable
+/// @brief Marks the entries stored so far as stale, which lets the new entries
+/// replace them regardless of the depth. Should be called at the beginning of
+/// every new search.
+void transposition_table_next_generation(TranspositionTable* self) {
+  self->generation += 1;
+}
+
+extern size_t transposition_table_size(const TranspositionTable* self);
+extern bool transposition_table_probe(
+  const TranspositionTable* self, uint64_t key, int* out_score
+);
+extern void transposition_table_store(
+  TranspositionTable* self, uint64_t key, int depth, int score
+);
@@ -0,0 +1,111 @@
+#pragma once
+
+/// @file
+/// @brief The transposition table used by the bot for caching scores
+/// @see bot.h
+
+#include "threading.h"
+#include "utils.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief An entry of the #TranspositionTable.
+///
+/// The entries are shared between threads without any locks (see
+/// #TranspositionTable), so an entry consists of just two 64-bit words which
+/// are read and written atomically, one by one. The key is stored XORed with
+/// the data, this way if a thread reads the words of two different writes
+/// (when another thread overwrites the entry in between), the check of the key
+/// fails and such a torn entry is simply ignored.
+///
+/// @see <https://www.chessprogramming.org/Shared_Hash_Table#Lockless>
+typedef struct TranspositionEntry {
+  /// The full key of the position XORed with #data.
+  volatile uint64_t checked_key;
+  /// @brief The packed contents of the entry: the score in the lowest 32 bits,
+  /// the depth plus one in the next 16 bits (zero for empty entries) and the
+  /// generation in the highest 16 bits.
+  volatile uint64_t data;
+} TranspositionEntry;
+
+/// @brief A fixed-size hash table of scores of the previously evaluated
+/// positions.
+///
+/// The table is indexed by the lowest bits of the key (hence the size is
+/// always a power of two) and every slot holds a single entry. When two keys
+/// compete for the same slot, the entry which took more work to compute (the
+/// one with the greater depth) wins, unless it was stored during an older
+/// #generation, in which case it is considered stale and is always replaced.
+/// The entries are not invalidated between the generations though, their
+/// keys describe the positions completely, so the old scores remain correct
+/// and can still be hit.
+///
+/// The table may be probed and updated from multiple threads at the same time,
+/// see #TranspositionEntry. Since the entries are only ever replaced as a
+/// whole, a concurrent store can at worst cause a cached score to be lost.
+///
+/// @see <https://www.chessprogramming.org/Transposition_Table>
+/// @see <https://www.chessprogramming.org/Replacement_Strategies>
+typedef struct TranspositionTable {
+  /// The number of entries minus one, used for masking the keys.
+  size_t mask;
+  TranspositionEntry* entries;
+  /// See #transposition_table_next_generation.
+  unsigned short generation;
+} TranspositionTable;
+
+TranspositionTable* transposition_table_new(size_t size);
+void transposition_table_free(TranspositionTable* self);
+void transposition_table_clear(TranspositionTable* self);
+void transposition_table_next_generation(TranspositionTable* self);
+
+/// @relatesalso TranspositionTable
+/// @brief Returns the number of entries in the table.
+inline size_t transposition_table_size(const TranspositionTable* self) {
+  return self->mask + 1;
+}
+
+/// @relatesalso TranspositionTable
+/// @brief Looks up the score stored under the given @c key.
+/// @returns @c true and writes the score to @c out_score if found.
+inline ALWAYS_INLINE bool transposition_table_probe(
+  const TranspositionTable* self, uint64_t key, int* out_score
+) {
+  const TranspositionEntry* entry = &self->entries[key & self->mask];
+  uint64_t data = atomic_load_u64_relaxed(&entry->data);
+  uint64_t checked_key = atomic_load_u64_relaxed(&entry->checked_key);
+  if ((data >> 32 & 0xFFFF) != 0 && (checked_key ^ data) == key) {
+    *out_score = (int)(uint32_t)data;
+    return true;
+  }
+  return false;
+}
+
+/// @relatesalso TranspositionTable
+/// @brief Stores a score according to the replacement policy described in
+/// #TranspositionTable.
+inline ALWAYS_INLINE void transposition_table_store(
+  TranspositionTable* self, uint64_t key, int depth, int score
+) {
+  TranspositionEntry* entry = &self->entries[key & self->mask];
+  uint64_t old_data = atomic_load_u64_relaxed(&entry->data);
+  uint64_t old_key = atomic_load_u64_relaxed(&entry->checked_key) ^ old_data;
+  int old_depth = (int)(old_data >> 32 & 0xFFFF) - 1;
+  unsigned short old_generation = (unsigned short)(old_data >> 48);
+  if (old_depth < 0 || old_generation != self->generation || old_key == key ||
+      depth >= old_depth) {
+    uint64_t data = (uint64_t)self->generation << 48 | (uint64_t)(uint16_t)(depth + 1) << 32 |
+                    (uint32_t)score;
+    atomic_store_u64_relaxed(&entry->data, data);
+    atomic_store_u64_relaxed(&entry->checked_key, key ^ data);
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -40,6 +40,9 @@ const Neighbor DIRECTION_TO_NEIGHBOR[DIRECTION_MAX] = {
 };
 
 extern bool coords_same(Coords a, Coords b);
+extern int popcount64(uint64_t x);
+extern int ctz64(uint64_t x);
+extern int clz64(uint64_t x);
 
 /// @brief Returns a substring with the prefix removed if the given string
 /// starts with the prefix, otherwise returns @c NULL.
@@ -83,48 +86,115 @@ void* memdup(const void* src, size_t size) {
   return dest;
 }
 
-// Taken from <https://cplusplus.com/faq/beginners/random-numbers/#seeding>.
-static void random_init(void) {
+/// @brief Returns the time in milliseconds of a monotonic clock, which is not
+/// affected by the changes of the system time. Only the differences between
+/// the returned values are meaningful.
+uint64_t get_monotonic_time_ms(void) {
+#ifdef _WIN32
+  return (uint64_t)GetTickCount64();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+#endif
+}
+
+/// @brief The same as #get_monotonic_time_ms, but in microseconds, for timing
+/// the operations which are much shorter than a millisecond.
+uint64_t get_monotonic_time_us(void) {
+#ifdef _WIN32
+  LARGE_INTEGER counter, frequency;
+  QueryPerformanceCounter(&counter);
+  QueryPerformanceFrequency(&frequency);
+  return (uint64_t)(counter.QuadPart / frequency.QuadPart * 1000000 +
+                    counter.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+#endif
+}
+
+/// @relatesalso Rng
+/// @brief Returns a seed for #init_rng derived from the current time (and
+/// the address of the stack, so that the threads starting at the same moment
+/// get different seeds).
+uint64_t generate_random_seed(void) {
 #ifdef _WIN32
   FILETIME t;
   ULARGE_INTEGER i;
   GetSystemTimeAsFileTime(&t);
   i.u.LowPart = t.dwLowDateTime;
   i.u.HighPart = t.dwHighDateTime;
-  ULONGLONG seed = i.QuadPart / 1000;
+  uint64_t seed = (uint64_t)i.QuadPart;
 #else
-  struct timespec ts, res;
-  clock_getres(CLOCK_REALTIME, &res);
+  struct timespec ts;
   clock_gettime(CLOCK_REALTIME, &ts);
-  unsigned long seed = ts.tv_nsec / res.tv_nsec;
+  uint64_t seed = (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
 #endif
-  srand((unsigned int)seed);
+  return splitmix64_mix(seed) ^ (uint64_t)(uintptr_t)&seed;
 }
 
-// Taken from <https://cplusplus.com/faq/beginners/random-numbers/#random_int_in_range>.
-static int random_range(Rng* rng, int min, int max) {
-  UNUSED(rng);
-  assert(min <= max);
-  unsigned int n = (max - min <= RAND_MAX) ? (max - min + 1U) : (RAND_MAX + 1U);
-  unsigned int x = (RAND_MAX + 1U) / n;
-  unsigned int y = x * n;
-  unsigned int r;
-  do {
-    r = rand();
-  } while (r >= y);
-  return r / x + min;
+/// @relatesalso Rng
+/// @brief Advances the generator of #init_rng and returns 32 random bits.
+///
+/// This is the PCG32 generator (the XSH-RR variant): a 64-bit LCG whose
+/// state is scrambled into the output with a xorshift and a random rotation.
+///
+/// @see <https://www.pcg-random.org/download.html>
+uint32_t rng_next_u32(Rng* self) {
+  uint64_t old_state = self->state;
+  self->state = old_state * UINT64_C(6364136223846793005) + self->inc;
+  uint32_t xorshifted = (uint32_t)(((old_state >> 18) ^ old_state) >> 27);
+  uint32_t rot = (uint32_t)(old_state >> 59);
+  return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
 }
 
-/// @brief Returns an RNG implementation based on the @c rand function from @c
-/// \<stdlib.h\> (and seeds it with @c srand).
+/// @relatesalso Rng
+/// @brief The #Rng::random_range of #init_rng.
 ///
-/// @warning It is probably not thread-safe though... Then again, it's not like
-/// we are using threads in the C program.
-Rng init_stdlib_rng(void) {
-  random_init();
+/// Maps the random bits into the range by multiplying them by the size of
+/// the range and taking the upper half of the product, see
+/// <https://arxiv.org/abs/1805.10941>. The few values which would make some
+/// results more likely than others are rejected, but the expensive division
+/// needed for finding them is only done in the rare case when the lower half
+/// of the product is small enough to possibly be one of them.
+static int rng_random_range(Rng* self, int min, int max) {
+  assert(min <= max);
+  // Zero means the full range of 2^32 values.
+  uint32_t range = (uint32_t)max - (uint32_t)min + 1;
+  if (range == 0) return (int)rng_next_u32(self);
+  uint64_t product = (uint64_t)rng_next_u32(self) * range;
+  if ((uint32_t)product < range) {
+    uint32_t threshold = -range % range;
+    while ((uint32_t)product < threshold) {
+      product = (uint64_t)rng_next_u32(self) * range;
+    }
+  }
+  return (int)((uint32_t)min + (uint32_t)(product >> 32));
+}
+
+/// @relatesalso Rng
+/// @brief Returns the default #Rng implementation: a PCG32 generator seeded
+/// with @c seed. The same seed always produces the same sequence.
+Rng init_rng(uint64_t seed) {
   Rng rng;
-  rng.random_range = &random_range;
+  rng.random_range = &rng_random_range;
+  // The initialization routine of the reference implementation, with the
+  // stream also derived from the seed.
+  rng.state = 0;
+  rng.inc = splitmix64_mix(seed) << 1 | 1;
+  rng_next_u32(&rng);
+  rng.state += seed;
+  rng_next_u32(&rng);
   return rng;
 }
 
+/// @relatesalso Rng
+/// @brief A shorthand for #init_rng with #generate_random_seed.
+Rng init_random_rng(void) {
+  return init_rng(generate_random_seed());
+}
+
 extern uint32_t fnv32_hash(uint32_t state, const void* buf, size_t len);
+extern uint64_t splitmix64_mix(uint64_t x);
@@ -7,6 +7,10 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -109,30 +113,104 @@ inline bool coords_same(Coords a, Coords b) {
 #define test_bit(num, bit) (((num) & (bit)) != 0)
 /// @}
 
+/// @name Bit manipulation intrinsics
+/// Wrappers around the compiler-specific builtins for counting bits in 64-bit
+/// words, with portable fallbacks for other compilers. The @c ctz and @c clz
+/// variants return 64 for a zero word.
+/// @see <https://gcc.gnu.org/onlinedocs/gcc/Other-Builtins.html>
+/// @see <https://learn.microsoft.com/en-us/cpp/intrinsics/bitscanforward-bitscanforward64?view=msvc-170>
+/// @{
+
+/// Counts the number of set bits in a word.
+inline ALWAYS_INLINE int popcount64(uint64_t x) {
+#if defined(__GNUC__)
+  return __builtin_popcountll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  return (int)__popcnt64(x);
+#else
+  // <https://en.wikipedia.org/wiki/Hamming_weight#Efficient_implementation>
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return (int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/// Counts the number of trailing (least significant) zero bits in a word.
+inline ALWAYS_INLINE int ctz64(uint64_t x) {
+  if (x == 0) return 64;
+#if defined(__GNUC__)
+  return __builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  unsigned long idx;
+  _BitScanForward64(&idx, x);
+  return (int)idx;
+#else
+  int n = 0;
+  while (!(x & 1)) x >>= 1, n++;
+  return n;
+#endif
+}
+
+/// Counts the number of leading (most significant) zero bits in a word.
+inline ALWAYS_INLINE int clz64(uint64_t x) {
+  if (x == 0) return 64;
+#if defined(__GNUC__)
+  return __builtin_clzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  unsigned long idx;
+  _BitScanReverse64(&idx, x);
+  return 63 - (int)idx;
+#else
+  int n = 0;
+  while (!(x & ((uint64_t)1 << 63))) x <<= 1, n++;
+  return n;
+#endif
+}
+
+/// @}
+
 const char* strip_prefix(const char* str, const char* prefix);
 
 bool parse_number(const char* str, long* result);
 
 void* memdup(const void* src, size_t size);
 
+uint64_t get_monotonic_time_ms(void);
+
+uint64_t get_monotonic_time_us(void);
+
 /// @brief A wrapper around random number generators.
 ///
 /// We need this to abstract away the different implementations of randomness
 /// under different environments:
 ///
-/// 1. The TUI and the CLI use the @c rand function from the standard C library.
-/// 2. The GUI has #BetterRng which wraps the standard C++ functions from @c \<random\>.
-/// 3. The test suite calls @c munit_rand_int_range (see <https://nemequ.github.io/munit/#prng>).
+/// 1. The TUI, the CLI and the test suite use the PCG32 generator created by
+///    #init_rng, which keeps its state right in this struct.
+/// 2. The GUI has #BetterRng which seeds the same generator from @c
+///    std::random_device.
 ///
 /// The struct itself provides pointers to the actual functions of randomness
 /// implementations, so it works kind of like an interface in OOP terminology.
+///
+/// Every instance has its own state, unlike the @c rand function, so the
+/// threads don't have to share (and fight over) a single generator, and a
+/// run can be reproduced by passing the same seed to #init_rng.
 typedef struct Rng {
-  /// @brief Generates and returns a value in the range <tt>[min; max)</tt>
-  /// (i.e. from @c min inclusive to @c max exclusive).
+  /// @brief Generates and returns a value in the range <tt>[min; max]</tt>
+  /// (i.e. from @c min to @c max, both inclusive).
   int (*random_range)(struct Rng* self, int min, int max);
+  /// The state of the generator of #init_rng.
+  uint64_t state;
+  /// @brief The increment of the generator of #init_rng, always odd, selects
+  /// one of its 2^63 streams.
+  uint64_t inc;
 } Rng;
 
-Rng init_stdlib_rng(void);
+Rng init_rng(uint64_t seed);
+Rng init_random_rng(void);
+uint64_t generate_random_seed(void);
+uint32_t rng_next_u32(Rng* self);
 
 /// A constant for #fnv32_hash.
 #define FNV32_INITIAL_STATE ((uint32_t)2166136261)
@@ -155,6 +233,21 @@ inline uint32_t fnv32_hash(uint32_t state, const void* buf, size_t len) {
   return state;
 }
 
+/// @brief Scrambles the bits of a 64-bit number, the finalizer of the
+/// SplitMix64 generator.
+///
+/// Every input is mapped to a unique output and inputs which differ by a
+/// single bit produce completely different outputs, so this works well for
+/// deriving pseudo-random keys from small integers.
+///
+/// @see <https://prng.di.unimi.it/splitmix64.c>
+inline uint64_t splitmix64_mix(uint64_t x) {
+  x ^= x >> 30, x *= UINT64_C(0xBF58476D1CE4E5B9);
+  x ^= x >> 27, x *= UINT64_C(0x94D049BB133111EB);
+  x ^= x >> 31;
+  return x;
+}
+
 #ifdef __cplusplus
 }
 #endif